@@ -0,0 +1,405 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file flightLog.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief in-process flight logger, fixed-size binary records in a memory-mapped ring file
+ */
+
+#ifndef FLIGHTLOG_HPP
+#define FLIGHTLOG_HPP
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace alan
+{
+    const int LOG_FIELDS_MAX = 20;
+    const int LOG_STREAMS_MAX = 8;
+    const int LOG_NAME_MAX = 32;
+    const uint32_t LOG_VERSION = 1;
+    const uint64_t LOG_MAGIC = 0x31474f4c4e414c41ULL;    // "ALANLOG1"
+    const size_t LOG_DATA_OFFSET = 8192;                // header, page aligned
+
+    // one sample of one stream
+    typedef struct logRecord
+    {
+        uint64_t seq;       // write order from 1, 0 while empty or being written
+        uint32_t stream;
+        uint32_t n;
+        double t;
+        double v[LOG_FIELDS_MAX];
+        uint64_t reserved;
+    }logRecord;
+
+    typedef struct logStream
+    {
+        char name[LOG_NAME_MAX];
+        uint32_t n;
+        uint32_t reserved;
+        char fields[LOG_FIELDS_MAX][LOG_NAME_MAX];
+    }logStream;
+
+    typedef struct logHeader
+    {
+        uint64_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t capacity;  // records in the ring
+        uint64_t written;   // records handed out, as of the last flush
+        uint32_t stream_no;
+        uint32_t reserved;
+        logStream streams[LOG_STREAMS_MAX];
+    }logHeader;
+
+    static_assert(sizeof(logRecord) == 192, "logRecord layout changed, bump LOG_VERSION");
+    static_assert(sizeof(logHeader) <= LOG_DATA_OFFSET, "logHeader does not fit in front of the ring");
+
+    /* write() copies one record into the mapping, no syscall, no formatting,
+    safe from several threads. the ring keeps the newest capacity records.
+    the flusher thread msync()s what was written every flush period, so a crash
+    of the process loses nothing and a power cut at most one period.
+    the file is read back by flightLogReader, see tools/flight_log_export.cpp */
+    class flightLog
+    {
+    private:
+        int fd = -1;
+        char* base = nullptr;
+        size_t file_size = 0;
+        logHeader* header = nullptr;
+        logRecord* records = nullptr;
+        uint64_t capacity = 0;
+
+        std::vector<logStream> streams;
+        std::atomic<uint64_t> next{0};
+
+        double flush_period = 1.0;
+        uint64_t flushed = 0;
+        std::thread flush_thread;
+        std::mutex flush_mutex;
+        std::condition_variable flush_cv;
+        bool flush_running = false;
+
+        static inline void copyName(char* dst, const std::string& src)
+        {
+            std::strncpy(dst, src.c_str(), LOG_NAME_MAX - 1);
+            dst[LOG_NAME_MAX - 1] = '\0';
+        }
+
+        // page-aligned msync over records [from, to) of the ring
+        inline void syncRange(uint64_t from, uint64_t to, int flags)
+        {
+            if(to <= from)
+                return;
+
+            if(to - from >= capacity)
+            {
+                msync(base, file_size, flags);
+                return;
+            }
+
+            const size_t page = sysconf(_SC_PAGESIZE);
+            auto sync_slots = [&](uint64_t a, uint64_t b)
+            {
+                size_t begin = LOG_DATA_OFFSET + a * sizeof(logRecord);
+                size_t end = LOG_DATA_OFFSET + b * sizeof(logRecord);
+                begin = begin / page * page;
+                msync(base + begin, end - begin, flags);
+            };
+
+            uint64_t a = from % capacity, b = to % capacity;
+            if(a < b)
+                sync_slots(a, b);
+            else
+            {
+                sync_slots(a, capacity);
+                sync_slots(0, b);
+            }
+        }
+
+        inline void flush(int flags)
+        {
+            uint64_t to = next.load(std::memory_order_acquire);
+            syncRange(flushed, to, flags);
+
+            header->written = to;
+            msync(base, LOG_DATA_OFFSET, flags);
+            flushed = to;
+        }
+
+        inline void flush_loop()
+        {
+            std::unique_lock<std::mutex> lock(flush_mutex);
+            while(flush_running)
+            {
+                flush_cv.wait_for(lock, std::chrono::duration<double>(flush_period));
+                if(!flush_running)
+                    break;
+
+                lock.unlock();
+                flush(MS_SYNC);
+                lock.lock();
+            }
+        }
+
+    public:
+        flightLog(){};
+        ~flightLog(){close();};
+
+        flightLog(const flightLog&) = delete;
+        flightLog& operator=(const flightLog&) = delete;
+
+        // before open(), -1 if there is no room left
+        inline int addStream(const std::string& name, const std::vector<std::string>& fields)
+        {
+            if(base || streams.size() >= LOG_STREAMS_MAX || fields.size() > LOG_FIELDS_MAX)
+                return -1;
+
+            logStream stream;
+            std::memset(&stream, 0, sizeof(stream));
+            copyName(stream.name, name);
+            stream.n = fields.size();
+            for(size_t i = 0; i < fields.size(); i++)
+                copyName(stream.fields[i], fields[i]);
+
+            streams.push_back(stream);
+            return streams.size() - 1;
+        }
+
+        // preallocates header + capacity records, an existing file is replaced
+        inline bool open(const std::string& path, uint64_t capacity_, double flush_period_ = 1.0)
+        {
+            if(base || capacity_ == 0)
+                return false;
+
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            if(fd < 0)
+                return false;
+
+            capacity = capacity_;
+            file_size = LOG_DATA_OFFSET + capacity * sizeof(logRecord);
+
+            // reserve the blocks now, a full disk fails here and not mid-flight
+            if(posix_fallocate(fd, 0, file_size) != 0 && ftruncate(fd, file_size) != 0)
+            {
+                ::close(fd);
+                fd = -1;
+                return false;
+            }
+
+            void* mapped = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(mapped == MAP_FAILED)
+            {
+                ::close(fd);
+                fd = -1;
+                return false;
+            }
+
+            base = static_cast<char*>(mapped);
+            header = reinterpret_cast<logHeader*>(base);
+            records = reinterpret_cast<logRecord*>(base + LOG_DATA_OFFSET);
+
+            std::memset(header, 0, sizeof(logHeader));
+            header->magic = LOG_MAGIC;
+            header->version = LOG_VERSION;
+            header->record_size = sizeof(logRecord);
+            header->capacity = capacity;
+            header->stream_no = streams.size();
+            std::copy(streams.begin(), streams.end(), header->streams);
+
+            next = 0;
+            flushed = 0;
+            flush(MS_SYNC);
+
+            flush_period = flush_period_;
+            flush_running = true;
+            flush_thread = std::thread(&flightLog::flush_loop, this);
+
+            return true;
+        }
+
+        inline bool isOpen() const {return base != nullptr;};
+
+        inline bool write(int stream, double t, const double* v, int n)
+        {
+            if(!base || stream < 0 || stream >= (int)streams.size())
+                return false;
+
+            const uint64_t idx = next.fetch_add(1, std::memory_order_relaxed);
+            logRecord& record = records[idx % capacity];
+
+            // readers take seq == 0 as a torn record
+            record.seq = 0;
+            std::atomic_thread_fence(std::memory_order_release);
+
+            record.stream = stream;
+            record.n = std::min<int>(n, streams[stream].n);
+            record.t = t;
+            std::memcpy(record.v, v, record.n * sizeof(double));
+
+            std::atomic_thread_fence(std::memory_order_release);
+            record.seq = idx + 1;
+
+            return true;
+        }
+
+        inline bool write(int stream, double t, std::initializer_list<double> v)
+        {
+            return write(stream, t, v.begin(), v.size());
+        }
+
+        inline void close()
+        {
+            if(!base)
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex);
+                flush_running = false;
+            }
+            flush_cv.notify_all();
+            if(flush_thread.joinable())
+                flush_thread.join();
+
+            flush(MS_SYNC);
+
+            munmap(base, file_size);
+            ::close(fd);
+
+            base = nullptr;
+            header = nullptr;
+            records = nullptr;
+            fd = -1;
+        }
+    };
+
+    // read-only view of a flightLog file, records in write order
+    class flightLogReader
+    {
+    private:
+        int fd = -1;
+        const char* base = nullptr;
+        size_t file_size = 0;
+
+    public:
+        const logHeader* header = nullptr;
+        std::vector<const logRecord*> records;
+        uint64_t torn_no = 0;
+
+        flightLogReader(){};
+        ~flightLogReader()
+        {
+            if(base)
+                munmap(const_cast<char*>(base), file_size);
+            if(fd >= 0)
+                ::close(fd);
+        };
+
+        flightLogReader(const flightLogReader&) = delete;
+        flightLogReader& operator=(const flightLogReader&) = delete;
+
+        inline bool load(const std::string& path, std::string& error)
+        {
+            fd = ::open(path.c_str(), O_RDONLY);
+            if(fd < 0)
+            {
+                error = "cannot open " + path;
+                return false;
+            }
+
+            struct stat st;
+            if(fstat(fd, &st) != 0 || (size_t)st.st_size < LOG_DATA_OFFSET)
+            {
+                error = "too short for a flight log";
+                return false;
+            }
+
+            file_size = st.st_size;
+            void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+            if(mapped == MAP_FAILED)
+            {
+                error = "mmap failed";
+                return false;
+            }
+            base = static_cast<const char*>(mapped);
+            header = reinterpret_cast<const logHeader*>(base);
+
+            if(header->magic != LOG_MAGIC)
+            {
+                error = "not a flight log";
+                return false;
+            }
+            if(header->version != LOG_VERSION || header->record_size != sizeof(logRecord))
+            {
+                error = "flight log version " + std::to_string(header->version)
+                    + ", this build reads " + std::to_string(LOG_VERSION);
+                return false;
+            }
+            if(header->stream_no > LOG_STREAMS_MAX
+                || LOG_DATA_OFFSET + header->capacity * sizeof(logRecord) > file_size)
+            {
+                error = "corrupt header";
+                return false;
+            }
+
+            // the header count may lag the ring by one flush period, seq is authoritative
+            const logRecord* ring = reinterpret_cast<const logRecord*>(base + LOG_DATA_OFFSET);
+            records.clear();
+            records.reserve(header->capacity);
+            torn_no = 0;
+            for(uint64_t i = 0; i < header->capacity; i++)
+            {
+                const logRecord& record = ring[i];
+                if(record.seq == 0)
+                    continue;
+
+                if(record.stream >= header->stream_no || record.n > LOG_FIELDS_MAX
+                    || (record.seq - 1) % header->capacity != i)
+                {
+                    torn_no++;
+                    continue;
+                }
+
+                records.push_back(&record);
+            }
+
+            std::sort(records.begin(), records.end(),
+                [](const logRecord* a, const logRecord* b){return a->seq < b->seq;});
+
+            return true;
+        }
+    };
+}
+
+#endif
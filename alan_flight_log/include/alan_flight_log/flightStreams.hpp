@@ -0,0 +1,55 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file flightStreams.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief flight log streams written by more than one node, one column layout for each
+ */
+
+#ifndef FLIGHTSTREAMS_HPP
+#define FLIGHTSTREAMS_HPP
+
+#include "flightLog.hpp"
+
+namespace alan
+{
+    /* the LED nodelet logs in-process, alan_visualization/data from the alan_log
+    topics; either file exports to the same csv. the columns are those of the csv
+    data used to write, names unique. write in this order. */
+
+    // x y z st_x st_y st_z roll pitch yaw ori ms dpth ugvx ugvy ugvz vx vy vz
+    inline int addLEDStream(flightLog& log)
+    {
+        return log.addStream("led", {
+            "x", "y", "z", "st_x", "st_y", "st_z", "roll", "pitch", "yaw", "ori", "ms", "dpth",
+            "ugvx", "ugvy", "ugvz", "vx", "vy", "vz"
+        });
+    }
+
+    // x y z roll pitch yaw ori ms dpth, ms & dpth are 0: alan_log on uav_log never sets them
+    inline int addUAVStream(flightLog& log)
+    {
+        return log.addStream("uav", {
+            "x", "y", "z", "roll", "pitch", "yaw", "ori", "ms", "dpth"
+        });
+    }
+}
+
+#endif
@@ -1583,6 +1583,7 @@ namespace alan_traj
         int MQM_final_cols = MQM_array.size() * MQM_array[0].cols();
 
         MQM_return.resize(MQM_final_rows, MQM_final_cols);
+        MQM_return.setZero();
 
         for(int i = 0; i < MQM_array.size(); i++)
             MQM_return.block(i * MQM_array[i].rows(), i * MQM_array[i].cols(), MQM_array[i].rows(), MQM_array[i].cols()) = MQM_array[i];
@@ -1717,6 +1718,240 @@ namespace alan_traj
         return Aieq_return;
     }
 
+    // set_1_MQMSample without the dense matrices
+    // block diagonal, one M^T * Q * M block per segment, the same for every axis
+    void bernstein::set_1_MQMTriplets(
+        int axis_dim, 
+        int n_order, 
+        int m, 
+        int d_order, 
+        std::vector<double> s,
+        std::vector<Eigen::Triplet<double>>& triplets
+    )
+    {
+        int _dim = (n_order + 1) * m;
+
+        triplets.clear();
+        triplets.reserve(axis_dim * m * (n_order + 1) * (n_order + 1));
+
+        setM1D(axis_dim, n_order);
+        Q_temp.resize(n_order + 1, n_order + 1);
+
+        std::vector<Eigen::MatrixXd> MQM_seg(m);
+
+        for(int t = 0; t < m; t++)
+        {
+            for(int i = 0; i < Q_temp.rows(); i++)
+            {
+                for(int j = 0; j < Q_temp.cols(); j++)
+                {
+                    if(i < 4 || j < 4)
+                        Q_temp(i, j) = 0;
+                    else
+                        Q_temp(i, j) = i * (i-1) * (i-2) * (i-3)
+                                    * j * (j-1) * (j-2) * (j-3)
+                                    * pow(s[t], (-2 * d_order + 3))  
+                                    / (i+j-7);
+                }
+            }
+
+            MQM_seg[t] = M_temp.transpose() * Q_temp * M_temp;
+        }
+
+        for(int axis_i = 0; axis_i < axis_dim; axis_i++)
+            for(int t = 0; t < m; t++)
+            {
+                int starto = axis_i * _dim + t * (n_order + 1);
+
+                for(int j = 0; j < n_order + 1; j++)
+                    for(int i = 0; i < n_order + 1; i++)
+                        triplets.emplace_back(starto + i, starto + j, MQM_seg[t](i, j));
+            }
+    }
+
+    // set_1_ASample without the dense matrices, rows in the same order:
+    // Aeq per axis, A_ieqsfc, Aieq dynamics per axis
+    // sets ub_ieqsfc & lb_ieqsfc as setAieqBieqsfc does
+    int bernstein::set_1_ATriplets(
+        int axis_dim, 
+        int n_order, 
+        int m, 
+        int d_order,  
+        std::vector<alan_visualization::Polyhedron>& sfc_list,
+        std::vector<double> s,
+        std::vector<Eigen::Triplet<double>>& triplets
+    )
+    {
+        int _dim = (n_order + 1) * m;
+        int row = 0;
+        std::vector<double> pascal;
+
+        triplets.clear();
+
+        if(axis_dim < 1 || axis_dim > 3)
+        {
+            ROS_ERROR("AXIS_DIM wrong, PLEASE CHECK!");
+            return 0;
+        }
+
+        if(d_order < 2 || d_order > 4)
+        {
+            ROS_ERROR("Something wrong with Aieq.\nPlease re-select d_order:\n\t2 for min. accl,\n\t 3 for min. jerk,\n\t 4 for min. snap\n");
+            return 0;
+        }
+
+        //Aeq, see setAeq1D
+        for(int axis_i = 0; axis_i < axis_dim; axis_i++)
+        {
+            int col = axis_i * _dim;
+
+            //start
+            for(int i = 0; i < d_order; i++, row++)
+            {
+                pascal = pascal_triangle(i + 1);
+                double p = permutation(n_order, n_order - i);
+
+                for(int j = 0; j < i + 1; j++)
+                    triplets.emplace_back(row, col + j, p * pascal[j] * pow(s[0], 1-i));
+            }
+
+            //end
+            for(int i = 0; i < d_order; i++, row++)
+            {
+                pascal = pascal_triangle(i + 1);
+                double p = permutation(n_order, n_order - i);
+
+                for(int j = 0; j < i + 1; j++)
+                    triplets.emplace_back(row, col + _dim-1 - j, p * pascal[j] * pow(s[s.size()-1], 1-i));
+            }
+
+            //continuity
+            for(int i = 0; i < m - 1; i++)
+            {
+                int starto_col = col + (n_order + 1) * (i + 1) - 1;
+
+                for(int j = 0; j < d_order; j++, row++)
+                {
+                    pascal = pascal_triangle(j + 1);
+                    double p = permutation(n_order, n_order - j);
+
+                    for(int k = 0; k < j + 1; k++)
+                        triplets.emplace_back(row, starto_col - j + k, p * pascal[k] * pow(s[i+0], 1-j));
+
+                    for(int k = 0; k < j + 1; k++)
+                        triplets.emplace_back(row, starto_col + 1 + k, -p * pascal[k] * pow(s[i+1], 1-j));
+                }
+            }
+        }
+
+        //A_ieqsfc, see setAieqBieqsfc
+        int tangent_plane_no = 0;
+        for(auto& what : sfc_list)
+            tangent_plane_no = tangent_plane_no + what.PolyhedronTangentArray.size();
+
+        ub_ieqsfc.resize(tangent_plane_no * (n_order + 1));
+        lb_ieqsfc.resize(tangent_plane_no * (n_order + 1));
+
+        int row_sfc = 0;
+
+        for(int i = 0; i < (int)sfc_list.size(); i++)
+        {
+            // only the 3D case is scaled by the segment time there
+            double scale = axis_dim == 3 ? s[i] : 1.0;
+
+            for(int j = 0; j < n_order + 1; j++)
+            {
+                int col = i * (n_order + 1) + j;
+
+                for(auto& tangent : sfc_list[i].PolyhedronTangentArray)
+                {
+                    double n_axis[3] = {tangent.n.X, tangent.n.Y, tangent.n.Z};
+                    double pt_axis[3] = {tangent.pt.X, tangent.pt.Y, tangent.pt.Z};
+                    double b = 0;
+
+                    for(int axis_i = 0; axis_i < axis_dim; axis_i++)
+                    {
+                        triplets.emplace_back(row, col + axis_i * _dim, n_axis[axis_i] * scale);
+                        b = b + n_axis[axis_i] * pt_axis[axis_i];
+                    }
+
+                    ub_ieqsfc(row_sfc) = b;
+                    lb_ieqsfc(row_sfc) = -(double)1e30;
+
+                    row++;
+                    row_sfc++;
+                }
+            }
+        }
+
+        //Aieq dynamics, v a j of setAieq1D for "POLYH"
+        for(int axis_i = 0; axis_i < axis_dim; axis_i++)
+        {
+            int col = axis_i * _dim;
+
+            for(int k = 1; k < d_order; k++)
+            {
+                pascal = pascal_triangle(k + 1);
+                double p = permutation(n_order, n_order - k);
+
+                for(int i = 0; i < m; i++)
+                    for(int j = 0; j < n_order + 1 - k; j++, row++)
+                        for(int q = 0; q < k + 1; q++)
+                            triplets.emplace_back(row, col + (n_order + 1) * i + j + q, p * pascal[q] * pow(s[i], 1-k));
+            }
+        }
+
+        return row;
+    }
+
+    // CSC from one sample's triplets, and where each triplet lands in it
+    void bernstein::setSparsePattern(
+        int rows, 
+        int cols, 
+        std::vector<Eigen::Triplet<double>>& triplets, 
+        sparse_pattern& pattern
+    )
+    {
+        std::vector<Eigen::Triplet<double>> index;
+        index.reserve(triplets.size());
+
+        for(int k = 0; k < (int)triplets.size(); k++)
+            index.emplace_back(triplets[k].row(), triplets[k].col(), k);
+
+        pattern.mat.resize(rows, cols);
+        pattern.mat.setFromTriplets(index.begin(), index.end());
+        pattern.mat.makeCompressed();
+
+        if(pattern.mat.nonZeros() != (Eigen::Index)triplets.size())
+            ROS_ERROR("DUPLICATE ENTRIES IN SPARSE PATTERN, PLEASE CHECK!");
+
+        pattern.slot.assign(triplets.size(), 0);
+        for(int i = 0; i < pattern.mat.nonZeros(); i++)
+            pattern.slot[(int)pattern.mat.valuePtr()[i]] = i;
+
+        for(int k = 0; k < (int)triplets.size(); k++)
+            pattern.mat.valuePtr()[pattern.slot[k]] = triplets[k].value();
+    }
+
+    // another sample's triplets, in the value order of the pattern
+    void bernstein::setSparseValues(
+        std::vector<Eigen::Triplet<double>>& triplets, 
+        sparse_pattern& pattern, 
+        Eigen::VectorXd& values
+    )
+    {
+        if(triplets.size() != pattern.slot.size())
+        {
+            ROS_ERROR("SPARSE PATTERN CHANGED BETWEEN SAMPLES, PLEASE CHECK!");
+            return;
+        }
+
+        values.resize(triplets.size());
+
+        for(int k = 0; k < (int)triplets.size(); k++)
+            values(pattern.slot[k]) = triplets[k].value();
+    }
+
     std::tuple<Eigen::VectorXd, Eigen::VectorXd> bernstein::set_ub_lb(
         int axis_dim, 
         int n_order, 
@@ -0,0 +1,184 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file explicit_qp.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief explicit solution of a QP whose bounds are the only thing that changes, one affine map per active set
+ */
+
+#include "include/bezier_lib/explicit_qp.h"
+
+namespace alan_traj
+{
+    void explicit_qp::set(
+        const Eigen::SparseMatrix<double>& P,
+        const Eigen::SparseMatrix<double>& A,
+        const Eigen::VectorXd& ub,
+        const Eigen::VectorXd& lb
+    )
+    {
+        _P = Eigen::MatrixXd(P);
+        _A = Eigen::MatrixXd(A);
+
+        _equality.clear();
+        for(int i = 0; i < _A.rows(); i++)
+            if(ub(i) == lb(i))
+                _equality.push_back(i);
+
+        _regions.clear();
+        _last_hit = 0;
+
+        std::vector<int> active = _equality;
+        std::vector<int> side(active.size(), 0);
+        addRegion(active, side);
+    }
+
+    bool explicit_qp::addSolution(const Eigen::VectorXd& dual)
+    {
+        if(dual.size() != _A.rows())
+            return false;
+
+        std::vector<int> active = _equality;
+        std::vector<int> side(active.size(), 0);
+
+        int eq_i = 0;
+        for(int i = 0; i < _A.rows(); i++)
+        {
+            if(eq_i < (int)_equality.size() && _equality[eq_i] == i)
+            {
+                eq_i++;
+                continue;
+            }
+
+            if(std::abs(dual(i)) > tol)
+            {
+                active.push_back(i);
+                side.push_back(dual(i) > 0 ? 1 : -1);
+            }
+        }
+
+        for(auto& region : _regions)
+            if(region.active == active && region.side == side)
+                return true;
+
+        return addRegion(active, side);
+    }
+
+    bool explicit_qp::addRegion(std::vector<int>& active, std::vector<int>& side)
+    {
+        const int n = _P.rows();
+        const int k = active.size();
+
+        // [P + sigma I, A_act'; A_act, 0] [x; y] = [0; b]
+        Eigen::MatrixXd KKT = Eigen::MatrixXd::Zero(n + k, n + k);
+        KKT.topLeftCorner(n, n) = _P + sigma * Eigen::MatrixXd::Identity(n, n);
+
+        for(int j = 0; j < k; j++)
+        {
+            KKT.block(n + j, 0, 1, n) = _A.row(active[j]);
+            KKT.block(0, n + j, n, 1) = _A.row(active[j]).transpose();
+        }
+
+        // dependent active rows, e.g. a corridor face through a fixed end point
+        Eigen::FullPivLU<Eigen::MatrixXd> lu(KKT);
+        if(!lu.isInvertible())
+            return false;
+
+        Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(n + k, k);
+        rhs.bottomRows(k).setIdentity();
+        Eigen::MatrixXd map = lu.solve(rhs);
+
+        qp_region region;
+        region.active = active;
+        region.side = side;
+
+        std::vector<bool> is_active(_A.rows(), false);
+        for(int i : active)
+            is_active[i] = true;
+        for(int i = 0; i < _A.rows(); i++)
+            if(!is_active[i])
+                region.inactive.push_back(i);
+
+        region.X = map.topRows(n);
+        region.Y = map.bottomRows(k);
+
+        region.AX.resize(region.inactive.size(), k);
+        for(int j = 0; j < (int)region.inactive.size(); j++)
+            region.AX.row(j) = _A.row(region.inactive[j]) * region.X;
+
+        region.b.resize(k);
+        region.y.resize(k);
+        region.Ax.resize(region.inactive.size());
+
+        if((int)_regions.size() >= max_region_no && _regions.size() > 1)
+        {
+            _regions.erase(_regions.begin() + 1);
+            _last_hit = 0;
+        }
+
+        _regions.push_back(region);
+
+        return true;
+    }
+
+    bool explicit_qp::solve(
+        const Eigen::VectorXd& ub,
+        const Eigen::VectorXd& lb,
+        Eigen::VectorXd& sol
+    )
+    {
+        // the region of the last call first, the bounds mostly move a little
+        for(int j = 0; j < (int)_regions.size(); j++)
+        {
+            const int r = (_last_hit + j) % _regions.size();
+            qp_region& region = _regions[r];
+
+            for(int k = 0; k < (int)region.active.size(); k++)
+                region.b(k) = region.side[k] < 0 ? lb(region.active[k]) : ub(region.active[k]);
+
+            region.y.noalias() = region.Y * region.b;
+
+            bool valid = true;
+            for(int k = _equality.size(); k < (int)region.active.size() && valid; k++)
+                valid = region.side[k] * region.y(k) >= -tol;
+
+            if(!valid)
+                continue;
+
+            region.Ax.noalias() = region.AX * region.b;
+
+            for(int k = 0; k < (int)region.inactive.size() && valid; k++)
+            {
+                const int i = region.inactive[k];
+                valid = region.Ax(k) <= ub(i) + tol && region.Ax(k) >= lb(i) - tol;
+            }
+
+            if(!valid)
+                continue;
+
+            sol.noalias() = region.X * region.b;
+            _last_hit = r;
+
+            return true;
+        }
+
+        return false;
+    }
+}
@@ -27,6 +27,7 @@
 #define BERNSTEIN_H
 
 #include "../tools/essential.h"
+#include <Eigen/Sparse>
 #include "alan_visualization/Polyhedron.h"
 // #include "alan_landing_planning/"
 #include "alan_landing_planning/AlanPlannerMsg.h"
@@ -132,6 +133,20 @@ namespace alan_traj
 
     
 
+    /*!
+    * @struct      sparse_pattern
+    * @abstract    CSC of one sampled QP matrix, the nonzeros sit at the same place for every time allocation.
+    *
+    * @field       mat         the pattern, with the values of the sample it was built from
+    * @field       slot        k-th triplet of a sample -> mat.valuePtr()[slot[k]]
+    */
+
+    typedef struct sparse_pattern
+    {
+        Eigen::SparseMatrix<double> mat;
+        std::vector<int> slot;
+    }sparse_pattern;
+
     // typedef
 
 
@@ -247,6 +262,37 @@ namespace alan_traj
             std::vector<alan_visualization::Polyhedron> sfc_list,
             std::vector<double> s
         );
+
+        // the same two as triplets, every structural entry in a fixed order, zeros included
+        void set_1_MQMTriplets(
+            int axis_dim, 
+            int n_order, 
+            int m, 
+            int d_order, 
+            std::vector<double> s,
+            std::vector<Eigen::Triplet<double>>& triplets
+        );
+        int set_1_ATriplets(
+            int axis_dim, 
+            int n_order, 
+            int m, 
+            int d_order,  
+            std::vector<alan_visualization::Polyhedron>& sfc_list,
+            std::vector<double> s,
+            std::vector<Eigen::Triplet<double>>& triplets
+        );//returns the no. of rows
+        void setSparsePattern(
+            int rows, 
+            int cols, 
+            std::vector<Eigen::Triplet<double>>& triplets, 
+            sparse_pattern& pattern
+        );
+        void setSparseValues(
+            std::vector<Eigen::Triplet<double>>& triplets, 
+            sparse_pattern& pattern, 
+            Eigen::VectorXd& values
+        );
+
         std::tuple<Eigen::VectorXd, Eigen::VectorXd> set_ub_lb(
             int axis_dim, 
             int n_order, 
@@ -0,0 +1,95 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file explicit_qp.h
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief explicit solution of a QP whose bounds are the only thing that changes, one affine map per active set
+ */
+
+#ifndef EXPLICIT_QP_H
+#define EXPLICIT_QP_H
+
+#include "../tools/essential.h"
+#include <Eigen/Sparse>
+
+namespace alan_traj
+{
+    // one active set: rows held at a bound, and what follows from their bound values
+    typedef struct qp_region
+    {
+        std::vector<int> active;        // equality rows first, then active inequality rows
+        std::vector<int> side;          // 0 equality, 1 at ub, -1 at lb
+        std::vector<int> inactive;
+
+        Eigen::MatrixXd X;              // x = X * b, b the bounds of the active rows
+        Eigen::MatrixXd Y;              // multipliers of the active rows, Y * b
+        Eigen::MatrixXd AX;             // inactive rows, A x = AX * b
+
+        Eigen::VectorXd b, y, Ax;       // workspace
+    }qp_region;
+
+    /* min 0.5 x'Px  s.t.  lb <= Ax <= ub, with P and A fixed. for a given set
+    of active rows the KKT system is linear, so the solution is a fixed matrix
+    times the active bounds, and it holds as long as the inactive rows stay
+    within their bounds and the multipliers keep their signs. the equality
+    rows make one region; each active set a full QP solve returns makes
+    another. */
+    class explicit_qp
+    {
+    private:
+        Eigen::MatrixXd _P;
+        Eigen::MatrixXd _A;
+        std::vector<int> _equality;
+        std::vector<qp_region> _regions;
+        int _last_hit = 0;
+
+        bool addRegion(std::vector<int>& active, std::vector<int>& side);
+
+    public:
+        explicit_qp(){};
+        ~explicit_qp(){};
+
+        int max_region_no = 16;     // the oldest one but the equality region goes first
+        double sigma = 1e-6;        // added to P, as OSQP does, for the rows P leaves free
+        double tol = 1e-6;          // on the inactive rows and the multiplier signs
+
+        // rows with lb == ub are the equalities, whatever the values
+        void set(
+            const Eigen::SparseMatrix<double>& P,
+            const Eigen::SparseMatrix<double>& A,
+            const Eigen::VectorXd& ub,
+            const Eigen::VectorXd& lb
+        );
+
+        // the active set of a solved QP, from its multipliers: > 0 at ub, < 0 at lb
+        bool addSolution(const Eigen::VectorXd& dual);
+
+        // false when no stored active set holds for these bounds
+        bool solve(
+            const Eigen::VectorXd& ub,
+            const Eigen::VectorXd& lb,
+            Eigen::VectorXd& sol
+        );
+
+        inline int getRegionNo(){return _regions.size();}
+    };
+}
+
+#endif
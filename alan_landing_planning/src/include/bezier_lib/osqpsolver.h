@@ -28,6 +28,16 @@
 #include <OsqpEigen/OsqpEigen.h>
 
 #include "../tools/essential.h"
+#include <atomic>
+#include <memory>
+
+// one per sampling thread, set up once, with its own copy of the patterns to write sample values in
+typedef struct qp_instance
+{
+    OsqpEigen::Solver solver;
+    Eigen::SparseMatrix<double> Hessian;
+    Eigen::SparseMatrix<double> Alinear;
+}qp_instance;
 
 class osqpsolver
 {
@@ -41,47 +51,80 @@ private:
     std::vector<Eigen::VectorXd> _qpsol_array;
 
     //sampling
-    std::vector<Eigen::MatrixXd> _MQM_array;
-    std::vector<Eigen::SparseMatrix<double>> _Hessian_array;
-    std::vector<Eigen::SparseMatrix<double>> _Alinear_array;
+    //one pattern for all samples, each sample only its nonzeros
+    Eigen::SparseMatrix<double> _Hessian;
+    Eigen::SparseMatrix<double> _Alinear;
+    std::vector<Eigen::VectorXd> _Hessian_values;
+    std::vector<Eigen::VectorXd> _Alinear_values;
     Eigen::VectorXd _ub;
     Eigen::VectorXd _lb;
     std::vector<std::vector<double>> _time_samples;
     std::vector<double> _cost_array;
 
-    inline void initiate_qpsolve(int nV, int nC)
+    //sampling threads, 0 for one per core
+    int _thread_no = 0;
+    //rho every sample starts from, OSQP's default
+    const double _rho_sample = 0.1;
+    std::vector<std::unique_ptr<qp_instance>> _instances;
+
+    inline void initiate_qpsolve(
+        OsqpEigen::Solver& solver, 
+        Eigen::SparseMatrix<double>& Hessian, 
+        Eigen::SparseMatrix<double>& Alinear, 
+        bool warm_start
+    )
     {
+        int nV = Hessian.rows();
+        int nC = Alinear.rows();
+
         Eigen::VectorXd g;
         g.resize(nV);
         // g << -2, -6;
         g.setZero();
 
-        _qpsolver.settings()->setWarmStart(true);
-        _qpsolver.settings()->setVerbosity(false);
+        solver.settings()->setWarmStart(warm_start);
+        solver.settings()->setVerbosity(false);
+
+        // rho adapts every fixed number of iterations instead of after a share of the
+        // setup time, which differs from run to run; solve_instance() puts it back to
+        // _rho_sample before each sample
+        if(!warm_start)
+        {
+            solver.settings()->setRho(_rho_sample);
+            solver.settings()->setAdaptiveRhoInterval(25);
+        }
 
-        _qpsolver.data()->setNumberOfVariables(nV);
-        _qpsolver.data()->setNumberOfConstraints(nC);
+        solver.data()->setNumberOfVariables(nV);
+        solver.data()->setNumberOfConstraints(nC);
 
-        if(!_qpsolver.data()->setHessianMatrix(_Hessian_array[0]))
+        if(!solver.data()->setHessianMatrix(Hessian))
         std::cout<<"Hessian not set!"<<std::endl;
 
-        if(!_qpsolver.data()->setGradient(g))
+        if(!solver.data()->setGradient(g))
             std::cout<<"gradient not set!"<<std::endl;
         
-        if(!_qpsolver.data()->setLinearConstraintsMatrix(_Alinear_array[0]))
+        if(!solver.data()->setLinearConstraintsMatrix(Alinear))
             std::cout<<"linear matrix not set!"<<std::endl;
         
-        if(!_qpsolver.data()->setLowerBound(_lb))
+        if(!solver.data()->setLowerBound(_lb))
             std::cout<<"lb not set!!"<<std::endl;
         
-        if(!_qpsolver.data()->setUpperBound(_ub))
+        if(!solver.data()->setUpperBound(_ub))
             std::cout<<"ub not set!"<<std::endl;
         
-        if(!_qpsolver.initSolver())
+        if(!solver.initSolver())
             std::cout<<"please initialize solver!!"<<std::endl;
 
     }
 
+    bool solve_instance(
+        qp_instance& instance, 
+        Eigen::VectorXd& MQM_values, 
+        Eigen::VectorXd& A_values,
+        Eigen::VectorXd& sol,
+        double& cost
+    );
+
     /* data */
 public:
     osqpsolver(/* args */);    
@@ -95,14 +138,21 @@ public:
         Eigen::MatrixXd _lb
     );
 
-    bool qp_opt_single(
-        Eigen::MatrixXd& _MQM, 
-        Eigen::MatrixXd& _A, 
+    // online replanning: the chosen time allocation once, then only new bounds
+    bool set_online(
+        Eigen::SparseMatrix<double>& _MQM, 
+        Eigen::SparseMatrix<double>& _A
+    );
+
+    bool qp_opt_online(
         Eigen::VectorXd& _ub, 
         Eigen::VectorXd& _lb,
         Eigen::VectorXd& final_sol
     );
 
+    // multipliers of the last qp_opt_online(), > 0 at ub, < 0 at lb
+    inline Eigen::VectorXd getOnlineDual(){return _qpsolver.getDualSolution();}
+
     inline Eigen::VectorXd getQpsol(){return qpsol;}
 
 
@@ -117,44 +167,65 @@ public:
     bool qp_opt_samples(
         std::vector<Eigen::VectorXd>& qpsol_array,
         std::vector<std::vector<double>>& sample_time_array,
-        std::vector<Eigen::MatrixXd>& MQM_opti_array,
-        std::vector<Eigen::MatrixXd>& A_opti_array,
+        std::vector<Eigen::SparseMatrix<double>>& MQM_opti_array,
+        std::vector<Eigen::SparseMatrix<double>>& A_opti_array,
         std::vector<double>& optimal_time_allocation,
         int& optimal_index
     );
 
+    // MQM_values[i] & A_values[i]: valuePtr() of the two patterns at sample i
     inline void set_sampling_matrices(
-        std::vector<Eigen::MatrixXd>& MQM_array,
-        std::vector<Eigen::MatrixXd>& A_array,
+        Eigen::SparseMatrix<double>& MQM_pattern,
+        std::vector<Eigen::VectorXd>& MQM_values,
+        Eigen::SparseMatrix<double>& A_pattern,
+        std::vector<Eigen::VectorXd>& A_values,
         Eigen::VectorXd& ub,
         Eigen::VectorXd& lb
     )
     {
-        _MQM_array.clear();
-        _Hessian_array.clear();
-        _Alinear_array.clear();
-
-        for(auto& what : MQM_array)
-        {
-            _MQM_array.emplace_back(what);
-            _Hessian_array.emplace_back(what.sparseView());
-        }
-            
-        for(auto& what : A_array)
-            _Alinear_array.emplace_back(what.sparseView());
+        _Hessian = MQM_pattern;
+        _Alinear = A_pattern;
+        _Hessian_values = MQM_values;
+        _Alinear_values = A_values;
         
         _ub = ub;
         _lb = lb;
 
-        int nV = MQM_array[0].rows();
-        int nC = A_array[0].rows();
-
         // std::cout<<"hi we now in osqpsolver class..."<<std::endl;
-        // std::cout<<_Hessian_array.size()<<std::endl;
+        // std::cout<<_Hessian_values.size()<<std::endl;
+
+        initiate_qpsolve(_qpsolver, _Hessian, _Alinear, true);
+
+        int thread_no = _thread_no > 0 ? _thread_no : std::thread::hardware_concurrency();
+        thread_no = std::max(1, std::min<int>(thread_no, MQM_values.size()));
 
-        initiate_qpsolve(nV, nC);
+        _instances.clear();
+        for(int i = 0; i < thread_no; i++)
+        {
+            _instances.emplace_back(new qp_instance());
+            _instances.back()->Hessian = _Hessian;
+            _instances.back()->Alinear = _Alinear;
+
+            initiate_qpsolve(
+                _instances.back()->solver, 
+                _instances.back()->Hessian, 
+                _instances.back()->Alinear, 
+                false
+            );
+        }
     };
 
+    // before set_sampling_matrices
+    inline void set_thread_no(int thread_no){_thread_no = thread_no;}
+
+    // one more time allocation on the first sampling instance, in the pattern of set_sampling_matrices
+    bool qp_opt_values(
+        Eigen::VectorXd& MQM_values, 
+        Eigen::VectorXd& A_values,
+        Eigen::VectorXd& sol,
+        double& cost
+    );
+
     inline void set_time_sampling(std::vector<std::vector<double>> time_samples){_time_samples = time_samples;}
 
 
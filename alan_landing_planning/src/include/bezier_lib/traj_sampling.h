@@ -27,8 +27,10 @@
 #define TRAJ_SAMPLING_H
 
 #include "../tools/essential.h"
+#include <functional>
 #include "bernstein.h"
 #include "osqpsolver.h"
+#include "explicit_qp.h"
 
 #include "alan_landing_planning/AlanPlannerMsg.h"
 #include "alan_landing_planning/TrajArray.h"
@@ -43,8 +45,9 @@ namespace alan_traj
         alan_landing_planning::TrajArray optiTrajArray;
         alan_landing_planning::Traj ctrl_pts_optimal;
         // Eigen::VectorXd ctrl_pts_optimal;
-        Eigen::MatrixXd MQM;
-        Eigen::MatrixXd A;      
+        Eigen::SparseMatrix<double> MQM;
+        Eigen::SparseMatrix<double> A;      
+        int qp_no = 0; //QPs solved to find it
         bool got_heuristic_optimal = false;  
     }optimal_traj;
 
@@ -91,7 +94,7 @@ namespace alan_traj
 
         //set OptiTrajSample
         void setOptiTrajSample(Eigen::VectorXd PolyCoeff);
-        void setOptiFinalTraj(Eigen::VectorXd PolyCoeff);
+        void setOptiFinalTraj(Eigen::VectorXd& PolyCoeff);
         void setCtrlPts(Eigen::VectorXd& qpsol);
         void setTimeDiscrete(std::vector<double> _s_sample);
         std::vector<std::vector<double>> time_vector;
@@ -119,8 +122,10 @@ namespace alan_traj
 
     //sampling-related
         // for matrix pre-definition
-        std::vector<Eigen::MatrixXd> MQM_samples;
-        std::vector<Eigen::MatrixXd> A_samples;
+        // one pattern each, every time sample only keeps its nonzeros
+        sparse_pattern MQM_pattern, A_pattern;
+        std::vector<Eigen::VectorXd> MQM_samples;
+        std::vector<Eigen::VectorXd> A_samples;
 
         std::vector<Eigen::VectorXd> ub_samples;
         std::vector<Eigen::VectorXd> lb_samples;
@@ -141,6 +146,33 @@ namespace alan_traj
 
         optimal_traj optimal_traj_info;
 
+        //online replanning
+        bool online_set = false;
+        Eigen::VectorXd online_sol;
+
+        // explicit solution of the online QP, OSQP only when no stored active set holds
+        explicit_qp online_explicit;
+        bool online_explicit_on = true;
+
+    //time allocation search-related
+        bernstein search_base;
+        std::vector<Eigen::Triplet<double>> search_MQM_triplets, search_A_triplets;
+        Eigen::VectorXd search_MQM_values, search_A_values;
+
+        std::vector<double> search_time_minmax;
+        int search_max_qp = 0;
+        int search_qp_no = 0;
+        double seg_ratio_min = 0.02;   //shortest segment, share of the total time
+
+        double search_best_cost = INFINITY;
+        std::vector<double> search_best_s;
+        Eigen::VectorXd search_best_ctrl;
+        int search_best_index = 0;
+
+        double evalTimeAllocation(std::vector<double> s);
+        double goldenSection(const std::function<double(double)>& cost, double a, double b, double tol);
+        std::vector<double> setTimeAllocation(double total_time, std::vector<double>& ratio);
+
         alan_landing_planning::Traj setCtrlVis(Eigen::VectorXd optiCtrl);
 
     public:
@@ -158,6 +190,9 @@ namespace alan_traj
         // for m = 2 (landing trajectory)
         // void set_
 
+        // QPs solved at once by set_prerequisite & optSamples, 0 for one per core
+        inline void set_sample_threads(int thread_no){trajSolver.set_thread_no(thread_no);}
+
         void set_prerequisite(
             std::vector<double> time_minmax, 
             int total_time_sample_no,
@@ -171,6 +206,15 @@ namespace alan_traj
         );
 
         void optSamples();
+
+        // any m: searches the total time and the split of each pair of neighbouring
+        // segments, coarse to fine, instead of a grid; then optSearch() for optSamples()
+        void set_prerequisite_search(
+            std::vector<double> time_minmax,
+            int max_qp_no
+        );
+
+        void optSearch();
         
         alan_landing_planning::TrajArray getOptiTrajSamples(){return _optiTrajArray;}
         alan_landing_planning::Traj getOptiTraj(){return _optiTraj;}      
@@ -179,6 +223,13 @@ namespace alan_traj
         optimal_traj getOptimalTrajInfo(){return optimal_traj_info;}
 
         alan_landing_planning::Traj opt_traj_online(Eigen::Vector3d& posi_current, Eigen::Vector3d& posi_goal);
+
+        // active sets kept for opt_traj_online(), 0 for OSQP on every call
+        inline void set_online_explicit(int max_region_no)
+        {
+            online_explicit_on = max_region_no > 0;
+            online_explicit.max_region_no = max_region_no;
+        }
     };
 }
 
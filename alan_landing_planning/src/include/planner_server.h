@@ -35,6 +35,7 @@
 #include "alan_visualization/PolyhedronArray.h"
 
 #include "trajectory_msgs/MultiDOFJointTrajectoryPoint.h"
+#include "alan_flight_log/flightLog.hpp"
 
 #include <thread>
 
@@ -188,6 +189,10 @@ private:
 
     bool prerequisite_set = false;
     int sample_square_root = 0;
+    int sample_threads = 0;
+    bool time_search = false;
+    int time_search_max_qp = 200;
+    int online_explicit_regions = 16;
 
 
 //rotation function
@@ -214,6 +219,12 @@ private:
     std::string log_path;
     void config(ros::NodeHandle& _nh);
 
+    // LOG_file: fsm, pose, setpoint and command of every planner_pub() in-process
+    alan::flightLog flight_log;
+    int log_planner = -1;
+    void flightLog_config(ros::NodeHandle& _nh);
+    int fsm_code(const std::string& state);
+
     //block trajectory (for data collection)
     Eigen::Vector4d set_following_target_pose();
     Eigen::Vector4d set_uav_block_pose();
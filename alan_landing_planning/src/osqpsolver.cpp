@@ -120,106 +120,120 @@ void osqpsolver::qp_opt(
 
 }
 
-bool osqpsolver::qp_opt_single(
-    Eigen::MatrixXd& _MQM,
-    Eigen::MatrixXd& _A,
-    Eigen::VectorXd& _ub,
-    Eigen::VectorXd& _lb,
-    Eigen::VectorXd& final_sol
+bool osqpsolver::set_online(
+    Eigen::SparseMatrix<double>& _MQM,
+    Eigen::SparseMatrix<double>& _A
 )
 {
-    std::cout<<"here in qp_opt_single"<<std::endl;
-    // std::cout<<_ub<<std::endl;
-    // std::cout<<_lb<<std::endl;
-
-    Eigen::SparseMatrix<double> Hessian = _MQM.sparseView();
-    if(!_qpsolver.updateHessianMatrix(Hessian))
+    // same pattern as the samples, OSQP only takes the new values and factorizes once
+    if(!_qpsolver.updateHessianMatrix(_MQM))
+    {
         std::cout<<"Hessian not updated!"<<std::endl;
+        return false;
+    }
     
-    Eigen::SparseMatrix<double> ALinear = _A.sparseView();
-    if(!_qpsolver.updateLinearConstraintsMatrix(ALinear));
+    if(!_qpsolver.updateLinearConstraintsMatrix(_A))
+    {
+        std::cout<<"linear matrix not updated!"<<std::endl;
+        return false;
+    }
 
-    if(!_qpsolver.data()->setUpperBound(_ub))
-        std::cout<<"ub not set!!"<<std::endl;
-    
-    if(!_qpsolver.data()->setLowerBound(_lb))
-        std::cout<<"lb not set!"<<std::endl;
+    return true;
+}
 
+bool osqpsolver::qp_opt_online(
+    Eigen::VectorXd& _ub,
+    Eigen::VectorXd& _lb,
+    Eigen::VectorXd& final_sol
+)
+{
+    // no refactorization, warm started from the last primal & dual solution, no output
+    if(!_qpsolver.updateBounds(_lb, _ub))
+        return false;
 
     if(!_qpsolver.solve())
-    {
-        ROS_RED_STREAM("FAILED!");
         return false;
-    }
-    else
-    {
-        final_sol = _qpsolver.getSolution();
-        std::cout<<"end..."<<final_sol.size()<<std::endl; 
-        ROS_GREEN_STREAM("SUCCEEDED!");
-        return true;
-    }                   
+
+    final_sol = _qpsolver.getSolution();
+    return true;
 }
 
 bool osqpsolver::qp_opt_samples(
     std::vector<Eigen::VectorXd>& qpsol_array,
         std::vector<std::vector<double>>& sample_time_array,
-        std::vector<Eigen::MatrixXd>& MQM_opti_array,
-        std::vector<Eigen::MatrixXd>& A_opti_array,
+        std::vector<Eigen::SparseMatrix<double>>& MQM_opti_array,
+        std::vector<Eigen::SparseMatrix<double>>& A_opti_array,
         std::vector<double>& optimal_time_allocation,
         int& optimal_index
 )
 {
     double cost_min = INFINITY;
-    double cost_temp = INFINITY;
     
     int success_i = 0;
     int index_for_all_array = 0;
     int index_for_extracted = 0;
 
     qpsol_array.clear();
+    sample_time_array.clear();
+    MQM_opti_array.clear();
+    A_opti_array.clear();
+    _cost_array.clear();
 
-    if(_Hessian_array.size() != _Alinear_array.size())
+    if(_Hessian_values.size() != _Alinear_values.size() || _instances.empty())
         return false;
     else
     {
-         for(int i = 0; i < _Hessian_array.size(); i++)
+        int sample_no = _Hessian_values.size();
+
+        // one slot per sample, written by whichever thread solved it
+        std::vector<char> success(sample_no, false);
+        std::vector<double> cost(sample_no, INFINITY);
+        std::vector<Eigen::VectorXd> sol(sample_no);
+
+        std::atomic<int> next(0);
+
+        auto solve_samples = [&](int thread_i)
+        {
+            qp_instance& instance = *_instances[thread_i];
+
+            // next unsolved sample until none is left, so the faster threads take more
+            for(int i = next.fetch_add(1); i < sample_no; i = next.fetch_add(1))
+                success[i] = solve_instance(instance, _Hessian_values[i], _Alinear_values[i], sol[i], cost[i]);
+        };
+
+        std::vector<std::thread> threads;
+        for(int i = 1; i < (int)_instances.size(); i++)
+            threads.emplace_back(solve_samples, i);
+
+        solve_samples(0);
+
+        for(auto& what : threads)
+            what.join();
+
+        // in sample order, the first of equal costs wins whatever the thread count
+        for(int i = 0; i < sample_no; i++)
         {
-            // std::cout<<i<<std::endl;
-            if(!_qpsolver.updateHessianMatrix(_Hessian_array[i]))
-                std::cout<<"Hessian not update!"<<std::endl;
-            
-            if(!_qpsolver.updateLinearConstraintsMatrix(_Alinear_array[i]))
-                std::cout<<"linear matrix not update!"<<std::endl;
-            
-            if(!_qpsolver.solve())
-                ROS_RED_STREAM("FAILED!");
-            else
-            {                   
-                ROS_GREEN_STREAM("SUCCEED!");
-                qpsol_array.emplace_back(_qpsolver.getSolution());
-                sample_time_array.emplace_back(_time_samples[i]);
-                MQM_opti_array.emplace_back(_MQM_array[i]);
-                A_opti_array.emplace_back(_Alinear_array[i]);
-
-                std::cout<<_time_samples[i][0]<<" "<<_time_samples[i][1]<<std::endl;
-
-                cost_temp = 
-                    _qpsolver.getSolution().transpose() 
-                    * _MQM_array[i] 
-                    * _qpsolver.getSolution();
-                    
-                _cost_array.emplace_back(cost_temp);
-
-                std::cout<<"cost: "<<_cost_array[_cost_array.size() - 1]<<std::endl;
-
-                if(cost_temp < cost_min)
-                {
-                    cost_min = cost_temp;
-                    index_for_all_array = i;
-                    index_for_extracted = _cost_array.size() - 1;
-                }       
-                success_i ++;                                                 
-            }                            
+            if(!success[i])
+                continue;
+
+            qpsol_array.emplace_back(sol[i]);
+            sample_time_array.emplace_back(_time_samples[i]);
+
+            MQM_opti_array.emplace_back(_Hessian);
+            Eigen::Map<Eigen::VectorXd>(MQM_opti_array.back().valuePtr(), _Hessian.nonZeros()) = _Hessian_values[i];
+
+            A_opti_array.emplace_back(_Alinear);
+            Eigen::Map<Eigen::VectorXd>(A_opti_array.back().valuePtr(), _Alinear.nonZeros()) = _Alinear_values[i];
+
+            _cost_array.emplace_back(cost[i]);
+
+            if(cost[i] < cost_min)
+            {
+                cost_min = cost[i];
+                index_for_all_array = i;
+                index_for_extracted = _cost_array.size() - 1;
+            }       
+            success_i ++;                                                 
         }
 
         if(success_i < 1)
@@ -236,8 +250,10 @@ bool osqpsolver::qp_opt_samples(
             optimal_time_allocation = _time_samples[index_for_all_array];
 
             std::string msg_display0
-                = std::to_string(_Hessian_array.size()) 
-                    + " TRAJ EVALUATED, SUCCEEDED "
+                = std::to_string(sample_no) 
+                    + " TRAJ EVALUATED ON "
+                    + std::to_string(_instances.size())
+                    + " THREADS, SUCCEEDED "
                     + std::to_string(qpsol_array.size())
                     + " TRAJ";
 
@@ -263,5 +279,53 @@ bool osqpsolver::qp_opt_samples(
     }
 }
 
+bool osqpsolver::solve_instance(
+    qp_instance& instance, 
+    Eigen::VectorXd& MQM_values, 
+    Eigen::VectorXd& A_values,
+    Eigen::VectorXd& sol,
+    double& cost
+)
+{
+#ifdef OSQP_EIGEN_OSQP_IS_V1
+    OSQPSolver* const osqp = instance.solver.solver().get();
+#else
+    OSQPWorkspace* const osqp = instance.solver.workspace().get();
+#endif
+
+    // an instance keeps the rho it adapted to on whichever samples its thread took before;
+    // back to the same start, else the result depends on the thread count
+    if(osqp->settings->rho != _rho_sample && osqp_update_rho(osqp, _rho_sample) != 0)
+        return false;
+
+    Eigen::Map<Eigen::VectorXd>(instance.Hessian.valuePtr(), instance.Hessian.nonZeros()) = MQM_values;
+    Eigen::Map<Eigen::VectorXd>(instance.Alinear.valuePtr(), instance.Alinear.nonZeros()) = A_values;
+
+    // bounds after the matrices: each update unscales & rescales them, so set last,
+    // they carry no rounding from the samples before; also takes a moved start & end
+    if(
+        !instance.solver.updateHessianMatrix(instance.Hessian)
+        || !instance.solver.updateLinearConstraintsMatrix(instance.Alinear)
+        || !instance.solver.updateBounds(_lb, _ub)
+        || !instance.solver.solve()
+    )
+        return false;
+
+    sol = instance.solver.getSolution();
+    cost = sol.dot(instance.Hessian * sol);
 
+    return true;
+}
+
+bool osqpsolver::qp_opt_values(
+    Eigen::VectorXd& MQM_values, 
+    Eigen::VectorXd& A_values,
+    Eigen::VectorXd& sol,
+    double& cost
+)
+{
+    if(_instances.empty())
+        return false;
 
+    return solve_instance(*_instances[0], MQM_values, A_values, sol, cost);
+}
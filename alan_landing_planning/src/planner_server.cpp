@@ -93,7 +93,7 @@ planner_server::planner_server(ros::NodeHandle& _nh, int pub_freq)
 
 planner_server::~planner_server()
 {
-
+    flight_log.close();
 }
 
 void planner_server::mainserver()
@@ -603,6 +603,14 @@ void planner_server::planner_pub()
         local_vel_pub.publish(uav_traj_twist_desired);
     else
         kill_attitude_target_pub.publish(attitude_target_for_kill);
+
+    if(flight_log.isOpen())
+        flight_log.write(log_planner, ros::Time::now().toSec(), {
+            (double)fsm_code(fsm_state),
+            uav_traj_pose(0), uav_traj_pose(1), uav_traj_pose(2), uav_traj_pose(3),
+            target_traj_pose(0), target_traj_pose(1), target_traj_pose(2), target_traj_pose(3),
+            twist_result(0), twist_result(1), twist_result(2), twist_result(3)
+        });
 }
 
 Eigen::Vector4d planner_server::pid_controller(Eigen::Vector4d pose, Eigen::Vector4d setpoint)
@@ -921,6 +929,10 @@ void planner_server::config(ros::NodeHandle& _nh)
     nh.getParam("/alan_master_planner_node/a_max", a_max);
 
     nh.getParam("/alan_master_planner_node/sample_square_root", sample_square_root);
+    nh.getParam("/alan_master_planner_node/sample_threads", sample_threads);
+    nh.getParam("/alan_master_planner_node/time_search", time_search);
+    nh.getParam("/alan_master_planner_node/time_search_max_qp", time_search_max_qp);
+    nh.getParam("/alan_master_planner_node/online_explicit_regions", online_explicit_regions);
     
     landing_time_duration_max 
         = (take_off_height - touch_down_height + landing_horizontal) / uav_landing_velocity;
@@ -944,6 +956,48 @@ void planner_server::config(ros::NodeHandle& _nh)
 
     //block traj temp
     std::cout<<"set block traj..."<<set_block_traj<<std::endl;
+
+    flightLog_config(_nh);
+}
+
+void planner_server::flightLog_config(ros::NodeHandle& _nh)
+{
+    std::string log_file;
+    int capacity = 1 << 18;
+    double flush_period = 1.0;
+
+    nh.getParam("/alan_master_planner_node/LOG_file", log_file);
+    nh.getParam("/alan_master_planner_node/LOG_capacity", capacity);
+    nh.getParam("/alan_master_planner_node/LOG_flush_period", flush_period);
+
+    if(log_file.empty())
+        return;
+
+    log_planner = flight_log.addStream("planner", {
+        "fsm",
+        "x", "y", "z", "yaw",
+        "tgt_x", "tgt_y", "tgt_z", "tgt_yaw",
+        "vx", "vy", "vz", "wz"
+    });
+
+    if(flight_log.open(log_file, capacity, flush_period))
+        ROS_INFO_STREAM("flight log to " << log_file);
+    else
+        ROS_ERROR_STREAM("cannot open flight log " << log_file);
+}
+
+// fsm column of the flight log, in the order of the #defines in planner_server.h
+int planner_server::fsm_code(const std::string& state)
+{
+    static const char* states[] = {
+        IDLE, ARMED, TOOKOFF, FOLLOW, RENDEZVOUS, LAND, SHUTDOWN, MISSION_COMPLETE
+    };
+
+    for(int i = 0; i < (int)(sizeof(states) / sizeof(states[0])); i++)
+        if(state == states[i])
+            return i;
+
+    return -1;
 }
 
 void planner_server::set_alan_b_traj_prerequisite()
@@ -1013,12 +1067,20 @@ void planner_server::set_alan_b_traj_prerequisite()
         std::cout<<sample_square_root<<std::endl;
 
         double tick0 = ros::Time::now().toSec();
-        alan_btraj_sample->set_prerequisite(time_sample, sample_square_root, sample_square_root);        
+        alan_btraj_sample->set_sample_threads(sample_threads);
+        alan_btraj_sample->set_online_explicit(online_explicit_regions);
+        if(time_search)
+            alan_btraj_sample->set_prerequisite_search(time_sample, time_search_max_qp);
+        else
+            alan_btraj_sample->set_prerequisite(time_sample, sample_square_root, sample_square_root);        
         alan_btraj_sample->updateBoundary(posi_start, posi_end, velo_constraint);
         double tock0 = ros::Time::now().toSec();
 
         double tick1 = ros::Time::now().toSec();
-        alan_btraj_sample->optSamples();
+        if(time_search)
+            alan_btraj_sample->optSearch();
+        else
+            alan_btraj_sample->optSamples();
         optimal_traj_info_obj = alan_btraj_sample->getOptimalTrajInfo();        
         double tock1 = ros::Time::now().toSec();
 
@@ -1027,6 +1089,7 @@ void planner_server::set_alan_b_traj_prerequisite()
         std::cout<<"fps: "<<1 / (tock0 - tick0)<<std::endl<<std::endl;
 
         std::cout<<"set Optimization Sample..."<<std::endl;
+        std::cout<<"QPs solved: "<<optimal_traj_info_obj.qp_no<<std::endl;
         std::cout<<"ms: "<<(tock1 - tick1) * 1000<<std::endl;
         std::cout<<"fps: "<<1 / (tock1 - tick1)<<std::endl;
 
@@ -164,16 +164,18 @@ namespace alan_traj
 
     }
 
-    void traj_sampling::setOptiFinalTraj(Eigen::VectorXd PolyCoeff)
+    // into _optiTraj in place, no allocation once it has its size
+    void traj_sampling::setOptiFinalTraj(Eigen::VectorXd& PolyCoeff)
     {        
-        std::cout<<"hi setOptiFinalTraj"<<std::endl;
-        std::cout<<PolyCoeff.size()<<std::endl;
-        alan_landing_planning::AlanPlannerMsg traj_discrete_pt;
-        alan_landing_planning::Traj optiTraj;
-        optiTraj.trajectory.clear();
+        int pt_no = 0;
+        for(auto& what : time_vector)
+            pt_no = pt_no + what.size();
+
+        _optiTraj.trajectory.resize(pt_no);
         
         double x_pos = 0, y_pos = 0, z_pos = 0;
         double p_base;
+        int pt_i = 0;
 
         for(int seg_i = 0; seg_i < _m; seg_i++)
         {
@@ -196,14 +198,12 @@ namespace alan_traj
                     z_pos = z_pos + PolyCoeff(seg_i * (_n_order + 1) + k + _n_dim_per_axis * 2) * p_base;            
                 }
 
-                traj_discrete_pt.position.x = x_pos;
-                traj_discrete_pt.position.y = y_pos;
-                traj_discrete_pt.position.z = z_pos;
-
-                optiTraj.trajectory.emplace_back(traj_discrete_pt);                
+                _optiTraj.trajectory[pt_i].position.x = x_pos;
+                _optiTraj.trajectory[pt_i].position.y = y_pos;
+                _optiTraj.trajectory[pt_i].position.z = z_pos;
+                pt_i++;
             }
         }    
-        _optiTraj = optiTraj;
 
     }
 
@@ -227,7 +227,7 @@ namespace alan_traj
 
         setMatrices(bezier_base, sampling_time);
         setBoundary(bezier_base);
-        trajSolver.set_sampling_matrices(MQM_samples, A_samples, _ub, _lb);
+        trajSolver.set_sampling_matrices(MQM_pattern.mat, MQM_samples, A_pattern.mat, A_samples, _ub, _lb);
         
 
         // for(auto what : sampling_time)
@@ -290,24 +290,41 @@ namespace alan_traj
 
     void traj_sampling::setMatrices(bernstein& bezier_base, std::vector<std::vector<double>>& sampling_time)
     {
+        // the time allocation only changes values, never where the nonzeros are,
+        // so the first sample sets the pattern and the rest fill it
+        std::vector<Eigen::Triplet<double>> MQM_triplets, A_triplets;
+        int A_rows = 0;
+
+        MQM_samples.clear();
+        A_samples.clear();
+        MQM_samples.reserve(sampling_time.size());
+        A_samples.reserve(sampling_time.size());
+
         for(auto& what : sampling_time)
         {
-            MQM_samples.emplace_back(
-                bezier_base.set_1_MQMSample(_axis_dim, _n_order, _m, _d_order, what)
-            );   
-
-            A_samples.emplace_back(
-                bezier_base.set_1_ASample(
-                    _axis_dim, 
-                    _n_order, 
-                    _m, 
-                    _d_order,
-                    _sfc_list,
-                    what
-                )
+            bezier_base.set_1_MQMTriplets(_axis_dim, _n_order, _m, _d_order, what, MQM_triplets);
+
+            A_rows = bezier_base.set_1_ATriplets(
+                _axis_dim, 
+                _n_order, 
+                _m, 
+                _d_order,
+                _sfc_list,
+                what,
+                A_triplets
             );
 
+            if(MQM_samples.empty())
+            {
+                bezier_base.setSparsePattern(_n_dim, _n_dim, MQM_triplets, MQM_pattern);
+                bezier_base.setSparsePattern(A_rows, _n_dim, A_triplets, A_pattern);
+            }
+
+            MQM_samples.emplace_back();
+            bezier_base.setSparseValues(MQM_triplets, MQM_pattern, MQM_samples.back());
 
+            A_samples.emplace_back();
+            bezier_base.setSparseValues(A_triplets, A_pattern, A_samples.back());
         }
   
     }
@@ -348,12 +365,13 @@ namespace alan_traj
 
     void traj_sampling::optSamples()
     {
+        online_set = false;
         _optiTrajArray.trajectory_array.clear();
 
         std::vector<Eigen::VectorXd> qpsol_array;
         std::vector<std::vector<double>> sample_time_array;
-        std::vector<Eigen::MatrixXd> MQM_opti_array;
-        std::vector<Eigen::MatrixXd> A_opti_array;
+        std::vector<Eigen::SparseMatrix<double>> MQM_opti_array;
+        std::vector<Eigen::SparseMatrix<double>> A_opti_array;
         std::vector<double> optimal_time_allocation;
         int optimal_index;
 
@@ -405,6 +423,7 @@ namespace alan_traj
             optimal_traj_info.ctrl_pts_optimal = setCtrlVis(_ctrl_pts_optimal);
             optimal_traj_info.MQM = MQM_opti_array[optimal_index];
             optimal_traj_info.A = A_opti_array[optimal_index];
+            optimal_traj_info.qp_no = MQM_samples.size();
             optimal_traj_info.got_heuristic_optimal = true;
         }
         else
@@ -412,34 +431,261 @@ namespace alan_traj
 
     }
 
+    void traj_sampling::set_prerequisite_search(
+        std::vector<double> time_minmax,
+        int max_qp_no
+    )
+    {
+        search_time_minmax = time_minmax;
+        search_max_qp = max_qp_no;
+
+        // any allocation gives the pattern, an even split of the mean time here
+        std::vector<double> s(_m, 0.5 * (time_minmax[0] + time_minmax[1]) / _m);
+
+        search_base.set_1_MQMTriplets(_axis_dim, _n_order, _m, _d_order, s, search_MQM_triplets);
+        int A_rows = search_base.set_1_ATriplets(
+            _axis_dim, 
+            _n_order, 
+            _m, 
+            _d_order,
+            _sfc_list,
+            s,
+            search_A_triplets
+        );
+
+        search_base.setSparsePattern(_n_dim, _n_dim, search_MQM_triplets, MQM_pattern);
+        search_base.setSparsePattern(A_rows, _n_dim, search_A_triplets, A_pattern);
+
+        MQM_samples.assign(1, Eigen::VectorXd());
+        A_samples.assign(1, Eigen::VectorXd());
+        search_base.setSparseValues(search_MQM_triplets, MQM_pattern, MQM_samples[0]);
+        search_base.setSparseValues(search_A_triplets, A_pattern, A_samples[0]);
+
+        setBoundary(search_base);
+        trajSolver.set_time_sampling({s});
+        trajSolver.set_sampling_matrices(MQM_pattern.mat, MQM_samples, A_pattern.mat, A_samples, _ub, _lb);
+    }
+
+    void traj_sampling::optSearch()
+    {
+        online_set = false;
+        _optiTrajArray.trajectory_array.clear();
+
+        search_qp_no = 0;
+        search_best_cost = INFINITY;
+        search_best_s.clear();
+
+        double time_min = search_time_minmax[0];
+        double time_max = search_time_minmax[1];
+
+        double total_time = 0.5 * (time_min + time_max);
+        std::vector<double> ratio(_m, 1.0 / _m);
+
+        // each pass a finer line search, stop once a pass gains little
+        double tol = 5e-2;
+        double cost_last = INFINITY;
+
+        for(int pass = 0; pass < 3 && search_qp_no < search_max_qp; pass++, tol = tol * 0.2)
+        {
+            //total time, same split
+            total_time = goldenSection(
+                [&](double x){return evalTimeAllocation(setTimeAllocation(x, ratio));},
+                time_min, 
+                time_max, 
+                tol * (time_max - time_min)
+            );
+
+            //time moved between segment k and k + 1, the rest kept
+            for(int k = 0; k < _m - 1; k++)
+            {
+                double pair = ratio[k] + ratio[k + 1];
+
+                if(pair - 2 * seg_ratio_min <= 0)
+                    continue;
+
+                ratio[k] = goldenSection(
+                    [&](double x)
+                    {
+                        std::vector<double> ratio_temp = ratio;
+                        ratio_temp[k] = x;
+                        ratio_temp[k + 1] = pair - x;
+                        return evalTimeAllocation(setTimeAllocation(total_time, ratio_temp));
+                    },
+                    seg_ratio_min,
+                    pair - seg_ratio_min,
+                    tol * pair
+                );
+                ratio[k + 1] = pair - ratio[k];
+            }
+
+            if(search_best_cost == INFINITY)
+                continue;
+
+            if(cost_last - search_best_cost < 1e-3 * std::fabs(search_best_cost))
+                break;
+
+            cost_last = search_best_cost;
+        }
+
+        optimal_traj_info.qp_no = search_qp_no;
+
+        if(search_best_cost == INFINITY)
+        {
+            ROS_RED_STREAM("TIME ALLOCATION SEARCH FAIL, PLEASE CHECK CONSTRAINTS & TIME ALLOCTION...");
+            optimal_traj_info.got_heuristic_optimal = false;
+            return;
+        }
+
+        std::string msg_display = "TIME ALLOCATION:";
+        for(auto what : search_best_s)
+            msg_display = msg_display + " " + std::to_string(what);
+
+        ROS_GREEN_STREAM(std::to_string(search_qp_no) + " QP SOLVED, LOWEST COST: " + std::to_string(search_best_cost));
+        ROS_GREEN_STREAM(msg_display);
+
+        _optiTraj = _optiTrajArray.trajectory_array[search_best_index];
+        _ctrl_pts_optimal = search_best_ctrl;
+
+        // matrices of the best one, for the online re-solve
+        search_base.set_1_MQMTriplets(_axis_dim, _n_order, _m, _d_order, search_best_s, search_MQM_triplets);
+        search_base.set_1_ATriplets(_axis_dim, _n_order, _m, _d_order, _sfc_list, search_best_s, search_A_triplets);
+        search_base.setSparseValues(search_MQM_triplets, MQM_pattern, search_MQM_values);
+        search_base.setSparseValues(search_A_triplets, A_pattern, search_A_values);
+
+        optimal_traj_info.MQM = MQM_pattern.mat;
+        optimal_traj_info.A = A_pattern.mat;
+        Eigen::Map<Eigen::VectorXd>(optimal_traj_info.MQM.valuePtr(), optimal_traj_info.MQM.nonZeros()) = search_MQM_values;
+        Eigen::Map<Eigen::VectorXd>(optimal_traj_info.A.valuePtr(), optimal_traj_info.A.nonZeros()) = search_A_values;
+
+        optimal_traj_info.optimal_index = search_best_index;
+        optimal_traj_info.optimal_time_allocation = search_best_s;
+        optimal_traj_info.optiTraj = _optiTraj;
+        optimal_traj_info.optiTrajArray = _optiTrajArray;
+        optimal_traj_info.ctrl_pts_optimal = setCtrlVis(_ctrl_pts_optimal);
+        optimal_traj_info.got_heuristic_optimal = true;
+    }
+
+    // QP cost of one allocation, as optSamples compares them; INFINITY if infeasible or out of QPs
+    double traj_sampling::evalTimeAllocation(std::vector<double> s)
+    {
+        if(search_qp_no >= search_max_qp)
+            return INFINITY;
+
+        search_base.set_1_MQMTriplets(_axis_dim, _n_order, _m, _d_order, s, search_MQM_triplets);
+        search_base.set_1_ATriplets(_axis_dim, _n_order, _m, _d_order, _sfc_list, s, search_A_triplets);
+        search_base.setSparseValues(search_MQM_triplets, MQM_pattern, search_MQM_values);
+        search_base.setSparseValues(search_A_triplets, A_pattern, search_A_values);
+
+        Eigen::VectorXd qpsol;
+        double cost;
+
+        search_qp_no++;
+
+        if(!trajSolver.qp_opt_values(search_MQM_values, search_A_values, qpsol, cost))
+            return INFINITY;
+
+        setTimeDiscrete(s);
+        setCtrlPts(qpsol);
+        setOptiTrajSample(qpsol);
+
+        if(cost < search_best_cost)
+        {
+            search_best_cost = cost;
+            search_best_s = s;
+            search_best_ctrl = qpsol;
+            search_best_index = _optiTrajArray.trajectory_array.size() - 1;
+        }
+
+        return cost;
+    }
+
+    // minimizer of cost on [a, b] to within tol, always a point cost was evaluated at
+    double traj_sampling::goldenSection(const std::function<double(double)>& cost, double a, double b, double tol)
+    {
+        const double r = (std::sqrt(5.0) - 1) / 2;
+
+        double x1 = b - r * (b - a);
+        double x2 = a + r * (b - a);
+        double f1 = cost(x1);
+        double f2 = cost(x2);
+
+        while(b - a > tol && search_qp_no < search_max_qp)
+        {
+            if(f1 <= f2)
+            {
+                b = x2;
+                x2 = x1;
+                f2 = f1;
+                x1 = b - r * (b - a);
+                f1 = cost(x1);
+            }
+            else
+            {
+                a = x1;
+                x1 = x2;
+                f1 = f2;
+                x2 = a + r * (b - a);
+                f2 = cost(x2);
+            }
+        }
+
+        return f1 <= f2 ? x1 : x2;
+    }
+
+    std::vector<double> traj_sampling::setTimeAllocation(double total_time, std::vector<double>& ratio)
+    {
+        std::vector<double> s(ratio.size());
+
+        for(int i = 0; i < (int)ratio.size(); i++)
+            s[i] = total_time * ratio[i];
+
+        return s;
+    }
+
     alan_landing_planning::Traj traj_sampling::opt_traj_online(Eigen::Vector3d& posi_current, Eigen::Vector3d& posi_goal)
     {
-        Eigen::VectorXd final_sol;
+        // the optimal time allocation is factorized on the first call after sampling,
+        // every call after that only moves start & end: an affine map of them while
+        // the active set is one seen before, else OSQP
+        if(!online_set)
+        {
+            online_set = trajSolver.set_online(optimal_traj_info.MQM, optimal_traj_info.A);
+            setTimeDiscrete(optimal_traj_info.optimal_time_allocation);
+
+            // the equality region, and the active set of the optimum at the bounds it was sampled with
+            if(online_set && online_explicit_on)
+            {
+                online_explicit.set(optimal_traj_info.MQM, optimal_traj_info.A, _ub, _lb);
+                if(trajSolver.qp_opt_online(_ub, _lb, online_sol))
+                    online_explicit.addSolution(trajSolver.getOnlineDual());
+            }
+        }
+
         Eigen::Vector3d velo_temp;
         velo_temp.setZero();
         updateBoundary(posi_current, posi_goal, velo_temp);
 
-        bool traj_gen_success = trajSolver.qp_opt_single(
-            optimal_traj_info.MQM,
-            optimal_traj_info.A,
-            _ub,
-            _lb,
-            final_sol
-        );
+        bool solved = online_set && online_explicit_on && online_explicit.solve(_ub, _lb, online_sol);
 
-        if(traj_gen_success)
+        if(!solved && online_set && trajSolver.qp_opt_online(_ub, _lb, online_sol))
         {
-            setTimeDiscrete(optimal_traj_info.optimal_time_allocation);
-            setCtrlPts(final_sol);
-            setOptiFinalTraj(final_sol);
+            solved = true;
+
+            // a new active set, bounds near these skip OSQP from now on
+            if(online_explicit_on)
+                online_explicit.addSolution(trajSolver.getOnlineDual());
+        }
+
+        if(solved)
+        {
+            setCtrlPts(online_sol);
+            setOptiFinalTraj(online_sol);
         }
         else
         {
             _optiTraj = optimal_traj_info.optiTraj;
         }
 
-        
-        std::cout<<"execute this..."<<_optiTraj.trajectory.size()<<std::endl;
         return _optiTraj;
     }
 
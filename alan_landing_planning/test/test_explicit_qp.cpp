@@ -0,0 +1,227 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file test_explicit_qp.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief explicit_qp against the optimum found by trying every active set
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/include/bezier_lib/explicit_qp.h"
+
+#include <random>
+
+namespace
+{
+    static const int VAR_NO = 4;
+    static const int EQ_NO = 1;
+    static const int IEQ_NO = 4;
+
+    typedef struct denseQP
+    {
+        Eigen::MatrixXd P, A;
+        Eigen::VectorXd ub, lb;
+    }denseQP;
+
+    /* min 0.5 x'(P + sigma I)x s.t. lb <= Ax <= ub, by trying every active set
+    of the inequality rows: strictly convex, so the one satisfying KKT is the
+    optimum. the multipliers follow OSQP, > 0 at ub, < 0 at lb. */
+    bool bruteForce(const denseQP& qp, double sigma, Eigen::VectorXd& x, Eigen::VectorXd& dual)
+    {
+        const int n = qp.P.cols(), rows = qp.A.rows();
+        const double tol = 1e-9;
+
+        // 0 inactive, 1 at ub, 2 at lb, per inequality row
+        int combo_no = 1;
+        for(int i = EQ_NO; i < rows; i++)
+            combo_no *= 3;
+
+        for(int combo = 0; combo < combo_no; combo++)
+        {
+            std::vector<int> active, side;
+            for(int i = 0; i < EQ_NO; i++)
+            {
+                active.push_back(i);
+                side.push_back(0);
+            }
+
+            int code = combo;
+            for(int i = EQ_NO; i < rows; i++, code /= 3)
+                if(code % 3)
+                {
+                    active.push_back(i);
+                    side.push_back(code % 3 == 1 ? 1 : -1);
+                }
+
+            const int k = active.size();
+            if(k > n)
+                continue;
+
+            Eigen::MatrixXd KKT = Eigen::MatrixXd::Zero(n + k, n + k);
+            Eigen::VectorXd rhs = Eigen::VectorXd::Zero(n + k);
+            KKT.topLeftCorner(n, n) = qp.P + sigma * Eigen::MatrixXd::Identity(n, n);
+
+            for(int j = 0; j < k; j++)
+            {
+                KKT.block(n + j, 0, 1, n) = qp.A.row(active[j]);
+                KKT.block(0, n + j, n, 1) = qp.A.row(active[j]).transpose();
+                rhs(n + j) = side[j] < 0 ? qp.lb(active[j]) : qp.ub(active[j]);
+            }
+
+            Eigen::FullPivLU<Eigen::MatrixXd> lu(KKT);
+            if(!lu.isInvertible())
+                continue;
+
+            const Eigen::VectorXd sol = lu.solve(rhs);
+            const Eigen::VectorXd Ax = qp.A * sol.head(n);
+
+            bool kkt = true;
+            for(int i = 0; i < rows && kkt; i++)
+                kkt = Ax(i) <= qp.ub(i) + tol && Ax(i) >= qp.lb(i) - tol;
+            for(int j = EQ_NO; j < k && kkt; j++)
+                kkt = side[j] * sol(n + j) >= -tol;
+
+            if(!kkt)
+                continue;
+
+            x = sol.head(n);
+            dual = Eigen::VectorXd::Zero(rows);
+            for(int j = 0; j < k; j++)
+                dual(active[j]) = sol(n + j);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    denseQP getQP(std::mt19937& rng)
+    {
+        std::normal_distribution<double> normal(0, 1);
+
+        denseQP qp;
+        Eigen::MatrixXd L(VAR_NO, VAR_NO);
+        for(int i = 0; i < L.size(); i++)
+            L(i) = normal(rng);
+        qp.P = L * L.transpose() + 0.1 * Eigen::MatrixXd::Identity(VAR_NO, VAR_NO);
+
+        qp.A.resize(EQ_NO + IEQ_NO, VAR_NO);
+        for(int i = 0; i < qp.A.size(); i++)
+            qp.A(i) = normal(rng);
+
+        qp.ub.resize(EQ_NO + IEQ_NO);
+        qp.lb.resize(EQ_NO + IEQ_NO);
+
+        return qp;
+    }
+
+    // equalities lb == ub, inequalities around 0, so that some bind and some do not
+    void setBounds(denseQP& qp, std::mt19937& rng)
+    {
+        std::normal_distribution<double> normal(0, 1);
+        std::uniform_real_distribution<double> width(0.1, 2.0);
+
+        for(int i = 0; i < EQ_NO + IEQ_NO; i++)
+        {
+            const double center = i < EQ_NO ? 1.0 + 0.3 * normal(rng) : 0.8 * normal(rng);
+            const double half = i < EQ_NO ? 0 : width(rng);
+
+            qp.lb(i) = center - half;
+            qp.ub(i) = center + half;
+        }
+    }
+}
+
+TEST(explicitQP, solutionsAreTheOptimum)
+{
+    std::mt19937 rng(20261018);
+    int explicit_no = 0, bound_no = 0;
+
+    for(int problem = 0; problem < 50; problem++)
+    {
+        denseQP qp = getQP(rng);
+        setBounds(qp, rng);
+
+        alan_traj::explicit_qp solver;
+        solver.set(qp.P.sparseView(), qp.A.sparseView(), qp.ub, qp.lb);
+
+        Eigen::VectorXd x_ref, dual, x;
+
+        for(int bound = 0; bound < 60; bound++)
+        {
+            setBounds(qp, rng);
+
+            if(!bruteForce(qp, solver.sigma, x_ref, dual))
+                continue;
+
+            bound_no++;
+
+            // whatever region answers has to be the optimum
+            if(solver.solve(qp.ub, qp.lb, x))
+            {
+                explicit_no++;
+                EXPECT_LT((x - x_ref).norm(), 1e-6) << "problem " << problem << " bounds " << bound;
+                continue;
+            }
+
+            // a new active set, from the multipliers a QP solve would return
+            ASSERT_TRUE(solver.addSolution(dual));
+            ASSERT_TRUE(solver.solve(qp.ub, qp.lb, x)) << "problem " << problem << " bounds " << bound;
+            EXPECT_LT((x - x_ref).norm(), 1e-6) << "problem " << problem << " bounds " << bound;
+
+            EXPECT_LE(solver.getRegionNo(), solver.max_region_no);
+        }
+    }
+
+    // the regions have to answer some of it on their own, else nothing was tested
+    EXPECT_GT(explicit_no, bound_no / 4);
+}
+
+TEST(explicitQP, boundsNoRegionCoversAreLeftToTheSolver)
+{
+    std::mt19937 rng(7);
+    denseQP qp = getQP(rng);
+    setBounds(qp, rng);
+
+    alan_traj::explicit_qp solver;
+    solver.set(qp.P.sparseView(), qp.A.sparseView(), qp.ub, qp.lb);
+    ASSERT_EQ(1, solver.getRegionNo());
+
+    // the equality region keeps every inequality row near 0, far from these windows
+    for(int i = EQ_NO; i < EQ_NO + IEQ_NO; i++)
+    {
+        qp.lb(i) = 1e3;
+        qp.ub(i) = 1e3 + 1;
+    }
+
+    Eigen::VectorXd x;
+    EXPECT_FALSE(solver.solve(qp.ub, qp.lb, x));
+
+    // multipliers of another problem's size
+    EXPECT_FALSE(solver.addSolution(Eigen::VectorXd::Zero(EQ_NO + IEQ_NO + 1)));
+    EXPECT_EQ(1, solver.getRegionNo());
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,175 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file test_osqp_samples.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief osqpsolver::qp_opt_samples, bit for bit the same on one sampling thread as on several
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/include/bezier_lib/osqpsolver.h"
+
+#include <random>
+
+namespace
+{
+    static const int VAR_NO = 12;
+    static const int EQ_NO = 2;
+    static const int IEQ_NO = 10;
+    static const int SAMPLE_NO = 64;
+
+    typedef struct sampledQP
+    {
+        Eigen::SparseMatrix<double> MQM_pattern, A_pattern;
+        std::vector<Eigen::VectorXd> MQM_values, A_values;
+        Eigen::VectorXd ub, lb;
+        std::vector<std::vector<double>> time_samples;
+    }sampledQP;
+
+    // one pattern, dense so that every sample fills the same nonzeros, the values
+    // spread enough across samples that OSQP adapts rho on some of them
+    sampledQP getSamples(std::mt19937& rng)
+    {
+        std::normal_distribution<double> normal(0, 1);
+        std::uniform_real_distribution<double> scale(0.2, 5.0);
+
+        sampledQP qp;
+
+        Eigen::MatrixXd L(VAR_NO, VAR_NO), A(EQ_NO + IEQ_NO, VAR_NO);
+        for(int i = 0; i < L.size(); i++)
+            L(i) = normal(rng);
+        for(int i = 0; i < A.size(); i++)
+            A(i) = normal(rng);
+
+        const Eigen::MatrixXd P = L * L.transpose() + 0.1 * Eigen::MatrixXd::Identity(VAR_NO, VAR_NO);
+        qp.MQM_pattern = P.sparseView();
+        qp.A_pattern = A.sparseView();
+
+        for(int k = 0; k < SAMPLE_NO; k++)
+        {
+            const double T1 = scale(rng), T2 = scale(rng);
+
+            Eigen::MatrixXd D = Eigen::MatrixXd::Identity(VAR_NO, VAR_NO);
+            for(int i = 0; i < VAR_NO; i++)
+                D(i, i) = i < VAR_NO / 2 ? T1 : T2;
+
+            Eigen::MatrixXd A_sample = A;
+            for(int i = 0; i < A_sample.size(); i++)
+                A_sample(i) *= 1 + 0.2 * normal(rng);
+
+            Eigen::SparseMatrix<double> MQM_sample = (D * P * D).sparseView();
+            Eigen::SparseMatrix<double> A_sparse = A_sample.sparseView();
+
+            qp.MQM_values.emplace_back(Eigen::Map<Eigen::VectorXd>(MQM_sample.valuePtr(), MQM_sample.nonZeros()));
+            qp.A_values.emplace_back(Eigen::Map<Eigen::VectorXd>(A_sparse.valuePtr(), A_sparse.nonZeros()));
+            qp.time_samples.push_back({T1, T2});
+        }
+
+        // equalities away from 0, so that no sample has the trivial solution
+        qp.ub.resize(EQ_NO + IEQ_NO);
+        qp.lb.resize(EQ_NO + IEQ_NO);
+        for(int i = 0; i < EQ_NO + IEQ_NO; i++)
+        {
+            qp.lb(i) = i < EQ_NO ? 1.0 + normal(rng) : -0.5 - std::abs(normal(rng));
+            qp.ub(i) = i < EQ_NO ? qp.lb(i) : 0.5 + std::abs(normal(rng));
+        }
+
+        return qp;
+    }
+
+    typedef struct sampledResult
+    {
+        std::vector<Eigen::VectorXd> qpsol_array;
+        std::vector<std::vector<double>> sample_time_array;
+        std::vector<double> optimal_time_allocation;
+        int optimal_index = -1;
+    }sampledResult;
+
+    bool getResult(osqpsolver& solver, sampledResult& result)
+    {
+        std::vector<Eigen::SparseMatrix<double>> MQM_opti_array, A_opti_array;
+
+        return solver.qp_opt_samples(
+            result.qpsol_array,
+            result.sample_time_array,
+            MQM_opti_array,
+            A_opti_array,
+            result.optimal_time_allocation,
+            result.optimal_index
+        );
+    }
+
+    void expectSame(const sampledResult& expected, const sampledResult& result, int thread_no)
+    {
+        ASSERT_EQ(expected.qpsol_array.size(), result.qpsol_array.size()) << thread_no << " threads";
+        EXPECT_EQ(expected.optimal_index, result.optimal_index) << thread_no << " threads";
+        EXPECT_EQ(expected.optimal_time_allocation, result.optimal_time_allocation) << thread_no << " threads";
+        EXPECT_EQ(expected.sample_time_array, result.sample_time_array) << thread_no << " threads";
+
+        // exact, not near: every sample has to start from the same solver state
+        for(int k = 0; k < (int)expected.qpsol_array.size(); k++)
+        {
+            ASSERT_EQ(expected.qpsol_array[k].size(), result.qpsol_array[k].size());
+            for(int i = 0; i < expected.qpsol_array[k].size(); i++)
+                EXPECT_EQ(expected.qpsol_array[k](i), result.qpsol_array[k](i))
+                    << thread_no << " threads, sample " << k << ", variable " << i;
+        }
+    }
+}
+
+TEST(osqpSamples, sameResultOnAnyThreadCount)
+{
+    std::mt19937 rng(20261018);
+    sampledQP qp = getSamples(rng);
+
+    sampledResult expected;
+    {
+        osqpsolver solver;
+        solver.set_thread_no(1);
+        solver.set_sampling_matrices(qp.MQM_pattern, qp.MQM_values, qp.A_pattern, qp.A_values, qp.ub, qp.lb);
+        solver.set_time_sampling(qp.time_samples);
+
+        ASSERT_TRUE(getResult(solver, expected));
+        ASSERT_GT(expected.qpsol_array.size(), 0u);
+    }
+
+    for(int thread_no : {2, 3, 4, 8})
+    {
+        osqpsolver solver;
+        solver.set_thread_no(thread_no);
+        solver.set_sampling_matrices(qp.MQM_pattern, qp.MQM_values, qp.A_pattern, qp.A_values, qp.ub, qp.lb);
+        solver.set_time_sampling(qp.time_samples);
+
+        // twice on the same instances, the second run starts from what the first left
+        for(int run = 0; run < 2; run++)
+        {
+            sampledResult result;
+            ASSERT_TRUE(getResult(solver, result));
+            expectSame(expected, result, thread_no);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
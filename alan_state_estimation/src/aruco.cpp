@@ -324,7 +324,7 @@ void alan::ArucoNodelet::pose_w_aruco_pnp(cv::Mat& frame)
         }
 
         if(body_frame_pts.size() == pts_2d_detect.size())
-            optimize(pose, body_frame_pts, pts_2d_detect);//pose, body_frame_pts, pts_2d_detect
+            pose_refiner.refine(pose, body_frame_pts, pts_2d_detect);
 
         // std::cout<<body_frame_pts.size()<<std::endl;
         for(auto what : body_frame_pts)
@@ -583,116 +583,6 @@ bool alan::ArucoNodelet::aruco_detect(cv::Mat& frame, std::vector<Eigen::Vector2
         return false;
 }
 
-void alan::ArucoNodelet::solveJacobian(Eigen::Matrix<double, 2, 6>& Jacob, Sophus::SE3d pose, Eigen::Vector3d point_3d)
-{
-    Eigen::Matrix3d R = pose.rotationMatrix();
-    Eigen::Vector3d t = pose.translation();
-                // cameraMat
-    double fx = cameraMat(0,0);
-    double fy = cameraMat(1,1);
-
-    Eigen::Vector3d point_in_camera = R * point_3d + t;
-    
-    double x_c = point_in_camera(0),
-        y_c = point_in_camera(1),
-        z_c = point_in_camera(2);
-
-    //save entries to Jacob and return
-    Jacob << 
-        //first row
-        -fx / z_c, 
-        0, 
-        fx * x_c / z_c / z_c, 
-        fx * x_c * y_c / z_c / z_c,
-        -fx - fx * x_c * x_c / z_c / z_c,
-        fx * y_c / z_c,
-
-        //second row
-        0,
-        -fy / z_c,
-        fy * y_c / z_c / z_c,
-        fy + fy * y_c * y_c / z_c / z_c,
-        -fy * x_c * y_c / z_c / z_c,
-        -fy * x_c / z_c;
-    
-    // std::cout<<"Jacob here: "<<Jacob<<std::endl;        
-}
-
-void alan::ArucoNodelet::optimize(Sophus::SE3d& pose, std::vector<Eigen::Vector3d> pts_3d_exists, std::vector<Eigen::Vector2d> pts_2d_detected)
-//converge problem need to be solved //-> fuck you, your Jacobian was wrong
-{
-    //execute Gaussian-Newton Method
-    // std::cout<<"Bundle Adjustment Optimization"<<std::endl;
-
-    const int MAX_ITERATION = 400;
-
-    const double converge_threshold = 1e-6;
-
-    const int points_no = pts_2d_detected.size();
-
-    Eigen::Matrix<double, 2, 6> J;
-    Eigen::Matrix<double, 6, 6> A; // R6*6
-    Eigen::Matrix<double, 6, 1> b; // R6
-    Eigen::Vector2d e; // R2
-    Eigen::Matrix<double, 6, 1> dx;
-
-    int i;
-    double cost = 0, lastcost = INFINITY;
-    
-    for(i = 0; i < MAX_ITERATION; i++)
-    {
-        // std::cout<<"this is the: "<<i<<" th iteration."<<std::endl;
-        A.setZero();
-        b.setZero();
-
-        cost = 0;
-        
-
-        for(int i=0; i < points_no; i++)
-        {
-            //get the Jacobian for this point
-            pts_3d_exists[i] = pts_3d_exists[i];
-            solveJacobian(J, pose, pts_3d_exists[i]);
-
-            e = pts_2d_detected[i] - reproject_3D_2D(pts_3d_exists[i], pose) ; 
-            //jibai, forget to minus the detected points
-            //you set your Jacobian according to "u-KTP/s", and you messed up the order, you fat fuck
-    
-            cost += e.norm();
-
-            //form Ax = b
-            A += J.transpose() * J;
-            b += -J.transpose() * e;
-        }
-    
-        //solve Adx = b
-        dx = A.ldlt().solve(b);
-
-        for(int i = 0; i < 6; i++)
-            if(isnan(dx(i,0)))
-                break;
-
-        // std::cout<<"previous: "/*<<std::cout.precision(10)*/<< lastcost<<std::endl;
-        // std::cout<<"currentt: "/*<<std::cout.precision(10)*/<< cost<<std::endl;
-
-        // if(i > 0 && cost >= lastcost)
-        //     break;
-
-        pose = Sophus::SE3d::exp(dx) * pose;
-
-        lastcost = cost;
-
-        if(dx.norm() < converge_threshold)        
-            break;
-    }
-
-    // std::cout<<"BA: "<<lastcost<<std::endl;
-
-    // std::cout<<"gone thru: "<<i<<" th, end optimize"<<std::endl<<std::endl;;;
-
-}
-
-
 void* alan::ArucoNodelet::PubMainLoop(void* tmp)
 {
     ArucoNodelet* pub = (ArucoNodelet*) tmp;
@@ -817,7 +707,7 @@ void alan::ArucoNodelet::use_pnp_instead(cv::Mat frame, std::vector<Eigen::Vecto
         pose_ = Sophus::SE3d(R,t);
 
 
-    optimize(pose_, body_frame_pts, pts_2d_detect);
+    pose_refiner.refine(pose_, body_frame_pts, pts_2d_detect);
 
     pose = pose_;
 
@@ -899,56 +789,11 @@ Eigen::Vector3d alan::ArucoNodelet::get_CoM(std::vector<Eigen::Vector3d> pts_3d)
     return CoM;
 }
 
-std::vector<Eigen::Vector3d> alan::ArucoNodelet::pointcloud_generate(std::vector<Eigen::Vector2d> pts_2d_detected, cv::Mat depthimage)
+std::vector<Eigen::Vector3d> alan::ArucoNodelet::pointcloud_generate(const std::vector<Eigen::Vector2d>& pts_2d_detected, const cv::Mat& depthimage)
 {
-    //get 9 pixels around the point of interest
-
-    int no_pixels = 9;
-    int POI_width = (sqrt(9) - 1 ) / 2;
-
+    //depth around each corner, read in place, see depthSampler.hpp
     std::vector<Eigen::Vector3d> pointclouds;
-
-    int x_pixel, y_pixel;
-    Eigen::Vector3d temp;
-
-    for(int i = 0; i < pts_2d_detected.size(); i++)
-    {
-
-        x_pixel = pts_2d_detected[i].x();
-        y_pixel = pts_2d_detected[i].y();
-        
-        cv::Point depthbox_vertice1 = cv::Point(x_pixel - POI_width, y_pixel - POI_width);
-        cv::Point depthbox_vertice2 = cv::Point(x_pixel + POI_width, y_pixel + POI_width);
-        cv::Rect letsgetdepth(depthbox_vertice1, depthbox_vertice2);
-
-        cv::Mat ROI(depthimage, letsgetdepth);
-        cv::Mat ROIframe;
-        ROI.copyTo(ROIframe);
-        std::vector<cv::Point> nonzeros;
-
-        cv::findNonZero(ROIframe, nonzeros);
-        std::vector<double> nonzerosvalue;
-        for(auto temp : nonzeros)
-        {
-            double depth = ROIframe.at<ushort>(temp);
-            nonzerosvalue.push_back(depth);
-        }
-
-        double depth_average;
-        if(nonzerosvalue.size() != 0)
-            depth_average = accumulate(nonzerosvalue.begin(), nonzerosvalue.end(),0.0)/nonzerosvalue.size();
-
-        double z_depth = 0.001 * depth_average;
-
-        temp.x() = x_pixel;
-        temp.y() = y_pixel;
-        temp.z() = 1;
-
-        temp = z_depth * cameraMat.inverse() * temp;
-
-        
-        pointclouds.push_back(temp);
-    }
+    depth_sampler.backproject(vision::viewDepth(depthimage), pts_2d_detected, pointclouds);
 
     return pointclouds;
 }
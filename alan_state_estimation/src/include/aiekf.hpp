@@ -28,7 +28,9 @@
 
 #include "tools/essential.h"
 #include "cameraModel.hpp"
+#include "tools/stageTracer.hpp"
 #include <sophus/se3.hpp>
+#include <algorithm>
 #include <random>
 
 using namespace std;
@@ -39,12 +41,15 @@ namespace kf
     #define kfREINITIATE 101
     #define kfNORMALKF 102
 
-    typedef struct STATE
+    template<int X_SIZE>
+    struct STATE_FIXED
     {
         Sophus::SE3d X_SE3;
         Sophus::SE3d V_SE3;
-        Eigen::MatrixXd PCov;
-    } STATE;
+        Eigen::Matrix<double, X_SIZE, X_SIZE> PCov;
+    };
+
+    typedef STATE_FIXED<9> STATE;
 
     typedef struct MEASUREMENT
     {
@@ -65,37 +70,64 @@ namespace kf
         double delta_now_then;
     }FINAL_RETURN;
 
-
-    class aiekf : public vision::cameraModel
+    /* filter core, sized at compile time: X_SIZE = se(3) pose + linear velocity, 
+    Z_SIZE = one pixel + linear velocity. every matrix lives on the stack or in the object, 
+    so a call of run_AIEKF() does not touch the heap once the measurement vectors have grown. */
+    template<int X_SIZE, int Z_SIZE>
+    class aiekfCore : public vision::cameraModel
     {
+    public:
+        static const int kfPose_size = Sophus::SE3d::DoF;
+        static const int kfVelo_size = X_SIZE - kfPose_size;
+        static const int kfZPose_size = 2;
+        static const int kfZVelo_size = Z_SIZE - kfZPose_size;
+
+        static_assert(
+            kfVelo_size == 3 && kfZVelo_size == kfVelo_size, 
+            "aiekfCore: state is se(3) pose + 3d velocity, measurement is pixel + 3d velocity"
+        );
+
+        typedef STATE_FIXED<X_SIZE> STATE_T;
+        typedef Eigen::Matrix<double, X_SIZE, X_SIZE> MatX;
+        typedef Eigen::Matrix<double, Z_SIZE, Z_SIZE> MatZ;
+        typedef Eigen::Matrix<double, Z_SIZE, X_SIZE> MatZX;
+        typedef Eigen::Matrix<double, X_SIZE, Z_SIZE> MatXZ;
+        typedef Eigen::Matrix<double, X_SIZE, 1> VecX;
+
     private:
         /* ================ states here ================ */
-        STATE XpreviousPosterori;     // X @ k - 1
-        STATE XprePreviousPosterori;  // X @ k - 2
-        STATE XcurrentDynamicPriori;  // X @ k, priori
-        STATE XoptimizePriori;        // X @ k, priori 
+        STATE_T XpreviousPosterori;     // X @ k - 1
+        STATE_T XprePreviousPosterori;  // X @ k - 2
+        STATE_T XcurrentDynamicPriori;  // X @ k, priori
+        STATE_T XoptimizePriori;        // X @ k, priori 
         MEASUREMENT ZcurrentMeas;   // Z @ k  
 
         /* ================ covariances here ================ */
-        Eigen::MatrixXd F_k;
-        Eigen::MatrixXd H_k;
+        MatX F_k;
+        MatZX H_k;
+
+        MatXZ K_k;
 
-        Eigen::MatrixXd K_k;
+        MatX Q_k;
+        MatZ R_k;
 
-        Eigen::MatrixXd Q_k;
-        Eigen::MatrixXd R_k;
+        // Cholesky factors, R is taken block diagonal (pixel | velocity)
+        Eigen::LLT<Eigen::Matrix<double, kfZPose_size, kfZPose_size>> R_pose_llt;
+        Eigen::LLT<Eigen::Matrix<double, kfZVelo_size, kfZVelo_size>> R_velo_llt;
+        Eigen::LLT<MatX> P_priori_llt;
 
-        std::vector<Eigen::MatrixXd> info_matrix;
+        // velocity and prior terms of the normal equations, their Jacobians are constant
+        MatX H_const;
         
         /* ================ set Predict ================ */
         void setPredict(); // set_XcurrentDynamicPriori
-        Eigen::VectorXd dfx();
+        VecX dfx();
 
         /* ================ set Measurement ================ */
-        void setMeasurement(Sophus::SE3d initial_pose);
+        void setMeasurement(const Sophus::SE3d& initial_pose);
         void setMeasurement(
-            std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
-            std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
+            const std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
+            const std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
         );
         void calculatePtsAverage();
 
@@ -109,43 +141,41 @@ namespace kf
 
         /* ================ NLS Optimization ================ */
         void doOptimize();
-        virtual void setGNBlocks(
-            STATE X_var,
-            Eigen::MatrixXd& JPJt, 
-            Eigen::VectorXd& nJtPf,
-            std::vector<Eigen::MatrixXd> Ps
+        double setLMBlocks(
+            const STATE_T& X_var,
+            MatX& H, 
+            VecX& g
         );
         void setDFJacobianDynamic(
-            Eigen::MatrixXd& Jacob, 
-            STATE X_var,
+            MatX& Jacob, 
+            const STATE_T& X_var,
             bool optimize
         );
         void setDHJacobianCamera(
-            Eigen::MatrixXd& Jacob, 
-            STATE X_var, 
-            Eigen::Vector3d pts_3d
+            Eigen::Matrix<double, kfZPose_size, X_SIZE>& Jacob, 
+            const STATE_T& X_var, 
+            const Eigen::Vector3d& pts_3d
         ); // for pose based on cameramodel
         void setDHJacobianCamera(
-            Eigen::MatrixXd& Jacob
+            Eigen::Matrix<double, kfZVelo_size, X_SIZE>& Jacob
         ); // for velo based on inferred value
 
-        Eigen::VectorXd getCameraPoseResidual(
-            STATE X_var,
-            Eigen::Vector2d pt_2d_detected,
-            Eigen::Vector3d pt_3d_exist
+        Eigen::Vector2d getCameraPoseResidual(
+            const STATE_T& X_var,
+            const Eigen::Vector2d& pt_2d_detected,
+            const Eigen::Vector3d& pt_3d_exist
         );
-        Eigen::VectorXd getCameraVeloResidual(
-            STATE X_var
+        Eigen::Vector3d getCameraVeloResidual(
+            const STATE_T& X_var
         );
-        Eigen::VectorXd getDynamicResidual(STATE pose_priori, STATE pose);
-        double getCost(STATE X);
+        VecX getDynamicResidual(const STATE_T& pose_priori, const STATE_T& pose);
 
         /* ================ set PostOptimize ================ */
         void setPostOptimize();
         void setDHJacobianMeasurement(
-            Eigen::MatrixXd& Jacob, 
-            STATE X_var, 
-            Eigen::Vector3d pts_3d
+            MatZX& Jacob, 
+            const STATE_T& X_var, 
+            const Eigen::Vector3d& pts_3d
         ); // final jacobian for propagation
         void setKalmanGain();
         void setPosterioriCovariance();
@@ -157,35 +187,40 @@ namespace kf
         int veloMeasureIndi = 0;
         double deltaT = 0;
         Eigen::Vector3d gravity = {0,0,-9.81};
-        Eigen::Matrix3d skewSymmetricMatrix(const Eigen::Vector3d w);
+        Eigen::Matrix3d skewSymmetricMatrix(const Eigen::Vector3d& w);
         std::default_random_engine generator;
         std::normal_distribution<double> dist;
 
     public:
-        aiekf(){};
-        ~aiekf(){
-            std::cout<<"EXIT AIEKF"<<std::endl;
-        };
-        STATE XcurrentPosterori;      // X @ k
+        aiekfCore(){};
+        ~aiekfCore(){};
+        STATE_T XcurrentPosterori;      // X @ k
 
         /* ================ main flow ================ */
-        void initKF(Sophus::SE3d pose_initial_sophus);
-        void reinitKF(Sophus::SE3d pose_reinitial_sophus);
+        Sophus::SE3d getPosePriori(double deltaT_);
+        static Sophus::SE3d extrapolate(
+            const Sophus::SE3d& pose, 
+            const Sophus::SE3d& velo, 
+            double deltaT_
+        );
+
+        void initKF(const Sophus::SE3d& pose_initial_sophus, const MatX& Q, const MatZ& R);
+        // velo: a track picked up again keeps its motion, identity is at rest
+        void reinitKF(
+            const Sophus::SE3d& pose_reinitial_sophus, 
+            const MatX& Q, 
+            const MatZ& R, 
+            const Sophus::SE3d& velo = Sophus::SE3d()
+        );
         void run_AIEKF(
             double deltaT_,
-            std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
-            std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
+            const std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
+            const std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
         );
 
         bool kf_initiated = false; 
 
         // for derived classes:        
-        int kf_size;
-        int kfZ_size;
-        int kfZPose_size = 2;
-        int kfZVelo_size = 3;
-        Eigen::MatrixXd Q_init;
-        Eigen::MatrixXd R_init;
         double velo_IIR_alpha = 0.1;
         double QAdaptiveAlpha = 0;
         double RAdaptiveBeta = 0;   
@@ -193,12 +228,80 @@ namespace kf
         int MAX_ITERATION = 0;
         double CONVERGE_THRESHOLD = 0;
 
+        // LM: initial damping, relative to diag(H), and what the last frame took
+        double LM_tau = 1e-5;
+        int LM_iterations = 0;
+        int LM_rejected = 0;
+        double LM_cost = 0;     // half the weighted squared residual before the last step
+
         bool KF_ON;
+
+        // predict / optimize / update spans, none if null
+        vision::stageTracer* tracer = nullptr;
     };
+
+    // runtime-sized front of aiekfCore<9,5>, the sizes and noise come from the yaml
+    class aiekf : public aiekfCore<9, 5>
+    {
+    private:
+        bool checkSize();
+
+    public:
+        aiekf(){};
+        ~aiekf(){
+            std::cout<<"EXIT AIEKF"<<std::endl;
+        };
+
+        void initKF(Sophus::SE3d pose_initial_sophus);
+        void reinitKF(Sophus::SE3d pose_reinitial_sophus, const Sophus::SE3d& velo = Sophus::SE3d());
+
+        // for derived classes:
+        int kf_size;
+        int kfZ_size;
+        Eigen::MatrixXd Q_init;
+        Eigen::MatrixXd R_init;
+    };
+}
+
+/*=======runtime-sized front=======*/
+inline bool kf::aiekf::checkSize()
+{
+    if(
+        kf_size != MatX::RowsAtCompileTime || kfZ_size != MatZ::RowsAtCompileTime
+        || Q_init.rows() != kf_size || Q_init.cols() != kf_size
+        || R_init.rows() != kfZ_size || R_init.cols() != kfZ_size
+    )
+    {
+        ROS_RED_STREAM("KF DIMENSION DOES NOT MATCH!!!");
+        return false;
+    }
+
+    return true;
+}
+
+inline void kf::aiekf::initKF(Sophus::SE3d pose_initial_sophus)
+{
+    if(!checkSize())
+        return;
+
+    aiekfCore::initKF(pose_initial_sophus, Q_init, R_init);
+}
+
+inline void kf::aiekf::reinitKF(Sophus::SE3d pose_reinitial_sophus, const Sophus::SE3d& velo)
+{
+    if(!checkSize())
+        return;
+
+    aiekfCore::reinitKF(pose_reinitial_sophus, Q_init, R_init, velo);
 }
 
 /*=======main flow=======*/
-void kf::aiekf::initKF(Sophus::SE3d pose_initial_sophus)
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::initKF(
+    const Sophus::SE3d& pose_initial_sophus, 
+    const MatX& Q, 
+    const MatZ& R
+)
 {
     // ROS_GREEN_STREAM("initKF");
     setMeasurement(pose_initial_sophus);
@@ -211,18 +314,11 @@ void kf::aiekf::initKF(Sophus::SE3d pose_initial_sophus)
         Eigen::Vector3d::Zero()
     );
 
-    XcurrentPosterori.PCov.resize(kf_size, kf_size);
     XcurrentPosterori.PCov.setIdentity();
-    XcurrentPosterori.PCov = XcurrentPosterori.PCov * R_init(0,0);
-
-    if(kf_size != Q_init.rows())
-    {
-        ROS_RED_STREAM("KF DIMENSION DOES NOT MATCH!!!");
-        return;
-    }
+    XcurrentPosterori.PCov = XcurrentPosterori.PCov * R(0,0);
             
-    Q_k = this->Q_init;
-    R_k = this->R_init;
+    Q_k = Q;
+    R_k = R;
 
     XpreviousPosterori = XcurrentPosterori;
 
@@ -232,59 +328,90 @@ void kf::aiekf::initKF(Sophus::SE3d pose_initial_sophus)
     dist = std::normal_distribution<double>(0,0.01);
 }
 
-void kf::aiekf::reinitKF(Sophus::SE3d pose_reinitial_sophus)
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::reinitKF(
+    const Sophus::SE3d& pose_reinitial_sophus, 
+    const MatX& Q, 
+    const MatZ& R,
+    const Sophus::SE3d& velo
+)
 {
     setMeasurement(pose_reinitial_sophus);
     
     veloMeasureIndi = 0;
 
     XcurrentPosterori.X_SE3 = ZcurrentMeas.pose_initial_SE3;
-    XcurrentPosterori.V_SE3 = Sophus::SE3d(
-        Eigen::Matrix3d::Identity(),
-        Eigen::Vector3d::Zero()
-    );
-    XcurrentPosterori.PCov = XcurrentPosterori.PCov * R_init(0,0);
+    XcurrentPosterori.V_SE3 = velo;
+    XcurrentPosterori.PCov = XcurrentPosterori.PCov * R(0,0);
 
-    Q_k = Q_init;
-    R_k = R_init;
+    Q_k = Q;
+    R_k = R;
 
     XpreviousPosterori = XcurrentPosterori;
 }
 
-void kf::aiekf::run_AIEKF(
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::run_AIEKF(
     double deltaT_,
-    std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
-    std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
+    const std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
+    const std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
 )
 {
     // ROS_GREEN_STREAM("runAIEKF");
     this->deltaT = deltaT_;
 
-    setPredict(); 
+    {
+        TRACE_SPAN(tracer, vision::TRACE_KF_PREDICT);
+        setPredict(); 
+    }
 
-    setMeasurement(pts_on_body_frame_in_corres_order,pts_detected_in_corres_order);
-    
-    setPreOptimize();
-    
-    doOptimize();
-    
-    setPostOptimize();
-    
+    {
+        TRACE_SPAN(tracer, vision::TRACE_KF_OPTIMIZE);
+        setMeasurement(pts_on_body_frame_in_corres_order,pts_detected_in_corres_order);
+        setPreOptimize();
+        doOptimize();
+    }
+
+    {
+        TRACE_SPAN(tracer, vision::TRACE_KF_UPDATE);
+        setPostOptimize();
+    }
+}
+
+template<int X_SIZE, int Z_SIZE>
+Sophus::SE3d kf::aiekfCore<X_SIZE, Z_SIZE>::getPosePriori(double deltaT_)
+{
+    return extrapolate(XcurrentPosterori.X_SE3, XcurrentPosterori.V_SE3, deltaT_);
+}
+
+template<int X_SIZE, int Z_SIZE>
+Sophus::SE3d kf::aiekfCore<X_SIZE, Z_SIZE>::extrapolate(
+    const Sophus::SE3d& pose, 
+    const Sophus::SE3d& velo, 
+    double deltaT_
+)
+{
+    // constant velocity extrapolation, same model as setPredict()
+    return Sophus::SE3d(
+        Eigen::Matrix3d::Identity(),
+        velo.translation() * deltaT_
+    ) * pose;
 }
 
 /*=======set Predict=======*/
-void kf::aiekf::setPredict()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setPredict()
 {
     // ROS_GREEN_STREAM("setPredict");
 
-    Eigen::VectorXd dx = dfx() * deltaT; // first 6 element: se(3) of pose
-                                   // last 3 element: velocity
+    const VecX dx = dfx() * deltaT; // first 6 element: se(3) of pose
+                                    // last 3 element: velocity
 
     XcurrentDynamicPriori.X_SE3 = 
-        Sophus::SE3d::exp(dx.head(6)) * XpreviousPosterori.X_SE3 ;
+        Sophus::SE3d::exp(dx.template head<kfPose_size>()) * XpreviousPosterori.X_SE3 ;
 
     XcurrentDynamicPriori.V_SE3 = 
-        XpreviousPosterori.V_SE3 * Sophus::SE3d(Eigen::Matrix3d::Identity(), dx.tail(3));
+        XpreviousPosterori.V_SE3 * Sophus::SE3d(Eigen::Matrix3d::Identity(), dx.template tail<kfVelo_size>());
 
     setDFJacobianDynamic(
         F_k,
@@ -292,51 +419,52 @@ void kf::aiekf::setPredict()
         false
     );
 
-    XcurrentDynamicPriori.PCov = 
+    XcurrentDynamicPriori.PCov.noalias() = 
         F_k * XpreviousPosterori.PCov * F_k.transpose() + F_k * Q_k * F_k.transpose();
 }
 
-Eigen::VectorXd kf::aiekf::dfx()
+template<int X_SIZE, int Z_SIZE>
+typename kf::aiekfCore<X_SIZE, Z_SIZE>::VecX kf::aiekfCore<X_SIZE, Z_SIZE>::dfx()
 {
     // x_dot = Ax here  
     // i.e., give x_dot here, basically (in se(3))
-    Eigen::VectorXd returnDfx; // first 6 element: se(3) of pose
-                               // last 3 element: velocity 
-    returnDfx.resize(kf_size);
-    
-    XpreviousPosterori.V_SE3.log();
+    VecX returnDfx; // first 6 element: se(3) of pose
+                    // last 3 element: velocity 
     
-    returnDfx.head(Sophus::SE3d::DoF) = 
+    returnDfx.template head<kfPose_size>() = 
         Sophus::SE3d(
             Eigen::Matrix3d::Identity(),
             XpreviousPosterori.V_SE3.translation()
         ).log();
     
-    returnDfx.tail<Sophus::SE3d::DoF/2>() = Sophus::SE3d(
+    returnDfx.template tail<kfVelo_size>() = Sophus::SE3d(
         Eigen::Matrix3d::Identity(), 
         XpreviousPosterori.X_SE3.rotationMatrix() 
             * (- gravity + Eigen::Vector3d(0,0,dist(generator)))
             + gravity
-    ).log().head(3);
+    ).log().template head<3>();
 
     return returnDfx;
 }
 
 /*=======set Measurement=======*/
-void kf::aiekf::setMeasurement(Sophus::SE3d initial_pose)
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setMeasurement(const Sophus::SE3d& initial_pose)
 {
     // ROS_GREEN_STREAM("setMeasurementInitial");
     ZcurrentMeas.pose_initial_SE3 = initial_pose;
 };
 
-void kf::aiekf::setMeasurement(
-    std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
-    std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setMeasurement(
+    const std::vector<Eigen::Vector3d>& pts_on_body_frame_in_corres_order,
+    const std::vector<Eigen::Vector2d>& pts_detected_in_corres_order
 )
 {
     // ROS_GREEN_STREAM("setMeasurementNormal");
-    ZcurrentMeas.pts_3d_exists = pts_on_body_frame_in_corres_order;
-    ZcurrentMeas.pts_2d_detected = pts_detected_in_corres_order;
+    // assign() keeps the capacity of the previous frame
+    ZcurrentMeas.pts_3d_exists.assign(pts_on_body_frame_in_corres_order.begin(), pts_on_body_frame_in_corres_order.end());
+    ZcurrentMeas.pts_2d_detected.assign(pts_detected_in_corres_order.begin(), pts_detected_in_corres_order.end());
     calculatePtsAverage();
 
     if(veloMeasureIndi == 0)
@@ -374,7 +502,8 @@ void kf::aiekf::setMeasurement(
     }
 }
 
-void kf::aiekf::calculatePtsAverage()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::calculatePtsAverage()
 {
     int n = ZcurrentMeas.pts_3d_exists.size();
     if(n != ZcurrentMeas.pts_2d_detected.size())
@@ -399,236 +528,221 @@ void kf::aiekf::calculatePtsAverage()
 }
 
 /*=======set PreOptimize=======*/
-void kf::aiekf::setPreOptimize()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setPreOptimize()
 {
     // ROS_GREEN_STREAM("setPreOptimize");
     XoptimizePriori = XcurrentDynamicPriori;
 
-    info_matrix.clear();
-    info_matrix.emplace_back(R_k.inverse());
-    info_matrix.emplace_back(XcurrentDynamicPriori.PCov.inverse());
+    R_pose_llt.compute(R_k.template topLeftCorner<kfZPose_size, kfZPose_size>());
+    R_velo_llt.compute(R_k.template bottomRightCorner<kfZVelo_size, kfZVelo_size>());
+    P_priori_llt.compute(XcurrentDynamicPriori.PCov);
+
+    // d(e_velo)/dx = -[0 I], d(e_dyn)/dx = -I: J^T W J does not change over the iterations
+    H_const.setZero();
+
+    if(KF_ON)
+    {
+        H_const.template bottomRightCorner<kfZVelo_size, kfZVelo_size>() = 
+            R_velo_llt.solve(Eigen::Matrix<double, kfZVelo_size, kfZVelo_size>::Identity());
+        H_const += P_priori_llt.solve(MatX::Identity());
+    }
 }
 
 /*=======NLS Optimization=======*/
-void kf::aiekf::doOptimize()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::doOptimize()
 {
-    Eigen::MatrixXd JPJt; //R9*9
-    JPJt.resize(kf_size,kf_size);
-    Eigen::VectorXd nJtPf; // R9
-    nJtPf.resize(kf_size);
-
-    Eigen::Matrix<double, 9, 1> dx;
-    Sophus::Vector6d dx_pose_se3;
+    /* damped Gauss-Newton (Levenberg-Marquardt, Nielsen's damping update):
+    (H + mu D) dx = -g, a step is kept only if the weighted cost drops.
+    the residuals evaluated for a trial cost also give H and g there, 
+    so an accepted step needs no second pass. */
+    MatX H, H_trial;
+    VecX g, g_trial;
+    VecX D, dx;
     Sophus::Vector6d dx_velo_se3;
 
-    STATE X_var = XoptimizePriori;
+    STATE_T X_var = XoptimizePriori;
+    STATE_T X_trial;
 
-    int i = 0;
-    double cost = 0, lastcost = INFINITY;
+    Eigen::LLT<MatX> H_llt;
 
-    // ROS_BLUE_STREAM("OPTIMIZATION METRIC:...");
+    double cost = setLMBlocks(X_var, H, g);
+    double mu = LM_tau;
+    double nu = 2;
 
-    // std::cout<<"before cam residual:  "<<get_reprojection_error(
-    //     ZcurrentMeas.pts_3d_exists,
-    //     ZcurrentMeas.pts_2d_detected,
-    //     X_var.X_SE3,
-    //     false
-    // )<<std::endl;;
-    // std::cout<<"before dyn residual: "
-    //     <<getDynamicResidual(
-    //         XcurrentDynamicPriori,
-    //         X_var
-    //     ).norm()
-    //     <<std::endl<<std::endl;
+    LM_iterations = 0;
+    LM_rejected = 0;
 
     /* ================================================================= */
-    double t0 = ros::Time::now().toSec();
-    for(i = 0; i < MAX_ITERATION; i++)
+    for(int i = 0; i < MAX_ITERATION; i++)
     {    
-        setGNBlocks(
-            X_var,
-            JPJt, 
-            nJtPf,
-            info_matrix
-        );
-
-        //solve Adx = b
-        dx = JPJt.ldlt().solve(nJtPf);
-
-        if(isnan(dx(0,0)))
-            break;
+        LM_iterations++;
 
-        dx_pose_se3 = dx.head(6);
-        dx_velo_se3 << dx.tail(3), Eigen::Vector3d::Zero();
+        //solve (H + mu D) dx = -g, D = diag(H): pixel and velocity terms differ by orders of magnitude,
+        //floored for the velocity block left empty with KF_ON off
+        D = H.diagonal().cwiseMax(1e-6);
+        H_trial = H;
+        H_trial.diagonal() += mu * D;
+        H_llt.compute(H_trial);
 
-        X_var.X_SE3 =  Sophus::SE3d::exp(dx_pose_se3) * X_var.X_SE3 ;
-        X_var.V_SE3 = Sophus::SE3d::exp(dx_velo_se3) * X_var.V_SE3;
-
-        cost = getCost(X_var);
-
-        if(cost > lastcost)
+        if(H_llt.info() != Eigen::Success)
         {
-            // ROS_RED_STREAM("OPTIMIZATION DIVERGE!!!");
-            // break;
+            mu *= nu;
+            nu *= 2;
+            LM_rejected++;
+            continue;
         }
-        lastcost = cost;
 
-        if(dx.norm() < CONVERGE_THRESHOLD)        
+        dx = -H_llt.solve(g);
+
+        if(!dx.allFinite())
             break;
-    }
 
-    XcurrentPosterori = X_var;
-    /* ================================================================= */
+        dx_velo_se3 << dx.template tail<kfVelo_size>(), Eigen::Vector3d::Zero();
 
-    // double e1 = get_reprojection_error(
-    //     ZcurrentMeas.pts_3d_exists,
-    //     ZcurrentMeas.pts_2d_detected,
-    //     X_var.X_SE3,
-    //     false
-    // );
+        X_trial.X_SE3 = Sophus::SE3d::exp(dx.template head<kfPose_size>()) * X_var.X_SE3;
+        X_trial.V_SE3 = Sophus::SE3d::exp(dx_velo_se3) * X_var.V_SE3;
 
-    // double e2 = getDynamicResidual(
-    //     XcurrentDynamicPriori,
-    //     X_var
-    // ).norm();
+        // converged, the last small step is taken without another linearization
+        if(dx.norm() < CONVERGE_THRESHOLD)
+        {
+            X_var.X_SE3 = X_trial.X_SE3;
+            X_var.V_SE3 = X_trial.V_SE3;
+            break;
+        }
 
-    // std::cout<<"\nafter cam residual: "<<e1<<std::endl;
-    // std::cout<<"after dyn residual: "<<e2<<std::endl<<std::endl;
+        const double cost_trial = setLMBlocks(X_trial, H_trial, g_trial);
 
-    // std::cout<<"=================================="<<std::endl<<std::endl;
+        // actual over predicted decrease, the quadratic model predicts dx^T (mu D dx - g) / 2
+        const double predicted = 0.5 * dx.dot(mu * D.cwiseProduct(dx) - g);
+        const double rho = (cost - cost_trial) / predicted;
 
-    // std::cout<<"gone thru: "<<i<<" th, end optimize"<<std::endl<<std::endl;;;
-    // std::cout<<"dx.norm():\n "<<dx.norm()<<std::endl<<dx<<std::endl;
-    // std::cout<<"=================================="<<std::endl<<std::endl;
+        if(predicted > 0 && rho > 0)
+        {
+            X_var.X_SE3 = X_trial.X_SE3;
+            X_var.V_SE3 = X_trial.V_SE3;
+            H = H_trial;
+            g = g_trial;
+            cost = cost_trial;
+
+            mu *= std::max(1.0 / 3.0, 1 - std::pow(2 * rho - 1, 3));
+            nu = 2;
+        }
+        else
+        {
+            mu *= nu;
+            nu *= 2;
+            LM_rejected++;
+        }
+    }
+
+    LM_cost = cost;
 
+    XcurrentPosterori.X_SE3 = X_var.X_SE3;
+    XcurrentPosterori.V_SE3 = X_var.V_SE3;
+    /* ================================================================= */
 }
 
-void kf::aiekf::setGNBlocks(
-    STATE X_var,
-    Eigen::MatrixXd& JPJt,
-    Eigen::VectorXd& nJtPf,
-    vector<Eigen::MatrixXd> Ps
+template<int X_SIZE, int Z_SIZE>
+double kf::aiekfCore<X_SIZE, Z_SIZE>::setLMBlocks(
+    const STATE_T& X_var,
+    MatX& H,
+    VecX& g
 )
 {
-    Eigen::MatrixXd JCamWRTPose;
-    Eigen::MatrixXd JCamWRTVelo;
-    Eigen::MatrixXd JDynWRTXNow;
+    // returns half the weighted squared cost at X_var, H = J^T W J, g = J^T W e
+    Eigen::Matrix<double, 2, 6> JCam;
+    Eigen::Vector2d eCamPose; // R2
+    Eigen::Vector3d eCamVelo; // R3
+    VecX eDyn; // R9
 
-    Eigen::VectorXd eCamPose; // R2
-    Eigen::VectorXd eCamVelo; // R3
-    Eigen::VectorXd eDyn; // R9
+    double cost = 0;
 
-    JPJt.setZero();
-    nJtPf.setZero();
+    H = H_const;
+    g.setZero();
 
-    for(int i = 0; i < ZcurrentMeas.pts_3d_exists.size(); i++)
+    const auto L_pose = R_pose_llt.matrixL();
+
+    for(int i = 0; i < (int)ZcurrentMeas.pts_3d_exists.size(); i++)
     {
-        // camera pose linear system
-        setDHJacobianCamera(
-            JCamWRTPose,
-            X_var,
+        // camera pose, only the 6 pose columns are non-zero: e = z - h(x), de/dx = -dh/dx
+        solveJacobianCamera(
+            JCam,
+            X_var.X_SE3,
             ZcurrentMeas.pts_3d_exists[i]
         );
 
-        JCamWRTPose *= (-1);
-
         eCamPose = getCameraPoseResidual(
             X_var,
             ZcurrentMeas.pts_2d_detected[i],
             ZcurrentMeas.pts_3d_exists[i]
         );
 
-        JPJt += JCamWRTPose.transpose() * Ps[0].block<2,2>(0,0) * JCamWRTPose;
-        nJtPf += -JCamWRTPose.transpose() * Ps[0].block<2,2>(0,0) * eCamPose;
-    }
-
-
-    for(int i = 0; i < 1; i ++)
-    {
-        // camera velo linear system
-        setDHJacobianCamera(
-            JCamWRTVelo          
-        );
-
-        JCamWRTVelo *= (-1);
-
-        eCamVelo = getCameraVeloResidual(
-            X_var
-        );
+        // whiten with R = L L^T
+        L_pose.solveInPlace(JCam);
+        L_pose.solveInPlace(eCamPose);
 
-        if(KF_ON)
-        {
-            JPJt += JCamWRTVelo.transpose() * Ps[0].block<3,3>(2,2) * JCamWRTVelo;
-            nJtPf += -JCamWRTVelo.transpose() * Ps[0].block<3,3>(2,2) * eCamVelo;       
-        }
+        H.template topLeftCorner<kfPose_size, kfPose_size>().noalias() += JCam.transpose() * JCam;
+        g.template head<kfPose_size>().noalias() -= JCam.transpose() * eCamPose;
+        cost += eCamPose.squaredNorm();
     }
 
-    for(int i = 0; i < 1; i ++)
+    if(KF_ON)
     {
-        // dynamic pose + velo linear system
-        setDFJacobianDynamic(
-            JDynWRTXNow,
-            X_var,
-            true
-        );
+        // camera velo
+        eCamVelo = getCameraVeloResidual(X_var);
+        const Eigen::Vector3d WeCamVelo = R_velo_llt.solve(eCamVelo);
 
-        JDynWRTXNow *= (-1);
+        g.template tail<kfVelo_size>() -= WeCamVelo;
+        cost += eCamVelo.dot(WeCamVelo);
 
+        // dynamic pose + velo
         eDyn = getDynamicResidual(
             XcurrentDynamicPriori,
             X_var
         );
-        
-        if(KF_ON)
-        {
-            JPJt += JDynWRTXNow.transpose() * Ps[1] * JDynWRTXNow;
-            nJtPf += -JDynWRTXNow.transpose() * Ps[1] * eDyn;     
-        }
+        const VecX WeDyn = P_priori_llt.solve(eDyn);
+
+        g -= WeDyn;
+        cost += eDyn.dot(WeDyn);
     }
 
+    return 0.5 * cost;
 }
 
-void kf::aiekf::setDFJacobianDynamic(
-    Eigen::MatrixXd& Jacob,
-    STATE X_var,
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setDFJacobianDynamic(
+    MatX& Jacob,
+    const STATE_T& X_var,
     bool at_optimize
 )
 {
-    Jacob.resize(kf_size, kf_size);
+    Jacob.setIdentity();
+
     if(at_optimize)
-    {
-        Jacob.setIdentity();
         return;
-    }
-        
-    Jacob.setZero();
-
-    Jacob.setIdentity();
-    // Jacob.block<3,3>(0,0).setIdentity();
-    // Jacob.block<3,3>(3,3).setIdentity();
-    // Jacob.block<3,3>(6,6).setIdentity();
 
-    Jacob.block<3,3>(0,6).setIdentity();
-    Jacob.block<3,3>(0,6) *= deltaT;
-    //  .setConstant(deltaT);
+    Jacob.template block<3,3>(0,6).setIdentity();
+    Jacob.template block<3,3>(0,6) *= deltaT;
 
-    Jacob.block<3,3>(6,3) = 
+    Jacob.template block<3,3>(6,3) = 
         -1.0 * 
         skewSymmetricMatrix(X_var.X_SE3.rotationMatrix() * (-gravity) );
 
-    Jacob.block<3,3>(6,3) *= deltaT;
+    Jacob.template block<3,3>(6,3) *= deltaT;
 }
 
-void kf::aiekf::setDHJacobianCamera(
-    Eigen::MatrixXd& Jacob,
-    STATE X_var,
-    Eigen::Vector3d pts_3d_exists
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setDHJacobianCamera(
+    Eigen::Matrix<double, kfZPose_size, X_SIZE>& Jacob,
+    const STATE_T& X_var,
+    const Eigen::Vector3d& pts_3d_exists
 )
 {
-    Jacob.resize(2,9);
     Jacob.setZero();
 
-    Eigen::MatrixXd JCam_temp;
+    Eigen::Matrix<double, 2, 6> JCam_temp;
 
     solveJacobianCamera(
         JCam_temp, 
@@ -636,90 +750,57 @@ void kf::aiekf::setDHJacobianCamera(
         pts_3d_exists
     );
 
-    Jacob.block<2,6>(0,0) = JCam_temp;
+    Jacob.template block<2,6>(0,0) = JCam_temp;
 }
 
-void kf::aiekf::setDHJacobianCamera(
-    Eigen::MatrixXd& Jacob
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setDHJacobianCamera(
+    Eigen::Matrix<double, kfZVelo_size, X_SIZE>& Jacob
 )
 {
     // set DH wrt image measurement
-    Jacob.resize(kfZVelo_size, kf_size);
     Jacob.setZero();
-    Jacob.block<3,3>(0,6).setIdentity(); 
+    Jacob.template block<3,3>(0,6).setIdentity(); 
 }
 
-Eigen::VectorXd kf::aiekf::getCameraPoseResidual(
-    STATE X_var,
-    Eigen::Vector2d pt_2d_detected,
-    Eigen::Vector3d pt_3d_exist
+template<int X_SIZE, int Z_SIZE>
+Eigen::Vector2d kf::aiekfCore<X_SIZE, Z_SIZE>::getCameraPoseResidual(
+    const STATE_T& X_var,
+    const Eigen::Vector2d& pt_2d_detected,
+    const Eigen::Vector3d& pt_3d_exist
 )
 {
-    Eigen::VectorXd eCam;
-    eCam.resize(kfZPose_size);
-    
-    eCam = pt_2d_detected - reproject_3D_2D(
+    return pt_2d_detected - reproject_3D_2D(
         pt_3d_exist,
         X_var.X_SE3
     );
-
-    return eCam;
 }
 
-Eigen::VectorXd kf::aiekf::getCameraVeloResidual(
-    STATE X_var
+template<int X_SIZE, int Z_SIZE>
+Eigen::Vector3d kf::aiekfCore<X_SIZE, Z_SIZE>::getCameraVeloResidual(
+    const STATE_T& X_var
 )
 {
-    Eigen::VectorXd eCam;
-    eCam.resize(kfZVelo_size);
-
-    eCam = (ZcurrentMeas.velo_initial_SE3 * X_var.V_SE3.inverse()).log().head(3);
-    
-    return eCam;
+    return (ZcurrentMeas.velo_initial_SE3 * X_var.V_SE3.inverse()).log().template head<3>();
 }
 
-Eigen::VectorXd kf::aiekf::getDynamicResidual(
-    STATE priori_X,
-    STATE X
+template<int X_SIZE, int Z_SIZE>
+typename kf::aiekfCore<X_SIZE, Z_SIZE>::VecX kf::aiekfCore<X_SIZE, Z_SIZE>::getDynamicResidual(
+    const STATE_T& priori_X,
+    const STATE_T& X
 )
 {
-    Eigen::VectorXd returnResidual;
+    VecX returnResidual;
 
-    const int posSize = X.X_SE3.log().size() / 2;
-    const int angSize = X.X_SE3.log().size() / 2;
-    const int velSize  = X.V_SE3.log().head(3).size();
-    
-    returnResidual.resize(
-        X.X_SE3.log().size() + 
-        X.V_SE3.log().head<3>().size()
-    );
-
-    returnResidual.head(posSize + angSize) = (priori_X.X_SE3 * X.X_SE3.inverse()).log();
-    returnResidual.tail(velSize) = (priori_X.V_SE3 * X.V_SE3.inverse()).log().head(velSize);
+    returnResidual.template head<kfPose_size>() = (priori_X.X_SE3 * X.X_SE3.inverse()).log();
+    returnResidual.template tail<kfVelo_size>() = (priori_X.V_SE3 * X.V_SE3.inverse()).log().template head<kfVelo_size>();
 
     return returnResidual;
 }
 
-double kf::aiekf::getCost(STATE X)
-{
-    double eTotal = 0;
-    
-    for(int i = 0; i < ZcurrentMeas.pts_3d_exists.size(); i++)
-    {
-        eTotal = eTotal + getCameraPoseResidual(
-            X,
-            ZcurrentMeas.pts_2d_detected[i],
-            ZcurrentMeas.pts_3d_exists[i]
-        ).norm();
-    }
-
-    eTotal += (getDynamicResidual(XcurrentDynamicPriori, X).norm() + getCameraVeloResidual(X).norm());
-
-    return eTotal;
-}
-
 /*=======set PostOptimize=======*/
-void kf::aiekf::setPostOptimize()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setPostOptimize()
 {
     setDHJacobianMeasurement(H_k, XcurrentPosterori, ZcurrentMeas.mean3d);
     setKalmanGain(); // R 9*5
@@ -730,56 +811,56 @@ void kf::aiekf::setPostOptimize()
     // setAdaptiveR();
 }
 
-void kf::aiekf::setDHJacobianMeasurement(
-    Eigen::MatrixXd& Jacob, 
-    STATE X_var, 
-    Eigen::Vector3d pts_3d
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setDHJacobianMeasurement(
+    MatZX& Jacob, 
+    const STATE_T& X_var, 
+    const Eigen::Vector3d& pts_3d
 )
 {
-    Jacob.resize(kfZ_size, kf_size);
-    Jacob.setZero();
-
-    Eigen::MatrixXd Jacob_camera_pose; // R2*9
+    Eigen::Matrix<double, kfZPose_size, X_SIZE> Jacob_camera_pose; // R2*9
     setDHJacobianCamera(Jacob_camera_pose, X_var, pts_3d);
 
-    Eigen::MatrixXd Jacob_camera_velo; // R3*9
+    Eigen::Matrix<double, kfZVelo_size, X_SIZE> Jacob_camera_velo; // R3*9
     setDHJacobianCamera(Jacob_camera_velo);
 
-    Jacob.block<2,9>(0,0) = Jacob_camera_pose;
-    Jacob.block<3,9>(2,0) = Jacob_camera_velo;
-
-    // std::cout<<Jacob<<std::endl;
+    Jacob.template topRows<kfZPose_size>() = Jacob_camera_pose;
+    Jacob.template bottomRows<kfZVelo_size>() = Jacob_camera_velo;
 }
 
-void kf::aiekf::setKalmanGain()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setKalmanGain()
 {
-    K_k = XcurrentDynamicPriori.PCov // R 9*9
-        * H_k.transpose()            // R 9*5
-        * (H_k * XcurrentDynamicPriori.PCov * H_k.transpose() + R_k).inverse(); // R 5*5
+    const MatZ S = H_k * XcurrentDynamicPriori.PCov * H_k.transpose() + R_k; // R 5*5
+
+    // K = P H^T S^-1, i.e. K^T = S^-1 H P with both symmetric
+    K_k = S.llt().solve(H_k * XcurrentDynamicPriori.PCov).transpose();
     
     // K_k -> R 9*5        
 }
 
-void kf::aiekf::setPosterioriCovariance()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setPosterioriCovariance()
 {
-    Eigen::MatrixXd E;
-    E.resize(kf_size, kf_size);
-    E.setIdentity();
+    const MatX IKH = MatX::Identity() - K_k * H_k;
 
-    XcurrentPosterori.PCov = 
-            (E - K_k * H_k) * XcurrentDynamicPriori.PCov * (E - K_k * H_k).transpose()
+    XcurrentPosterori.PCov.noalias() = 
+            IKH * XcurrentDynamicPriori.PCov * IKH.transpose()
         +   K_k * R_k * K_k.transpose();
 }
 
-void kf::aiekf::setMisc()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setMisc()
 {
     XprePreviousPosterori = XpreviousPosterori;
     XpreviousPosterori = XcurrentPosterori;
 }
 
-void kf::aiekf::setAdaptiveQ()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setAdaptiveQ()
 {
-    Eigen::Vector2d innovation;
+    Eigen::Matrix<double, Z_SIZE, 1> innovation;
+    innovation.setZero();
     // innovation = get_reprojection_error(
     //     ZcurrentMeas.pts_3d_exists,
     //     ZcurrentMeas.pts_2d_detected,
@@ -794,7 +875,8 @@ void kf::aiekf::setAdaptiveQ()
 
 }
 
-void kf::aiekf::setAdaptiveR()
+template<int X_SIZE, int Z_SIZE>
+void kf::aiekfCore<X_SIZE, Z_SIZE>::setAdaptiveR()
 {
     Eigen::Vector2d residual;
     // residual = get_reprojection_error(
@@ -807,11 +889,12 @@ void kf::aiekf::setAdaptiveR()
 
 
 /*=======utilities=======*/
-Eigen::Matrix3d kf::aiekf::skewSymmetricMatrix(const Eigen::Vector3d w)
+template<int X_SIZE, int Z_SIZE>
+Eigen::Matrix3d kf::aiekfCore<X_SIZE, Z_SIZE>::skewSymmetricMatrix(const Eigen::Vector3d& w)
 {
   Eigen::Matrix3d Omega;
   Omega << 0, -w(2), w(1), w(2), 0, -w(0), -w(1), w(0), 0;
   return Omega;
 }
 
-#endif
\ No newline at end of file
+#endif
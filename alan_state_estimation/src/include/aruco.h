@@ -36,9 +36,6 @@
 #include <image_transport/image_transport.h>
 #include <cv_bridge/cv_bridge.h>
 #include <sensor_msgs/image_encodings.h>
-#include <message_filters/subscriber.h>
-#include <message_filters/synchronizer.h>
-#include <message_filters/sync_policies/approximate_time.h>
 #include <sensor_msgs/Image.h>
 
 #include <opencv2/aruco.hpp>
@@ -55,6 +52,9 @@
 
 #include "tools/RosTopicConfigs.h"
 #include "alan_state_estimation/alan_log.h"
+#include "poseRefine.hpp"
+#include "depthSampler.hpp"
+#include "tools/stampSync.hpp"
 
 // map definition for convinience
 #define COLOR_SUB_TOPIC CAMERA_SUB_TOPIC_A
@@ -83,11 +83,7 @@ namespace alan
             image_transport::Publisher pubimage;
             
             //subscriber
-            message_filters::Subscriber<sensor_msgs::CompressedImage> subimage;
-            message_filters::Subscriber<sensor_msgs::Image> subdepth;
-            typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::CompressedImage, sensor_msgs::Image> MySyncPolicy;
-            typedef message_filters::Synchronizer<MySyncPolicy> sync;//(MySyncPolicy(10), subimage, subdepth);
-            boost::shared_ptr<sync> sync_;
+            vision::stampSync<sensor_msgs::CompressedImage, sensor_msgs::Image> cam_sync;
             
             //pose-processing            
             void ugv_pose_callback(const geometry_msgs::PoseStamped::ConstPtr& pose);
@@ -117,6 +113,8 @@ namespace alan
             cv::Mat frame;
             std::vector<Eigen::Vector3d> body_frame_pts;
             Eigen::MatrixXd cameraMat = Eigen::MatrixXd::Zero(3,3);
+            vision::poseRefiner pose_refiner;
+            vision::depthSampler depth_sampler;
             std_msgs::Bool test;
             geometry_msgs::PoseStamped pose_estimated;
             bool add_noise = false;       
@@ -146,10 +144,6 @@ namespace alan
 
             bool aruco_detect(cv::Mat& frame, std::vector<Eigen::Vector2d>& pts_2d);
 
-            void solveJacobian(Eigen::Matrix<double, 2, 6>& Jacob, Sophus::SE3d pose, Eigen::Vector3d point_3d);
-
-            void optimize(Sophus::SE3d& pose, std::vector<Eigen::Vector3d> pts_3d_exists, std::vector<Eigen::Vector2d> pts_2d_detected);//converge problem need to be solved //-> fuck you, your Jacobian was wrong
-
             void map_SE3_to_pose(Sophus::SE3d pose);
 
             Sophus::SE3d pose_add_noise(Eigen::Vector3d t, Eigen::Matrix3d R);
@@ -161,7 +155,7 @@ namespace alan
 
             void solveicp_svd(std::vector<Eigen::Vector3d> pts_3d, std::vector<Eigen::Vector3d> body_frame_pts, Eigen::Matrix3d& R, Eigen::Vector3d& t);
 
-            std::vector<Eigen::Vector3d> pointcloud_generate(std::vector<Eigen::Vector2d> pts_2d_detected, cv::Mat depthimage);
+            std::vector<Eigen::Vector3d> pointcloud_generate(const std::vector<Eigen::Vector2d>& pts_2d_detected, const cv::Mat& depthimage);
 
             Eigen::Vector3d get_CoM(std::vector<Eigen::Vector3d> pts_3d);
 
@@ -202,6 +196,9 @@ namespace alan
                     0, intrinsics_value[1], intrinsics_value[3],
                     0, 0,  1;    
 
+                pose_refiner.setCamera(cameraMat);
+                depth_sampler.setCamera(cameraMat);
+
                 cameraMatrix.at<double>(0,0) = 284.18060302734375;
                 cameraMatrix.at<double>(1,1) = 285.1946105957031;
                 cameraMatrix.at<double>(0,2) = 425.24481201171875;
@@ -294,10 +291,13 @@ namespace alan
 
                 //initialize subscribe
                 // subimage = nh.subscribe("/camera/color/image_raw/compressed", 1, &ArucoNodelet::camera_callback, this);
-                subimage.subscribe(nh, configs.getTopicName(COLOR_SUB_TOPIC), 1);
-                subdepth.subscribe(nh, configs.getTopicName(DEPTH_SUB_TOPIC), 1);                
-                sync_.reset(new sync( MySyncPolicy(10), subimage, subdepth));            
-                sync_->registerCallback(boost::bind(&ArucoNodelet::camera_callback, this, _1, _2));
+                nh.getParam("/alan_master/SYNC_tolerance", cam_sync.tolerance);
+                cam_sync.subscribe(
+                    nh, 
+                    configs.getTopicName(COLOR_SUB_TOPIC), 
+                    configs.getTopicName(DEPTH_SUB_TOPIC),
+                    boost::bind(&ArucoNodelet::camera_callback, this, _1, _2)
+                );
                 
                 uav_pose_sub = nh.subscribe(configs.getTopicName(UAV_POSE_SUB_TOPIC), 1, &ArucoNodelet::uav_pose_callback, this);
                 ugv_pose_sub = nh.subscribe(configs.getTopicName(UGV_POSE_SUB_TOPIC), 1, &ArucoNodelet::ugv_pose_callback, this);
@@ -27,10 +27,23 @@
 #define CAMERAMODEL_HPP
 
 #include "tools/essential.h"
+#include "poseRefine.hpp"
 #include <sophus/se3.hpp>
 
 namespace vision{
-    class cameraModel
+    /* the intrinsics are shared by every cameraModel, defined here as a static
+    member of a class template so that this header can sit in more than one
+    translation unit (ledTracker and the nodelet) without C++17 inline variables */
+    template<int dummy = 0>
+    struct cameraModelShared
+    {
+        static Eigen::MatrixXd cameraMat;
+    };
+
+    template<int dummy>
+    Eigen::MatrixXd cameraModelShared<dummy>::cameraMat = Eigen::MatrixXd::Zero(3,3);
+
+    class cameraModel : public cameraModelShared<>
     {
     private:
         
@@ -45,10 +58,10 @@ namespace vision{
             Sophus::SE3d pose,
             bool draw_reproject
         );
-        virtual void camOptimize(
+        virtual refineResult camOptimize(
             Sophus::SE3d& pose, 
-            std::vector<Eigen::Vector3d> pts_3d_exists, 
-            std::vector<Eigen::Vector2d> pts_2d_detected,
+            const std::vector<Eigen::Vector3d>& pts_3d_exists, 
+            const std::vector<Eigen::Vector2d>& pts_2d_detected,
             double& BA_error
         );
         virtual void solveJacobianCamera(
@@ -56,6 +69,11 @@ namespace vision{
             Sophus::SE3d pose, 
             Eigen::Vector3d point_3d
         );
+        void solveJacobianCamera(
+            Eigen::Matrix<double, 2, 6>& Jacob, 
+            const Sophus::SE3d& pose, 
+            const Eigen::Vector3d& point_3d
+        );
 
         inline virtual Eigen::Vector3d q2rpy(Eigen::Quaterniond q) final;
         inline virtual Eigen::Quaterniond rpy2q(Eigen::Vector3d rpy) final;
@@ -64,30 +82,30 @@ namespace vision{
             Eigen::Vector3d v
         ) final;
 
-        static Eigen::MatrixXd cameraMat;
+        poseRefiner BA_refiner;
         
     };
     
-    cameraModel::cameraModel()
+    inline cameraModel::cameraModel()
     {
     }
     
-    cameraModel::~cameraModel()
+    inline cameraModel::~cameraModel()
     {
     }
     
 }
 
-Eigen::MatrixXd vision::cameraModel::cameraMat = Eigen::MatrixXd::Zero(3,3);
-
-Eigen::Vector2d vision::cameraModel::reproject_3D_2D(Eigen::Vector3d P, Sophus::SE3d pose)
+inline Eigen::Vector2d vision::cameraModel::reproject_3D_2D(Eigen::Vector3d P, Sophus::SE3d pose)
 {
     Eigen::Vector3d result;
 
     Eigen::Matrix3d R = pose.rotationMatrix();
     Eigen::Vector3d t = pose.translation();
 
-    result = cameraMat * (R * P + t); 
+    // fixed-size copy, a product with the dynamic cameraMat would allocate
+    const Eigen::Matrix3d K = cameraMat;
+    result = K * (R * P + t); 
 
     Eigen::Vector2d result2d;
 
@@ -98,7 +116,7 @@ Eigen::Vector2d vision::cameraModel::reproject_3D_2D(Eigen::Vector3d P, Sophus::
     return result2d;
 }
 
-double vision::cameraModel::get_reprojection_error(
+inline double vision::cameraModel::get_reprojection_error(
             std::vector<Eigen::Vector3d> pts_3d, 
             std::vector<Eigen::Vector2d> pts_2d, 
             Sophus::SE3d pose,
@@ -120,85 +138,37 @@ double vision::cameraModel::get_reprojection_error(
 
 }
 
-void vision::cameraModel::camOptimize(
+inline vision::refineResult vision::cameraModel::camOptimize(
     Sophus::SE3d& pose, 
-    std::vector<Eigen::Vector3d> pts_3d_exists, 
-    std::vector<Eigen::Vector2d> pts_2d_detected,
+    const std::vector<Eigen::Vector3d>& pts_3d_exists, 
+    const std::vector<Eigen::Vector2d>& pts_2d_detected,
     double& BA_error
 )
 {
-    //execute Gaussian-Newton Method
-    // cout<<"Bundle Adjustment Optimization"<<endl;
+    /*
+        left perturbation on SE3, see poseRefine.hpp,
+        BA_error is the summed reprojection error (px) at the returned pose
+    */
+    BA_refiner.setCamera(cameraMat);
+    const refineResult result = BA_refiner.refine(pose, pts_3d_exists, pts_2d_detected);
 
-    const int MAX_ITERATION = 400;
+    BA_error = result.error;
 
-    const double converge_threshold = 1e-6;
-
-    const int points_no = pts_2d_detected.size();
-
-    Eigen::MatrixXd J;
-    J.resize(2,6);
-    
-    Eigen::Matrix<double, 6, 6> A; // R6*6
-    Eigen::Matrix<double, 6, 1> b; // R6
-    Eigen::Vector2d e; // R2
-    Eigen::Matrix<double, 6, 1> dx;
-
-    int i;
-    double cost = 0, lastcost = INFINITY;
-    
-    for(i = 0; i < MAX_ITERATION; i++)
-    {
-        A.setZero();
-        b.setZero();
-
-        cost = 0;
-        
-
-        for(int i=0; i < points_no; i++)
-        {
-            //get the Jacobian for this point
-            solveJacobianCamera(J, pose, pts_3d_exists[i]);
-            J *= (-1);
-
-            e = pts_2d_detected[i] - reproject_3D_2D(pts_3d_exists[i], pose) ; 
-            
-            cost += e.norm();
-
-            //form Ax = b
-            A += J.transpose() * J;
-            b += -J.transpose() * e;
-        }
-    
-        //solve Adx = b
-        dx = A.ldlt().solve(b);
-        //
-
-        for(int i = 0; i < 6; i++)
-            if(isnan(dx(i,0)))
-                break;
-
-
-        pose = Sophus::SE3d::exp(dx) * pose;
-            /*
-                pertubation defined in world frame (left Jacobian),
-                left jacobians, 
-                hence, add from the left
-            */
-
-        lastcost = cost;
-
-        if(dx.norm() < converge_threshold)        
-            break;
-    }
-
-    BA_error = lastcost;
-
-    // cout<<"gone thru: "<<i<<" th, end optimize"<<endl<<endl;;;
+    return result;
+}
 
+inline void vision::cameraModel::solveJacobianCamera(Eigen::MatrixXd& Jacob, Sophus::SE3d pose, Eigen::Vector3d point_3d)
+{
+    Eigen::Matrix<double, 2, 6> Jacob_fixed;
+    solveJacobianCamera(Jacob_fixed, pose, point_3d);
+    Jacob = Jacob_fixed;
 }
 
-void vision::cameraModel::solveJacobianCamera(Eigen::MatrixXd& Jacob, Sophus::SE3d pose, Eigen::Vector3d point_3d)
+inline void vision::cameraModel::solveJacobianCamera(
+    Eigen::Matrix<double, 2, 6>& Jacob, 
+    const Sophus::SE3d& pose, 
+    const Eigen::Vector3d& point_3d
+)
 {
     
     Eigen::Matrix3d R = pose.rotationMatrix();
@@ -213,7 +183,6 @@ void vision::cameraModel::solveJacobianCamera(Eigen::MatrixXd& Jacob, Sophus::SE
         y_c = point_in_camera(1),
         z_c = point_in_camera(2);
 
-    Jacob.resize(2,6);
 
     //save entries to Jacob and return
     Jacob << 
@@ -235,7 +204,7 @@ void vision::cameraModel::solveJacobianCamera(Eigen::MatrixXd& Jacob, Sophus::SE
 
 }
 
-Eigen::Vector3d vision::cameraModel::q2rpy(Eigen::Quaterniond q) 
+inline Eigen::Vector3d vision::cameraModel::q2rpy(Eigen::Quaterniond q) 
 {
     tfScalar yaw, pitch, roll;
     tf::Quaternion q_tf;
@@ -250,7 +219,7 @@ Eigen::Vector3d vision::cameraModel::q2rpy(Eigen::Quaterniond q)
     return Eigen::Vector3d(roll, pitch, yaw);
 }
 
-Eigen::Quaterniond vision::cameraModel::rpy2q(Eigen::Vector3d rpy)
+inline Eigen::Quaterniond vision::cameraModel::rpy2q(Eigen::Vector3d rpy)
 {
     Eigen::AngleAxisd rollAngle(rpy(0), Eigen::Vector3d::UnitX());
     Eigen::AngleAxisd pitchAngle(rpy(1), Eigen::Vector3d::UnitY());
@@ -261,7 +230,7 @@ Eigen::Quaterniond vision::cameraModel::rpy2q(Eigen::Vector3d rpy)
     return q;
 }
 
-Eigen::Vector3d vision::cameraModel::q_rotate_vector(Eigen::Quaterniond q, Eigen::Vector3d v)
+inline Eigen::Vector3d vision::cameraModel::q_rotate_vector(Eigen::Quaterniond q, Eigen::Vector3d v)
 {
     return q * v;
 }
@@ -0,0 +1,263 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file depthSampler.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief sparse depth sampling at detected pixels and batched back-projection, read in place
+ */
+
+#ifndef DEPTHSAMPLER_HPP
+#define DEPTHSAMPLER_HPP
+
+#include <opencv2/core.hpp>
+#include <Eigen/Dense>
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace vision
+{
+    enum depthStat
+    {
+        DEPTH_MEAN,         // mean of the valid pixels in the window
+        DEPTH_MEDIAN,
+        DEPTH_ROBUST_MEAN   // mean of the valid pixels within robust_tol of the median
+    };
+
+    /* a depth image as it is in memory: a cv::Mat or the buffer of a
+    sensor_msgs::Image, nothing is converted or copied.
+    16UC1 / mono16 are in mm, 32FC1 in m. */
+    typedef struct depthView
+    {
+        const uint8_t* data = nullptr;
+        int cols = 0, rows = 0;
+        size_t step = 0;
+        bool is_float = false;
+        bool swap = false;  // byte order differs from the host
+
+        inline bool empty() const {return data == nullptr;};
+    }depthView;
+
+    inline depthView viewDepth(const cv::Mat& depth)
+    {
+        depthView view;
+        if(depth.empty() || (depth.type() != CV_16UC1 && depth.type() != CV_32FC1))
+            return view;
+
+        view.data = depth.data;
+        view.cols = depth.cols;
+        view.rows = depth.rows;
+        view.step = depth.step;
+        view.is_float = depth.type() == CV_32FC1;
+        return view;
+    }
+
+    // the fields of a sensor_msgs::Image, empty view for an unknown encoding
+    inline depthView viewDepth(
+        const uint8_t* data,
+        int cols,
+        int rows,
+        size_t step,
+        const std::string& encoding,
+        bool big_endian
+    )
+    {
+        depthView view;
+        if(encoding != "16UC1" && encoding != "mono16" && encoding != "32FC1")
+            return view;
+
+        const uint16_t probe = 1;
+        uint8_t host_little;
+        memcpy(&host_little, &probe, 1);
+
+        view.data = data;
+        view.cols = cols;
+        view.rows = rows;
+        view.step = step;
+        view.is_float = encoding == "32FC1";
+        view.swap = big_endian == (host_little == 1);
+        return view;
+    }
+
+    inline depthStat depthStatFromString(const std::string& name)
+    {
+        if(name == "median")
+            return DEPTH_MEDIAN;
+        if(name == "robust_mean")
+            return DEPTH_ROBUST_MEAN;
+        return DEPTH_MEAN;
+    }
+
+    class depthSampler
+    {
+    private:
+        static const int MAX_HALF_WINDOW = 3;
+        static const int MAX_WINDOW = (2 * MAX_HALF_WINDOW + 1) * (2 * MAX_HALF_WINDOW + 1);
+
+        double fx_inv = 1, fy_inv = 1, cx = 0, cy = 0;
+        std::vector<double> z_buf;
+
+        // metres, 0 if there is no return
+        inline double read(const depthView& view, int x, int y) const
+        {
+            const uint8_t* p = view.data + y * view.step;
+
+            if(view.is_float)
+            {
+                uint32_t raw;
+                memcpy(&raw, p + 4 * x, 4);
+                if(view.swap)
+                    raw = __builtin_bswap32(raw);
+
+                float z;
+                memcpy(&z, &raw, 4);
+                return std::isfinite(z) ? z : 0;
+            }
+
+            uint16_t raw;
+            memcpy(&raw, p + 2 * x, 2);
+            if(view.swap)
+                raw = __builtin_bswap16(raw);
+
+            return raw * mm_scale;
+        }
+
+    public:
+        depthSampler(){};
+        ~depthSampler(){};
+
+        int half_window = 1;            // 1 for 3x3, up to 3
+        depthStat stat = DEPTH_MEDIAN;
+        double robust_tol = 0.03;       // m, DEPTH_ROBUST_MEAN only
+        double mm_scale = 0.001;        // 16-bit unit to m
+        double z_min = 0.05, z_max = 20;
+
+        template<typename Derived>
+        inline void setCamera(const Eigen::MatrixBase<Derived>& K)
+        {
+            fx_inv = 1.0 / K(0,0);
+            fy_inv = 1.0 / K(1,1);
+            cx = K(0,2);
+            cy = K(1,2);
+        }
+
+        /* depth (m) around the pixel (u, v), 0 if no pixel in the window has a return.
+        valid is the number of pixels the statistic was taken over. */
+        double sample(const depthView& view, double u, double v, int& valid) const
+        {
+            valid = 0;
+            if(view.empty())
+                return 0;
+
+            const int h = std::min(std::max(half_window, 0), MAX_HALF_WINDOW);
+            const int x0 = (int)std::lround(u), y0 = (int)std::lround(v);
+            const int x_begin = std::max(x0 - h, 0), x_end = std::min(x0 + h, view.cols - 1);
+            const int y_begin = std::max(y0 - h, 0), y_end = std::min(y0 + h, view.rows - 1);
+
+            std::array<double, MAX_WINDOW> z;
+
+            for(int y = y_begin; y <= y_end; y++)
+                for(int x = x_begin; x <= x_end; x++)
+                {
+                    const double z_xy = read(view, x, y);
+                    if(z_xy >= z_min && z_xy <= z_max)
+                        z[valid++] = z_xy;
+                }
+
+            if(valid == 0)
+                return 0;
+
+            if(stat == DEPTH_MEAN)
+            {
+                double sum = 0;
+                for(int i = 0; i < valid; i++)
+                    sum += z[i];
+                return sum / valid;
+            }
+
+            std::nth_element(z.begin(), z.begin() + valid / 2, z.begin() + valid);
+            double median = z[valid / 2];
+            if(valid % 2 == 0)
+                median = 0.5 * (median + *std::max_element(z.begin(), z.begin() + valid / 2));
+
+            if(stat == DEPTH_MEDIAN)
+                return median;
+
+            double sum = 0;
+            int inlier_no = 0;
+            for(int i = 0; i < valid; i++)
+                if(std::abs(z[i] - median) <= robust_tol)
+                {
+                    sum += z[i];
+                    inlier_no++;
+                }
+
+            valid = inlier_no;
+            return sum / inlier_no;
+        }
+
+        /* one depth sample per pixel, then all points back-projected at once.
+        points without depth come out as (0, 0, 0), valid_no (optional) holds
+        the per-point pixel count. returns the number of points with depth. */
+        int backproject(
+            const depthView& view,
+            const std::vector<Eigen::Vector2d>& pts_2d,
+            std::vector<Eigen::Vector3d>& pts_3d,
+            std::vector<int>* valid_no = nullptr
+        )
+        {
+            const int n = pts_2d.size();
+
+            z_buf.resize(n);
+            pts_3d.resize(n);
+            if(valid_no)
+                valid_no->resize(n);
+
+            int depth_no = 0, valid;
+            for(int i = 0; i < n; i++)
+            {
+                z_buf[i] = sample(view, pts_2d[i].x(), pts_2d[i].y(), valid);
+                depth_no += z_buf[i] > 0;
+                if(valid_no)
+                    (*valid_no)[i] = valid;
+            }
+
+            if(n == 0)
+                return 0;
+
+            const Eigen::Map<const Eigen::Matrix<double, 2, Eigen::Dynamic>> uv(pts_2d[0].data(), 2, n);
+            const Eigen::Map<const Eigen::Array<double, 1, Eigen::Dynamic>> z(z_buf.data(), n);
+            Eigen::Map<Eigen::Matrix<double, 3, Eigen::Dynamic>> P(pts_3d[0].data(), 3, n);
+
+            P.row(0) = ((uv.row(0).array() - cx) * fx_inv * z).matrix();
+            P.row(1) = ((uv.row(1).array() - cy) * fy_inv * z).matrix();
+            P.row(2) = z.matrix();
+
+            return depth_no;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file imuPropagator.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief pose and velocity at IMU rate between vision fixes, late fixes replayed over the IMU history
+ */
+
+#ifndef IMUPROPAGATOR_HPP
+#define IMUPROPAGATOR_HPP
+
+#include <Eigen/Dense>
+#include <deque>
+
+namespace kf
+{
+    // body frame: specific force (gravity included, as mavros publishes it) and angular rate
+    typedef struct imuSample
+    {
+        double t = 0;
+        Eigen::Vector3d acc = Eigen::Vector3d::Zero();
+        Eigen::Vector3d gyro = Eigen::Vector3d::Zero();
+    }imuSample;
+
+    // world frame, acc without gravity
+    typedef struct imuState
+    {
+        double t = 0;
+        Eigen::Vector3d p = Eigen::Vector3d::Zero();
+        Eigen::Vector3d v = Eigen::Vector3d::Zero();
+        Eigen::Quaterniond q = Eigen::Quaterniond::Identity();
+        Eigen::Vector3d acc = Eigen::Vector3d::Zero();
+    }imuState;
+
+    /* strapdown integration from the last vision fix. a fix arrives one
+    processing delay after its camera stamp, so the state is reset at that
+    stamp and the IMU samples since then are integrated again, the output
+    stays at the newest IMU stamp. the fix is taken as it is, the AIEKF
+    behind it has already filtered it; the vision and IMU body frames are
+    taken to coincide, as MsgSyncNodelet already does for the acceleration. */
+    class imuPropagator
+    {
+    private:
+        std::deque<imuSample> samples;
+        imuState state;
+        double fix_t = 0;
+        bool anchored = false;
+
+        inline void step(imuState& s, const imuSample& imu, double dt) const
+        {
+            // zero-order hold on the sample that ends the interval
+            dt = std::min(dt, max_gap);
+
+            s.acc = s.q * imu.acc - Eigen::Vector3d(0, 0, gravity);
+            s.p += s.v * dt + 0.5 * s.acc * dt * dt;
+            s.v += s.acc * dt;
+
+            const Eigen::Vector3d dtheta = imu.gyro * dt;
+            const double angle = dtheta.norm();
+            if(angle > 1e-12)
+                s.q = (s.q * Eigen::Quaterniond(Eigen::AngleAxisd(angle, dtheta / angle))).normalized();
+
+            s.t = imu.t;
+        }
+
+    public:
+        imuPropagator(){};
+        ~imuPropagator(){};
+
+        double gravity = 9.8066;
+        double history = 1.0;   // s of IMU kept for late fixes
+        double max_gap = 0.05;  // s, longest single integration step
+        double horizon = 0.5;   // s past the last fix that getState() is still trusted
+
+        // false while no fix has anchored the state, else the state moved to imu.t
+        inline bool addImu(const imuSample& imu)
+        {
+            if(!samples.empty() && imu.t <= samples.back().t)
+                return false;
+
+            samples.push_back(imu);
+            while(samples.front().t < imu.t - history)
+                samples.pop_front();
+
+            if(!anchored)
+                return false;
+
+            if(imu.t > state.t)
+                step(state, imu, imu.t - state.t);
+
+            return true;
+        }
+
+        // vision pose and velocity at their stamp t, older than the newest IMU sample
+        inline void correct(double t, const Eigen::Vector3d& p, const Eigen::Vector3d& v, const Eigen::Quaterniond& q)
+        {
+            state.t = t;
+            state.p = p;
+            state.v = v;
+            state.q = q.normalized();
+            state.acc.setZero();
+
+            fix_t = t;
+            anchored = true;
+
+            // replay what came in since the camera took the frame
+            for(const imuSample& imu : samples)
+                if(imu.t > state.t)
+                    step(state, imu, imu.t - state.t);
+        }
+
+        inline bool isAnchored() const {return anchored;};
+        // a fix within horizon of the newest state
+        inline bool isFresh() const {return anchored && state.t - fix_t <= horizon;};
+        inline double sinceFix() const {return state.t - fix_t;};
+        inline const imuState& getState() const {return state;};
+    };
+}
+
+#endif
@@ -36,10 +36,8 @@
 #include <image_transport/image_transport.h>
 #include <cv_bridge/cv_bridge.h>
 #include <sensor_msgs/image_encodings.h>
-#include <message_filters/subscriber.h>
-#include <message_filters/synchronizer.h>
-#include <message_filters/sync_policies/approximate_time.h>
 #include <sensor_msgs/Image.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 
 #include <opencv2/aruco.hpp>
 #include <opencv2/calib3d.hpp>
@@ -49,14 +47,21 @@
 #include <nodelet/nodelet.h>
 
 #include <pthread.h>
+#include <atomic>
+#include <thread>
 #include <tf/tf.h>
 
 
 #include "tools/RosTopicConfigs.h"
+#include "tools/masterParams.hpp"
+#include "tools/spscRing.hpp"
+#include "tools/stageTracer.hpp"
+#include "tools/stampSync.hpp"
 #include "alan_state_estimation/alan_log.h"
+#include "alan_flight_log/flightStreams.hpp"
 
-#include "aiekf.hpp"
-#include "cameraModel.hpp"
+#include "ledTracker.h"
+#include "ledMultiTracker.h"
 
 // map definition for convinience
 #define COLOR_SUB_TOPIC CAMERA_SUB_TOPIC_A
@@ -71,52 +76,62 @@
 
 #define LED_ODOM_PUB_TOPIC ODOM_PUB_TOPIC_A
 
-namespace correspondence
-{
-    typedef struct matchid
-        {
-            int detected_indices; //
-            bool detected_ornot = false;
-            Eigen::Vector3d pts_3d_correspond;
-            Eigen::Vector2d pts_2d_correspond;
-        }matchid;
-}
-
 namespace alan
 {
-    class LedNodelet : public nodelet::Nodelet, private kf::aiekf
+    // what the debug image thread needs, the Mats share ledTracker's pooled buffers
+    typedef struct ledDebug
+    {
+        std_msgs::Header header;
+        cv::Mat display, frame_input;
+        double hz = 0, BA_error = 0, depth_avg = 0;
+        int detect_no = 0;
+    }ledDebug;
+
+    // ROS shell around ledTracker: subscribers, pipeline threads, world frame, publishers
+    class LedNodelet : public nodelet::Nodelet
     {
         //primary objects
-            //frames
-            cv::Mat frame, display, hsv, frame_temp;
-            cv::Mat frame_input;
-            cv::Mat im_with_keypoints;
-            cv::Mat frame_initial_thresholded;
-            
-            //time related
-            std_msgs::Header led_pose_header, led_pose_header_previous;
-            double last_request = 0;
+            ledTracker tracker;
 
-            //camera related
-            // Eigen::MatrixXd cameraMat = Eigen::MatrixXd::Zero(3,3);
-            Eigen::VectorXd cameraEX;
+            // LED_targets: several vehicles, one decode and segmentation, serial callback only
+            ledMultiTracker multi_tracker;
+            bool multi_on = false;
+            std::vector<ros::Publisher> target_pose_pub, target_odom_pub;
 
-            //LED config and correspondences
-            std::vector<Eigen::Vector3d> pts_on_body_frame;
-
-            // detect_no, correspondences(in order of 0->5)
-            std::tuple<int, std::vector<correspondence::matchid>> corres_global_current;
-            std::tuple<int, std::vector<correspondence::matchid>> corres_global_previous;
+            inline vision::stageTracer* getTracer()
+            {
+                return multi_on ? multi_tracker.getTracer() : tracker.getTracer();
+            }
 
-            Eigen::VectorXd LEDEX;
+            // pipelined mode: one thread per stage, rings drop the oldest item when full
+            bool pipeline_on = false;
+            vision::spscRing<ledInput, 2> ring_input;
+            vision::spscRing<ledFrame, 2> ring_frame;
+            vision::spscRing<ledReport, 2> ring_report;
+            std::thread front_thread, estimate_thread, output_thread;
+            std::atomic<bool> pipeline_running{false};
+            ledFrame frame_serial;
+            ledReport report_serial;
+
+            // debug images: drawn only when subscribed, at most DEBUG_IMAGE_hz, published
+            // (and compressed by image_transport) on their own thread
+            double debug_hz = 10;
+            double debug_last = 0;
+            vision::spscRing<ledDebug, 2> ring_debug;
+            ledDebug debug_out;
+            std::thread debug_thread;
+            std::atomic<bool> debug_running{false};
+
+            // per-stage latency, percentiles over the last one to two windows on /alan_state_estimation/led/diagnostics
+            ros::Publisher trace_pub;
+            ros::Timer trace_timer;
+            double trace_window = 10;
+            double trace_last_roll = 0;
+            std::string trace_dump_file;
+            void trace_callback(const ros::TimerEvent& event);
+            void trace_dump();
 
             //poses
-            Sophus::SE3d pose_global_sophus;
-            Sophus::SE3d velo_global_sophus;
-            Eigen::MatrixXd covariance_global_sophus;
-
-            Sophus::SE3d pose_epnp_sophus, pose_depth_sophus;
-            
             Sophus::SE3d pose_cam_inWorld_SE3;
             Sophus::SE3d pose_ugv_inWorld_SE3;
             Sophus::SE3d pose_uav_inWorld_SE3;
@@ -130,24 +145,11 @@ namespace alan
             geometry_msgs::PoseStamped ugv_pose_msg, 
                                        uav_pose_msg,
                                        uav_stpt_msg;            
-                       
-        //secondary objects
-            // double temp = 0;
-            int i = 0;
-            bool nodelet_activated = false;
-            bool tracker_started = false;
-            
-            std::vector<cv::KeyPoint> blobs_for_initialize;
-            int _width = 0, _height = 0;
-
 
         //subscribe                                    
             //objects
-            message_filters::Subscriber<sensor_msgs::CompressedImage> subimage;
-            message_filters::Subscriber<sensor_msgs::Image> subdepth;
-            typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::CompressedImage, sensor_msgs::Image> MySyncPolicy;
-            typedef message_filters::Synchronizer<MySyncPolicy> sync;// (MySyncPolicy(10), subimage, subdepth);
-            boost::shared_ptr<sync> sync_;                    
+            // rgb/depth pairs within SYNC_tolerance, the newest one only
+            vision::stampSync<sensor_msgs::CompressedImage, sensor_msgs::Image> cam_sync;
             ros::Subscriber ugv_pose_sub, uav_pose_sub;
             ros::Subscriber uav_setpt_sub;
             //functions
@@ -163,110 +165,44 @@ namespace alan
                            record_led_pub, record_uav_pub;
             image_transport::Publisher pubimage;
             image_transport::Publisher pubimage_input;
-            //functions
-        
-        //main process & kf
-            void solve_pose_w_LED(cv::Mat& frame, cv::Mat depth);
-            void apiKF(int DOKF);
-            void recursive_filtering(cv::Mat& frame, cv::Mat depth);                
         
-        //LED extraction tool
-            //objects
-            double LANDING_DISTANCE = 0;
-            int BINARY_THRES = 0;
-
-            std::vector<Eigen::Vector3d> pts_on_body_frame_in_corres_order;
-            std::vector<Eigen::Vector2d> pts_detected_in_corres_order;
-            
-            std::vector<Eigen::Vector2d> LED_extract_POI(cv::Mat& frame, cv::Mat depth);
-            std::vector<Eigen::Vector2d> LED_extract_POI_alter(cv::Mat& frame, cv::Mat depth);
-            std::vector<Eigen::Vector3d> pointcloud_generate(std::vector<Eigen::Vector2d> pts_2d_detected, cv::Mat depthimage);
-
-        // correspondence search
-            //objects
-            int LED_no;
-            int LED_r_no;
-            int LED_g_no;
-            // int last_frame_no;
-            // int current_frame_no;
-            std::vector<Eigen::Vector2d> pts_2d_detect_correct_order;
-            cv::Point3f pcl_center_point_wo_outlier_previous;
-            Eigen::Vector3d led_3d_posi_in_camera_frame_depth;
-
-            //functions    
-            void get_correspondence(
-                std::vector<Eigen::Vector2d>& pts_2d_detected
-            );
-            std::vector<Eigen::Vector2d> shift2D(
-                std::vector<Eigen::Vector2d>& pts_2D_previous,
-                std::vector<Eigen::Vector2d>& pts_detect_current
-            );
-            void correspondence_search_2D2DCompare(
-                std::vector<Eigen::Vector2d>& pts_2d_detected,
-                std::vector<Eigen::Vector2d>& pts_2d_detected_previous
-            );
-            void reject_outlier(std::vector<Eigen::Vector2d>& pts_2d_detect, cv::Mat depth);
-                                  
-        // initialization
-            //objects
-            bool LED_tracker_initiated_or_tracked = false;
-            double MAD_dilate, MAD_max;
-            double MAD_x_threshold = 0, MAD_y_threshold = 0, MAD_z_threshold = 0;
-            double min_blob_size = 0;
-            //functions
-            bool initialization(cv::Mat& frame, cv::Mat depth);
-            void solve_pnp_initial_pose(
-                std::vector<Eigen::Vector2d> pts_2d, 
-                std::vector<Eigen::Vector3d> body_frame_pts
-            );
-            double calculate_MAD(std::vector<double> norm_of_points);
+        //pipeline stages
+            void output(ledReport& report);
+            void output_multi();
+            void debug_push(ledReport& report, double hz);
+            void front_loop();
+            void estimate_loop();
+            void output_loop();
+            void pipeline_start();
+            void pipeline_stop();
+            void debug_loop();
+            void debug_start();
+            void debug_stop();
                     
         // publish
             //objects
             int error_no = 0;
             int total_no = 0;
-            int detect_no = 0;
-            double BA_error = 0;
-            double depth_avg_of_all = 0;
 
             geometry_msgs::PoseStamped led_pose_estimated_msg;
             nav_msgs::Odometry led_odom_estimated_msg;
             // functions
+            // target -1: single-target topics only, 0: those and the target's own, > 0: its own only
             void map_SE3_to_publish(
                 Sophus::SE3d pose, 
                 Sophus::SE3d velo,
-                Eigen::MatrixXd cov
+                Eigen::MatrixXd cov,
+                std_msgs::Header header,
+                int target = -1
             );
-            double get_reprojection_error(
-                std::vector<Eigen::Vector3d> pts_3d, 
-                std::vector<Eigen::Vector2d> pts_2d, 
-                Sophus::SE3d pose, 
-                bool draw_reproject
-            ) override
-            {
-                double e = 0;
 
-                Eigen::Vector2d reproject, error;
-
-                for(int i = 0; i < pts_3d.size(); i++)
-                {
-                    reproject = reproject_3D_2D(pts_3d[i], pose);
-                    error = pts_2d[i] - reproject;
-                    e = e + error.norm();
-
-                    if(draw_reproject)
-                        cv::circle(display, cv::Point(reproject(0), reproject(1)), 2.5, CV_RGB(0,255,0),-1);                    
-                }
-
-                return e;
-            };         
-
-            void set_image_to_publish(
-                double hz, 
-                const sensor_msgs::CompressedImageConstPtr & rgbmsg
-            );
-            void terminal_msg_display(double hz);
+            void set_image_to_publish(ledDebug& item);
+            void terminal_msg_display(double hz, ledReport& report, const std::string& name = "");
             void log(double ms);    
+
+            // LOG_file: every tracked frame in-process, alan_log is only published when subscribed
+            flightLog flight_log;
+            int log_led = -1, log_uav = -1;
             
             inline Sophus::SE3d posemsg_to_SE3(const geometry_msgs::PoseStamped pose);
             inline geometry_msgs::PoseStamped SE3_to_posemsg(
@@ -278,8 +214,12 @@ namespace alan
                 const Sophus::SE3d velo_on_SE3,
                 const std_msgs::Header msgHeader
             );
-            
-            Eigen::VectorXd led_twist_current;
+            inline Eigen::Vector3d q2rpy(const Eigen::Quaterniond& q)
+            {
+                tfScalar yaw, pitch, roll;
+                tf::Matrix3x3(tf::Quaternion(q.x(), q.y(), q.z(), q.w())).getEulerYPR(yaw, pitch, roll);
+                return Eigen::Vector3d(roll, pitch, yaw);
+            }
 
 //---------------------------------------------------------------------------------------
             virtual void onInit()
@@ -294,10 +234,13 @@ namespace alan
                 doALOTofConfigs(nh);
                                                  
             //subscribe                
-                subimage.subscribe(nh, configs.getTopicName(COLOR_SUB_TOPIC), 1);                
-                subdepth.subscribe(nh, configs.getTopicName(DEPTH_SUB_TOPIC), 1);                
-                sync_.reset(new sync( MySyncPolicy(10), subimage, subdepth));            
-                sync_->registerCallback(boost::bind(&LedNodelet::camera_callback, this, _1, _2));                                
+                cam_sync.tracer = getTracer();
+                cam_sync.subscribe(
+                    nh, 
+                    configs.getTopicName(COLOR_SUB_TOPIC), 
+                    configs.getTopicName(DEPTH_SUB_TOPIC),
+                    boost::bind(&LedNodelet::camera_callback, this, _1, _2)
+                );
 
                 
                 uav_pose_sub = nh.subscribe<geometry_msgs::PoseStamped>
@@ -341,44 +284,94 @@ namespace alan
                 
                 record_uav_pub = nh.advertise<alan_state_estimation::alan_log>
                                 ("/alan_state_estimation/led/uav_log", 1);            
+
+                for(int k = 0; multi_on && k < multi_tracker.size(); k++)
+                {
+                    target_pose_pub.push_back(nh.advertise<geometry_msgs::PoseStamped>
+                                ("/alan_state_estimation/led/" + multi_tracker.getName(k) + "/pose", 1, true));
+                    target_odom_pub.push_back(nh.advertise<nav_msgs::Odometry>
+                                ("/alan_state_estimation/led/" + multi_tracker.getName(k) + "/odom", 1, true));
+                }
+
+                if(getTracer()->enabled())
+                {
+                    trace_pub = nh.advertise<diagnostic_msgs::DiagnosticArray>
+                                    ("/alan_state_estimation/led/diagnostics", 1);
+                    trace_timer = nh.createTimer(ros::Duration(1.0), &LedNodelet::trace_callback, this);
+                }
+
+                debug_start();
+
+                if(pipeline_on)
+                    pipeline_start();
             }
 
             inline void doALOTofConfigs(ros::NodeHandle& nh)
             {
-                POI_config(nh);
-                camIntrinsic_config(nh);
+                // the estimation reads the same "/alan_master" keys offline, see tools/led_bench.cpp
+                masterParams params;
+                if(!params.fromParamServer(nh))
+                    ROS_ERROR("NO /alan_master PARAMETERS!");
+
+                XmlRpc::XmlRpcValue target_list;
+                multi_on = params.getParam("LED_targets", target_list) 
+                    && target_list.getType() == XmlRpc::XmlRpcValue::TypeArray
+                    && target_list.size() > 0
+                    && multi_tracker.config(params);
+
+                if(!multi_on)
+                    tracker.config(params);
+
+                pipeline_config(params);
+                flightLog_config(params);
                 camExtrinsic_config(nh);
                 CamInGeneralBody_config(nh);
-                LEDInBodyAndOutlierSetting_config(nh);
-                KF_config(nh);
 
-                led_twist_current.resize(6);
+                frame_serial.pts_2d_detect.reserve(64);
+                frame_serial.blobs.reserve(64);
             }
 
-            inline void POI_config(ros::NodeHandle& nh)
+            inline void pipeline_config(const masterParams& params)
             {
-                // load POI_extract config
-                nh.getParam("/alan_master/LANDING_DISTANCE", LANDING_DISTANCE);     
-                nh.getParam("/alan_master/BINARY_threshold", BINARY_THRES);     
-                nh.getParam("/alan_master/frame_width", _width);
-                nh.getParam("/alan_master/frame_height", _height);
+                params.getParam("PIPELINE_ON", pipeline_on);
+                params.getParam("TRACE_window", trace_window);
+                params.getParam("TRACE_dump_file", trace_dump_file);
+                params.getParam("DEBUG_IMAGE_hz", debug_hz);
+                params.getParam("SYNC_tolerance", cam_sync.tolerance);
+
+                if(multi_on && pipeline_on)
+                {
+                    ROS_WARN("PIPELINE_ON IS SINGLE-TARGET ONLY, TARGETS RUN ON THE WORKER POOL!");
+                    pipeline_on = false;
+                }
+
+                // debug images outlive estimate() even without the pipeline,
+                // the pool only grows while one is actually held
+                tracker.setFramesInFlight(true);
+                multi_tracker.setFramesInFlight(true);
             }
 
-            inline void camIntrinsic_config(ros::NodeHandle& nh)
+            inline void flightLog_config(const masterParams& params)
             {
-                // load camera intrinsics
-                Eigen::Vector4d intrinsics_value;
-                XmlRpc::XmlRpcValue intrinsics_list;
-                nh.getParam("/alan_master/cam_intrinsics_455", intrinsics_list);
+                std::string log_file;
+                int capacity = 1 << 18;
+                double flush_period = 1.0;
 
-                for(int i = 0; i < 3; i++)
-                    for(int j = 0; j < 3; j++)
-                    {
-                        std::ostringstream ostr;
-                        ostr << intrinsics_list[3 * i+ j];
-                        std::istringstream istr(ostr.str());
-                        istr >> cameraMat(i, j);
-                    }
+                params.getParam("LOG_file", log_file);
+                params.getParam("LOG_capacity", capacity);
+                params.getParam("LOG_flush_period", flush_period);
+
+                if(log_file.empty())
+                    return;
+
+                // same columns as alan_visualization/data writes
+                log_led = addLEDStream(flight_log);
+                log_uav = addUAVStream(flight_log);
+
+                if(flight_log.open(log_file, capacity, flush_period))
+                    ROS_GREEN_STREAM("FLIGHT LOG TO " + log_file);
+                else
+                    ROS_ERROR_STREAM("CANNOT OPEN FLIGHT LOG " << log_file);
             }
 
             inline void camExtrinsic_config(ros::NodeHandle& nh)
@@ -428,83 +421,14 @@ namespace alan
                 );
             }
 
-            inline void LEDInBodyAndOutlierSetting_config(ros::NodeHandle& nh)
-            {
-                //load LED potisions in body frame
-                XmlRpc::XmlRpcValue LED_list;
-                double temp_delta;
-                nh.getParam("/alan_master/LED_positions", LED_list); 
-                nh.getParam("/alan_master/LED_temp", temp_delta); 
-
-                std::vector<double> norm_of_x_points, norm_of_y_points, norm_of_z_points;
-
-                std::cout<<"\nPts on body frame (X Y Z):\n";
-                for(int i = 0; i < LED_list.size(); i++)
-                {
-                    Eigen::Vector3d temp(LED_list[i]["x"], LED_list[i]["y"], LED_list[i]["z"]);
-                    
-                    temp.x() -= temp_delta;
-
-                    norm_of_x_points.push_back(temp.x());
-                    norm_of_y_points.push_back(temp.y());
-                    norm_of_z_points.push_back(temp.z());                    
-                    std::cout<<"-----"<<std::endl;
-                    std::cout<<temp.x()<<" "<<temp.y()<<" "<<temp.z()<<" "<<std::endl; 
-                    
-                    pts_on_body_frame.push_back(temp);
-                }   
-                std::cout<<std::endl;
-
-                LED_no = pts_on_body_frame.size();
-
-                nh.getParam("/alan_master/LED_r_number", LED_r_no);
-                nh.getParam("/alan_master/LED_g_number", LED_g_no);
-
-                //load outlier rejection info
-                nh.getParam("/alan_master/MAD_dilate", MAD_dilate);
-                nh.getParam("/alan_master/MAD_max", MAD_max);
-
-                MAD_x_threshold = (calculate_MAD(norm_of_x_points) * MAD_dilate > MAD_max ? MAD_max : calculate_MAD(norm_of_x_points) * MAD_dilate);
-                MAD_y_threshold = (calculate_MAD(norm_of_y_points) * MAD_dilate > MAD_max ? MAD_max : calculate_MAD(norm_of_y_points) * MAD_dilate);
-                MAD_z_threshold = (calculate_MAD(norm_of_z_points) * MAD_dilate > MAD_max ? MAD_max : calculate_MAD(norm_of_z_points) * MAD_dilate);
-
-                // std::cout<<MAD_x_threshold<<std::endl;
-                // std::cout<<MAD_y_threshold<<std::endl;
-                // std::cout<<MAD_z_threshold<<std::endl;
-
-                LED_no = pts_on_body_frame.size();
-            }
-              
-            inline void KF_config(ros::NodeHandle& nh)
+        public:
+            ~LedNodelet()
             {
-                double Q_val;
-                double R_val_p;
-                double R_val_v;
-
-                nh.getParam("/alan_master/Q_val", Q_val);
-                nh.getParam("/alan_master/R_val_p", R_val_p);
-                nh.getParam("/alan_master/R_val_v", R_val_v);
-                nh.getParam("/alan_master/Q_alpha", QAdaptiveAlpha);
-                nh.getParam("/alan_master/R_beta", RAdaptiveBeta);
-                nh.getParam("/alan_master/kf_size", kf_size);
-                nh.getParam("/alan_master/kfZ_size", kfZ_size);
-                nh.getParam("/alan_master/velo_IIR_alpha", velo_IIR_alpha);
-                nh.getParam("/alan_master/OPT_MAX_ITERATION", MAX_ITERATION);
-                nh.getParam("/alan_master/CONVERGE_THRESHOLD", CONVERGE_THRESHOLD);
-
-                nh.getParam("/alan_master/KF_ON", KF_ON);
-
-                if(KF_ON)        
-                    ROS_GREEN_STREAM("KF IS ON!");                
-
-                Q_init.resize(kf_size, kf_size);
-                Q_init.setIdentity();
-                Q_init = Q_init * Q_val;
-
-                R_init.resize(kfZ_size, kfZ_size);
-                R_init.setIdentity();
-                R_init.block<2,2>(0,0) = R_init.block<2,2>(0,0) * R_val_p;
-                R_init.block<3,3>(2,2) = R_init.block<3,3>(2,2) * R_val_v;
+                pipeline_stop();
+                debug_stop();
+                flight_log.close();
+                trace_timer.stop();
+                trace_dump();
             }
     };
 
@@ -0,0 +1,261 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledAssociation.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief frame-to-frame LED association: Mahalanobis-gated Hungarian assignment on fixed-size buffers
+ */
+
+#ifndef LEDASSOCIATION_HPP
+#define LEDASSOCIATION_HPP
+
+#include "ledMatcher.hpp"
+
+#include <Eigen/Dense>
+#include <sophus/se3.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace correspondence
+{
+    // detections beyond this are ignored, LED_extract_POI_alter() already warns far below it
+    static const int ASSOC_MAX_DETECT = 32;
+
+    class gatedAssigner
+    {
+    private:
+        // one column per detection, plus one "missed" column per LED
+        static const int MAX_COLS = ASSOC_MAX_DETECT + MATCH_MAX_LED;
+        static constexpr double FORBIDDEN = 1e12;
+
+        int led_no = 0;
+
+        // predicted pixel and inverse innovation covariance (a b; b c) per LED
+        std::array<double, MATCH_MAX_LED> pred_u, pred_v;
+        std::array<double, MATCH_MAX_LED> inv_a, inv_b, inv_c;
+
+        // only for its reprojection Jacobian, the one the pose refinement uses
+        vision::poseRefiner projection;
+
+        // Hungarian buffers, 1-indexed as in the potentials formulation
+        std::array<double, MATCH_MAX_LED * MAX_COLS> cost;
+        std::array<double, MATCH_MAX_LED + 1> pot_row;
+        std::array<double, MAX_COLS + 1> pot_col, min_slack;
+        std::array<int, MAX_COLS + 1> row_of_col, prev_col;
+        std::array<bool, MAX_COLS + 1> visited;
+
+        void solve(int rows, int cols)
+        {
+            const double INF = std::numeric_limits<double>::infinity();
+
+            std::fill(pot_row.begin(), pot_row.begin() + rows + 1, 0.0);
+            std::fill(pot_col.begin(), pot_col.begin() + cols + 1, 0.0);
+            std::fill(row_of_col.begin(), row_of_col.begin() + cols + 1, 0);
+            std::fill(prev_col.begin(), prev_col.begin() + cols + 1, 0);
+
+            for(int i = 1; i <= rows; i++)
+            {
+                row_of_col[0] = i;
+                int j0 = 0;
+
+                std::fill(min_slack.begin(), min_slack.begin() + cols + 1, INF);
+                std::fill(visited.begin(), visited.begin() + cols + 1, false);
+
+                do
+                {
+                    visited[j0] = true;
+                    const int i0 = row_of_col[j0];
+                    double delta = INF;
+                    int j1 = 0;
+
+                    for(int j = 1; j <= cols; j++)
+                    {
+                        if(visited[j])
+                            continue;
+
+                        const double slack = cost[(i0 - 1) * MAX_COLS + (j - 1)] - pot_row[i0] - pot_col[j];
+                        if(slack < min_slack[j])
+                        {
+                            min_slack[j] = slack;
+                            prev_col[j] = j0;
+                        }
+                        if(min_slack[j] < delta)
+                        {
+                            delta = min_slack[j];
+                            j1 = j;
+                        }
+                    }
+
+                    for(int j = 0; j <= cols; j++)
+                    {
+                        if(visited[j])
+                        {
+                            pot_row[row_of_col[j]] += delta;
+                            pot_col[j] -= delta;
+                        }
+                        else
+                            min_slack[j] -= delta;
+                    }
+
+                    j0 = j1;
+                } while(row_of_col[j0] != 0);
+
+                do
+                {
+                    const int j1 = prev_col[j0];
+                    row_of_col[j0] = row_of_col[j1];
+                    j0 = j1;
+                } while(j0);
+            }
+        }
+
+    public:
+        gatedAssigner(){};
+        ~gatedAssigner(){};
+
+        double gate_chi2 = 9.21;    // 2 dof, 99%
+        double px_floor = 2.0;      // detector noise (px, 1 sigma), added to every gate
+        double fallback_px = 20.0;  // 1 sigma around the previous detections when the pose is not trusted
+
+        // results, valid for the first led_no entries after assign()
+        std::array<int, MATCH_MAX_LED> match;           // detection index or -1
+        std::array<double, MATCH_MAX_LED> confidence;   // exp(-d^2 / 2), 0 if unmatched
+        std::array<double, MATCH_MAX_LED> mahalanobis;  // d^2 of the match
+        Eigen::Vector2d shift = Eigen::Vector2d::Zero();
+        int matched_no = 0;
+
+        inline void begin(int led_no_)
+        {
+            led_no = std::min(led_no_, MATCH_MAX_LED);
+        }
+
+        // S is the 2x2 innovation covariance of LED i, the pixel floor is added here
+        inline void setPrediction(int i, const Eigen::Vector2d& uv, const Eigen::Matrix2d& S)
+        {
+            const double var = px_floor * px_floor;
+            const double a = S(0,0) + var;
+            const double b = 0.5 * (S(0,1) + S(1,0));
+            const double c = S(1,1) + var;
+            const double det = a * c - b * b;
+
+            pred_u[i] = uv.x();
+            pred_v[i] = uv.y();
+            inv_a[i] = c / det;
+            inv_b[i] = -b / det;
+            inv_c[i] = a / det;
+        }
+
+        /* predicted reprojection of pt_body at pose, and its covariance J P J^T
+        with P the 6x6 pose block of the filter (left perturbation, translation first). */
+        inline void predict(
+            int i,
+            const Sophus::SE3d& pose,
+            const Eigen::Matrix<double, 6, 6>& P,
+            const Eigen::Vector3d& pt_body,
+            const Eigen::Matrix3d& K
+        )
+        {
+            const Eigen::Vector3d Pc = pose * pt_body;
+
+            Eigen::Matrix<double, 2, 6> J;
+            projection.setCamera(K);
+            projection.jacobian(J, Pc);
+
+            const Eigen::Vector2d uv(K(0,0) * Pc.x() / Pc.z() + K(0,2), K(1,1) * Pc.y() / Pc.z() + K(1,2));
+            const Eigen::Matrix2d S = J * P * J.transpose();
+
+            setPrediction(i, uv, S);
+        }
+
+        inline Eigen::Vector2d getPrediction(int i) const
+        {
+            return Eigen::Vector2d(pred_u[i], pred_v[i]) + shift;
+        }
+
+        /* global nearest neighbour: min sum of d^2 over all LEDs, where leaving an LED
+        unmatched costs gate_chi2 and pairs outside the gate are forbidden.
+        with align_centroid, and as many detections as LEDs, the predictions are first
+        moved onto the detections' centroid. returns the number of matched LEDs. */
+        int assign(const std::vector<Eigen::Vector2d>& detected, bool align_centroid)
+        {
+            const int n = led_no;
+            const int m = std::min((int)detected.size(), ASSOC_MAX_DETECT);
+
+            shift.setZero();
+            if(align_centroid && m == n && n > 0)
+            {
+                for(int i = 0; i < n; i++)
+                    shift += detected[i] - Eigen::Vector2d(pred_u[i], pred_v[i]);
+                shift /= n;
+            }
+
+            const int cols = m + n;
+
+            for(int i = 0; i < n; i++)
+            {
+                double* row = &cost[i * MAX_COLS];
+                const double u = pred_u[i] + shift.x();
+                const double v = pred_v[i] + shift.y();
+
+                for(int j = 0; j < m; j++)
+                {
+                    const double du = detected[j].x() - u;
+                    const double dv = detected[j].y() - v;
+                    const double d2 = inv_a[i] * du * du + 2 * inv_b[i] * du * dv + inv_c[i] * dv * dv;
+
+                    row[j] = d2 <= gate_chi2 ? d2 : FORBIDDEN;
+                }
+
+                for(int j = m; j < cols; j++)
+                    row[j] = (j - m == i) ? gate_chi2 : FORBIDDEN;
+            }
+
+            solve(n, cols);
+
+            matched_no = 0;
+            for(int i = 0; i < n; i++)
+            {
+                match[i] = -1;
+                confidence[i] = 0;
+                mahalanobis[i] = gate_chi2;
+            }
+
+            for(int j = 1; j <= m; j++)
+            {
+                const int i = row_of_col[j] - 1;
+                if(i < 0 || cost[i * MAX_COLS + (j - 1)] >= FORBIDDEN)
+                    continue;
+
+                match[i] = j - 1;
+                mahalanobis[i] = cost[i * MAX_COLS + (j - 1)];
+                confidence[i] = std::exp(-0.5 * mahalanobis[i]);
+                matched_no++;
+            }
+
+            return matched_no;
+        }
+    };
+}
+
+#endif
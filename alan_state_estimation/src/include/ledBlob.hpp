@@ -0,0 +1,257 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledBlob.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief LED blobs from the segmentation runs: 8-connected run merging, intensity-weighted centroids
+ */
+
+#ifndef LEDBLOB_HPP
+#define LEDBLOB_HPP
+
+#include "ledSegmentation.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace vision
+{
+    typedef struct ledBlob
+    {
+        double x = 0, y = 0;    // intensity-weighted centroid, pixel centres at integer coordinates
+        int area = 0;           // pixels
+        cv::Rect bbox;
+        double size = 0;        // equivalent diameter, same meaning as cv::KeyPoint::size
+        double intensity = 0;   // mean gray level
+
+        // accumulators while labelling
+        double sum_w = 0, sum_wx = 0, sum_wy = 0;
+        int x_max = 0, y_max = 0;
+    }ledBlob;
+
+    // a blob of a frame decoded at 1/scale, in full-frame pixels; pixel i there covers
+    // full-frame pixels i * scale ... i * scale + scale - 1
+    inline ledBlob upscaleBlob(const ledBlob& blob, int scale)
+    {
+        ledBlob result = blob;
+
+        result.x = blob.x * scale + (scale - 1) * 0.5;
+        result.y = blob.y * scale + (scale - 1) * 0.5;
+        result.area = blob.area * scale * scale;
+        result.bbox = cv::Rect(
+            blob.bbox.x * scale, 
+            blob.bbox.y * scale, 
+            blob.bbox.width * scale, 
+            blob.bbox.height * scale
+        );
+        result.size = blob.size * scale;
+
+        return result;
+    }
+
+    // and back, e.g. to read the scaled frame at a blob
+    inline ledBlob downscaleBlob(const ledBlob& blob, int scale)
+    {
+        ledBlob result = blob;
+
+        result.x = (blob.x - (scale - 1) * 0.5) / scale;
+        result.y = (blob.y - (scale - 1) * 0.5) / scale;
+        result.area = blob.area / (scale * scale);
+        result.bbox = cv::Rect(
+            blob.bbox.x / scale, 
+            blob.bbox.y / scale, 
+            blob.bbox.width / scale, 
+            blob.bbox.height / scale
+        );
+        result.size = blob.size / scale;
+
+        return result;
+    }
+
+    class ledBlobExtractor
+    {
+    private:
+        // union-find over runs, sized to the run count, capacity kept between frames
+        std::vector<int> parent;
+        std::vector<int> blob_of_root;
+
+        inline int find(int i)
+        {
+            while(parent[i] != i)
+            {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        }
+
+        inline void unite(int a, int b)
+        {
+            a = find(a);
+            b = find(b);
+
+            if(a == b)
+                return;
+
+            if(a < b)
+                parent[b] = a;
+            else
+                parent[a] = b;
+        }
+
+    public:
+        ledBlobExtractor(){};
+        ~ledBlobExtractor(){};
+
+        int min_area = 1;
+
+        inline void reserve(int run_no, int blob_no, std::vector<ledBlob>& blobs)
+        {
+            parent.reserve(run_no);
+            blob_of_root.reserve(run_no);
+            blobs.reserve(blob_no);
+        }
+
+        /* runs have to come row by row, left to right, as segmentLED() emits them.
+        bgr is the frame the runs were cut from, its gray level weights the centroids.
+        blobs is cleared and refilled in run order of the blobs' first pixel. */
+        void extract(
+            const std::vector<segRun>& runs,
+            const cv::Mat& bgr,
+            std::vector<ledBlob>& blobs
+        )
+        {
+            blobs.clear();
+
+            const int n = runs.size();
+            parent.resize(n);
+            for(int i = 0; i < n; i++)
+                parent[i] = i;
+
+            // merge with the runs of the row above, 8-connected
+            int prev_begin = 0, prev_end = 0;
+            int i = 0;
+
+            while(i < n)
+            {
+                const int row = runs[i].row;
+                const int cur_begin = i;
+
+                while(i < n && runs[i].row == row)
+                    i++;
+
+                const int cur_end = i;
+
+                if(prev_end > prev_begin && runs[prev_begin].row == row - 1)
+                {
+                    int p = prev_begin;
+                    for(int c = cur_begin; c < cur_end; c++)
+                    {
+                        while(p < prev_end && runs[p].x_end < runs[c].x_begin)
+                            p++;
+
+                        for(int q = p; q < prev_end && runs[q].x_begin <= runs[c].x_end; q++)
+                            unite(c, q);
+                    }
+                }
+
+                prev_begin = cur_begin;
+                prev_end = cur_end;
+            }
+
+            // accumulate per component, the colour frame is only touched on LED pixels
+            blob_of_root.assign(n, -1);
+
+            for(int k = 0; k < n; k++)
+            {
+                const segRun& run = runs[k];
+                const int root = find(k);
+
+                if(blob_of_root[root] < 0)
+                {
+                    blob_of_root[root] = blobs.size();
+
+                    ledBlob blob;
+                    blob.bbox = cv::Rect(run.x_begin, run.row, 0, 0);
+                    blob.x_max = run.x_end - 1;
+                    blob.y_max = run.row;
+                    blobs.push_back(blob);
+                }
+
+                ledBlob& blob = blobs[blob_of_root[root]];
+
+                const uchar* px = bgr.ptr<uchar>(run.row);
+                for(int x = run.x_begin; x < run.x_end; x++)
+                {
+                    const double w = (
+                        1868 * px[3 * x]
+                        + 9617 * px[3 * x + 1]
+                        + 4899 * px[3 * x + 2]
+                        + 8192
+                    ) >> 14;
+
+                    blob.sum_w += w;
+                    blob.sum_wx += w * x;
+                    blob.sum_wy += w * run.row;
+
+                    blob.x += x;
+                    blob.y += run.row;
+                }
+
+                blob.area += run.x_end - run.x_begin;
+                blob.bbox.x = std::min(blob.bbox.x, run.x_begin);
+                blob.x_max = std::max(blob.x_max, run.x_end - 1);
+                blob.y_max = std::max(blob.y_max, run.row);
+            }
+
+            // finalize and drop small blobs in place
+            int kept = 0;
+            for(int k = 0; k < (int)blobs.size(); k++)
+            {
+                ledBlob blob = blobs[k];
+
+                if(blob.area < min_area)
+                    continue;
+
+                if(blob.sum_w > 0)
+                {
+                    blob.x = blob.sum_wx / blob.sum_w;
+                    blob.y = blob.sum_wy / blob.sum_w;
+                }
+                else
+                {
+                    blob.x = blob.x / blob.area;
+                    blob.y = blob.y / blob.area;
+                }
+
+                blob.bbox.width = blob.x_max - blob.bbox.x + 1;
+                blob.bbox.height = blob.y_max - blob.bbox.y + 1;
+                blob.size = 2.0 * std::sqrt(blob.area / M_PI);
+                blob.intensity = blob.sum_w / blob.area;
+
+                blobs[kept++] = blob;
+            }
+
+            blobs.resize(kept);
+        }
+    };
+}
+
+#endif
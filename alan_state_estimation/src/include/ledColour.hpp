@@ -0,0 +1,155 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledColour.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief red / green LED classification straight from the bgr frame, one table read per pixel
+ */
+
+#ifndef LEDCOLOUR_HPP
+#define LEDCOLOUR_HPP
+
+#include "ledBlob.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+namespace vision
+{
+    enum ledColourClass
+    {
+        LED_COLOUR_NONE,    // no pixel with enough chroma
+        LED_COLOUR_GREEN,
+        LED_COLOUR_RED
+    };
+
+    typedef struct ledColour
+    {
+        ledColourClass colour = LED_COLOUR_NONE;
+        double confidence = 0;  // |green - red| / (green + red) votes, 0 to 1
+        int green_no = 0, red_no = 0;
+    }ledColour;
+
+    /* every pixel of the blob's patch votes by a 32^3 table over its 5-bit
+    b, g, r: green, red or nothing for grays. the hue bounds keep the old
+    decision (CV_RGB2HSV on the bgr frame, hue < 100 green): green is a
+    true hue in (40, 240] degrees, red the rest. */
+    class ledColourClassifier
+    {
+    private:
+        static constexpr int BITS = 5;
+        static constexpr int SHIFT = 8 - BITS;
+
+        std::array<uint8_t, 1 << (3 * BITS)> lut;
+
+    public:
+        ledColourClassifier(){build();};
+        ~ledColourClassifier(){};
+
+        double green_hue_min = 40, green_hue_max = 240;  // degrees
+        int min_chroma = 16;        // max - min of b, g, r below this does not vote
+        double patch_scale = 2.0;   // half window, in blob sizes around the centroid
+
+        inline void build()
+        {
+            const int half_bin = 1 << (SHIFT - 1);
+
+            for(int b = 0; b < (1 << BITS); b++)
+                for(int g = 0; g < (1 << BITS); g++)
+                    for(int r = 0; r < (1 << BITS); r++)
+                    {
+                        // bin centre
+                        const int B = (b << SHIFT) + half_bin;
+                        const int G = (g << SHIFT) + half_bin;
+                        const int R = (r << SHIFT) + half_bin;
+
+                        const int v_max = std::max(B, std::max(G, R));
+                        const int v_min = std::min(B, std::min(G, R));
+                        const int chroma = v_max - v_min;
+
+                        uint8_t vote = LED_COLOUR_NONE;
+
+                        if(chroma >= min_chroma && chroma > 0)
+                        {
+                            double hue;
+                            if(v_max == R)
+                                hue = 60.0 * (G - B) / chroma;
+                            else if(v_max == G)
+                                hue = 120.0 + 60.0 * (B - R) / chroma;
+                            else
+                                hue = 240.0 + 60.0 * (R - G) / chroma;
+
+                            if(hue < 0)
+                                hue += 360.0;
+
+                            vote = (hue > green_hue_min && hue <= green_hue_max)
+                                ? LED_COLOUR_GREEN
+                                : LED_COLOUR_RED;
+                        }
+
+                        lut[(b << (2 * BITS)) | (g << BITS) | r] = vote;
+                    }
+        }
+
+        // the blob's patch of bgr (CV_8UC3), clipped to the frame
+        inline ledColour classify(const cv::Mat& bgr, const ledBlob& blob) const
+        {
+            ledColour result;
+
+            const int half = std::max(1, (int)std::lround(patch_scale * blob.size));
+            const cv::Rect patch = cv::Rect(
+                (int)std::lround(blob.x) - half,
+                (int)std::lround(blob.y) - half,
+                2 * half + 1,
+                2 * half + 1
+            ) & cv::Rect(0, 0, bgr.cols, bgr.rows);
+
+            // votes per class, indexed by the table entry, no branch per pixel
+            int votes[3] = {0, 0, 0};
+
+            for(int y = patch.y; y < patch.y + patch.height; y++)
+            {
+                const uint8_t* px = bgr.ptr<uint8_t>(y) + 3 * patch.x;
+
+                for(int x = 0; x < patch.width; x++, px += 3)
+                    votes[lut[
+                        ((px[0] >> SHIFT) << (2 * BITS))
+                        | ((px[1] >> SHIFT) << BITS)
+                        | (px[2] >> SHIFT)
+                    ]]++;
+            }
+
+            result.green_no = votes[LED_COLOUR_GREEN];
+            result.red_no = votes[LED_COLOUR_RED];
+
+            const int total = result.green_no + result.red_no;
+            if(total == 0)
+                return result;
+
+            result.colour = result.green_no >= result.red_no ? LED_COLOUR_GREEN : LED_COLOUR_RED;
+            result.confidence = std::abs(result.green_no - result.red_no) / (double)total;
+
+            return result;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,442 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledMatcher.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief initial LED correspondence by hypothesise-and-verify: P3P on an anchor triple,
+ * pruned with the constellation's pairwise distances, verified in parallel
+ */
+
+#ifndef LEDMATCHER_HPP
+#define LEDMATCHER_HPP
+
+#include "poseRefine.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace correspondence
+{
+    // upper bound of LEDs on the marker, keeps the hypotheses fixed-size
+    static const int MATCH_MAX_LED = 16;
+
+    typedef struct matchStats
+    {
+        int triples = 0;        // colour-consistent anchor assignments
+        int triples_kept = 0;   // after the distance invariants
+        int poses = 0;          // P3P solutions with all LEDs in front of the camera
+        int early_exit = 0;     // hypotheses dropped by the reprojection bound
+        int refined = 0;        // full pose refinements
+    }matchStats;
+
+    class constellationMatcher
+    {
+    private:
+        typedef struct hypothesis
+        {
+            double error = std::numeric_limits<double>::infinity();
+            std::array<int, MATCH_MAX_LED> corres;
+            cv::Vec3d rvec, tvec;
+        }hypothesis;
+
+        std::vector<Eigen::Vector3d> pts_model;
+        std::vector<bool> green_model;  // first g_no LEDs are green, as in LED_positions
+        Eigen::MatrixXd dist_model;     // pairwise distances, computed once at config
+        std::array<int, 3> anchor;      // the widest triangle, best conditioned for P3P
+        cv::Mat camMat;
+        double depth_tol = 0.02;
+
+        std::vector<std::array<int, 3>> triples;
+        std::vector<hypothesis> results;
+
+        static const int REFINE_NO = 8;
+
+        vision::poseRefiner refiner;
+        std::array<vision::poseCandidate, REFINE_NO> candidates;
+
+        inline bool distanceConsistent(
+            const std::vector<Eigen::Vector3d>& pts_3d,
+            int model_a, int model_b,
+            int detect_a, int detect_b
+        ) const
+        {
+            if(pts_3d.empty())
+                return true;
+
+            const Eigen::Vector3d& pa = pts_3d[detect_a];
+            const Eigen::Vector3d& pb = pts_3d[detect_b];
+
+            // no depth, no constraint
+            if(pa.z() <= 0 || pb.z() <= 0)
+                return true;
+
+            return std::abs((pa - pb).norm() - dist_model(model_a, model_b)) <= depth_tol;
+        }
+
+        static inline cv::Vec3d toVec(const cv::Mat& m)
+        {
+            return cv::Vec3d(m.at<double>(0), m.at<double>(1), m.at<double>(2));
+        }
+
+        inline void project(
+            const cv::Matx33d& R,
+            const cv::Vec3d& t,
+            const Eigen::Vector3d& P,
+            double& u,
+            double& v,
+            double& z
+        ) const
+        {
+            const cv::Vec3d Pc = R * cv::Vec3d(P.x(), P.y(), P.z()) + t;
+            z = Pc[2];
+            u = camMat.at<double>(0,0) * Pc[0] / z + camMat.at<double>(0,2);
+            v = camMat.at<double>(1,1) * Pc[1] / z + camMat.at<double>(1,2);
+        }
+
+        // P3P on one anchor assignment, every pose completed greedily per colour
+        void evaluate(
+            int task,
+            const std::vector<Eigen::Vector2d>& pts_2d,
+            const std::vector<bool>& green_detect,
+            matchStats& stats
+        )
+        {
+            const std::array<int, 3>& tri = triples[task];
+            const int n = pts_model.size();
+
+            std::vector<cv::Point3d> obj(3);
+            std::vector<cv::Point2d> img(3);
+            for(int k = 0; k < 3; k++)
+            {
+                const Eigen::Vector3d& P = pts_model[anchor[k]];
+                obj[k] = cv::Point3d(P.x(), P.y(), P.z());
+                img[k] = cv::Point2d(pts_2d[tri[k]].x(), pts_2d[tri[k]].y());
+            }
+
+            std::vector<cv::Mat> rvecs, tvecs;
+            const int solution_no = cv::solveP3P(obj, img, camMat, cv::noArray(), rvecs, tvecs, cv::SOLVEPNP_P3P);
+
+            hypothesis& best = results[task];
+
+            // the bound is task local, so no result depends on thread scheduling
+            const double cap = gate_px * n;
+
+            for(int s = 0; s < solution_no; s++)
+            {
+                cv::Matx33d R;
+                cv::Rodrigues(rvecs[s], R);
+                const cv::Vec3d t = toVec(tvecs[s]);
+
+                double u, v, z;
+                bool in_front = true;
+                for(int j = 0; j < n && in_front; j++)
+                {
+                    project(R, t, pts_model[j], u, v, z);
+                    in_front = z > 0;
+                }
+                if(!in_front)
+                    continue;
+
+                stats.poses++;
+
+                std::array<int, MATCH_MAX_LED> corres;
+                uint32_t used = 0;
+                double e = 0;
+
+                for(int k = 0; k < 3; k++)
+                {
+                    project(R, t, pts_model[anchor[k]], u, v, z);
+                    e += std::hypot(pts_2d[tri[k]].x() - u, pts_2d[tri[k]].y() - v);
+                    corres[anchor[k]] = tri[k];
+                    used |= 1u << tri[k];
+                }
+
+                // partial sums only grow, stop once this pose cannot win
+                double bound = std::min(cap, best.error);
+                bool alive = e <= bound;
+
+                for(int j = 0; j < n && alive; j++)
+                {
+                    if(j == anchor[0] || j == anchor[1] || j == anchor[2])
+                        continue;
+
+                    project(R, t, pts_model[j], u, v, z);
+
+                    int nearest = -1;
+                    double nearest_e = std::numeric_limits<double>::infinity();
+                    for(int d = 0; d < n; d++)
+                    {
+                        if((used >> d & 1u) || green_detect[d] != green_model[j])
+                            continue;
+
+                        const double e_d = std::hypot(pts_2d[d].x() - u, pts_2d[d].y() - v);
+                        if(e_d < nearest_e)
+                        {
+                            nearest_e = e_d;
+                            nearest = d;
+                        }
+                    }
+
+                    if(nearest < 0)
+                    {
+                        alive = false;
+                        break;
+                    }
+
+                    corres[j] = nearest;
+                    used |= 1u << nearest;
+                    e += nearest_e;
+
+                    alive = e <= bound;
+                }
+
+                if(!alive)
+                {
+                    stats.early_exit++;
+                    continue;
+                }
+
+                if(e < best.error)
+                {
+                    best.error = e;
+                    best.corres = corres;
+                    best.rvec = toVec(rvecs[s]);
+                    best.tvec = t;
+                }
+            }
+        }
+
+    public:
+        constellationMatcher(){};
+        ~constellationMatcher(){};
+
+        // mean reprojection error (px per LED) a P3P hypothesis may reach before it is dropped
+        double gate_px = 8.0;
+
+        void setConstellation(
+            const std::vector<Eigen::Vector3d>& pts_body,
+            int g_no,
+            const Eigen::MatrixXd& cameraMat,
+            double depth_tolerance
+        )
+        {
+            pts_model = pts_body;
+            depth_tol = depth_tolerance;
+
+            const int n = pts_model.size();
+
+            green_model.assign(n, false);
+            for(int i = 0; i < n && i < g_no; i++)
+                green_model[i] = true;
+
+            dist_model.resize(n, n);
+            for(int i = 0; i < n; i++)
+                for(int j = 0; j < n; j++)
+                    dist_model(i, j) = (pts_model[i] - pts_model[j]).norm();
+
+            double area_max = -1;
+            anchor = {0, 1, 2};
+            for(int a = 0; a < n; a++)
+                for(int b = a + 1; b < n; b++)
+                    for(int c = b + 1; c < n; c++)
+                    {
+                        const double area = (pts_model[b] - pts_model[a]).cross(pts_model[c] - pts_model[a]).norm();
+                        if(area > area_max)
+                        {
+                            area_max = area;
+                            anchor = {a, b, c};
+                        }
+                    }
+
+            camMat = cv::Mat::eye(3, 3, CV_64F);
+            camMat.at<double>(0,0) = cameraMat(0,0);
+            camMat.at<double>(0,2) = cameraMat(0,2);
+            camMat.at<double>(1,1) = cameraMat(1,1);
+            camMat.at<double>(1,2) = cameraMat(1,2);
+
+            refiner.setCamera(cameraMat);
+
+            triples.reserve(n * n * n);
+            results.reserve(n * n * n);
+        }
+
+        /* pts_2d / pts_3d are the detections, pts_3d may be empty to skip the distance test.
+        corres_g / corres_r split the detections by colour.
+        on success corres[i] is the detection of LED i, error the reprojection error (px, summed)
+        after refining the pose on that correspondence, R and t the pose of the body in the camera frame.
+        the result does not depend on the thread count, ties go to the lowest anchor assignment. */
+        bool match(
+            const std::vector<Eigen::Vector2d>& pts_2d,
+            const std::vector<Eigen::Vector3d>& pts_3d,
+            const std::vector<int>& corres_g,
+            const std::vector<int>& corres_r,
+            std::vector<int>& corres,
+            double& error,
+            Eigen::Matrix3d& R,
+            Eigen::Vector3d& t,
+            matchStats* stats_out = nullptr
+        )
+        {
+            const int n = pts_model.size();
+            matchStats stats;
+
+            if(
+                n < 3 || n > MATCH_MAX_LED
+                || (int)pts_2d.size() != n
+                || (!pts_3d.empty() && (int)pts_3d.size() != n)
+                || (int)(corres_g.size() + corres_r.size()) != n
+            )
+                return false;
+
+            std::vector<bool> green_detect(n, false);
+            for(auto what : corres_g)
+                green_detect[what] = true;
+
+            const std::vector<int>& cand_a = green_model[anchor[0]] ? corres_g : corres_r;
+            const std::vector<int>& cand_b = green_model[anchor[1]] ? corres_g : corres_r;
+            const std::vector<int>& cand_c = green_model[anchor[2]] ? corres_g : corres_r;
+
+            triples.clear();
+            for(auto da : cand_a)
+                for(auto db : cand_b)
+                {
+                    if(db == da)
+                        continue;
+
+                    for(auto dc : cand_c)
+                    {
+                        if(dc == da || dc == db)
+                            continue;
+
+                        stats.triples++;
+
+                        if(
+                            !distanceConsistent(pts_3d, anchor[0], anchor[1], da, db)
+                            || !distanceConsistent(pts_3d, anchor[0], anchor[2], da, dc)
+                            || !distanceConsistent(pts_3d, anchor[1], anchor[2], db, dc)
+                        )
+                            continue;
+
+                        triples.push_back({da, db, dc});
+                    }
+                }
+
+            stats.triples_kept = triples.size();
+            if(triples.empty())
+            {
+                if(stats_out)
+                    *stats_out = stats;
+                return false;
+            }
+
+            results.assign(triples.size(), hypothesis());
+            std::vector<matchStats> stats_task(triples.size());
+
+            cv::parallel_for_(
+                cv::Range(0, triples.size()),
+                [&](const cv::Range& range)
+                {
+                    for(int task = range.start; task < range.end; task++)
+                        evaluate(task, pts_2d, green_detect, stats_task[task]);
+                }
+            );
+
+            for(auto what : stats_task)
+            {
+                stats.poses += what.poses;
+                stats.early_exit += what.early_exit;
+            }
+
+            // deterministic reduction on (error, task), then refinement on the best few
+            std::vector<int> order;
+            order.reserve(results.size());
+            for(int task = 0; task < (int)results.size(); task++)
+                if(std::isfinite(results[task].error))
+                    order.push_back(task);
+
+            std::sort(
+                order.begin(), order.end(),
+                [&](int a, int b)
+                {
+                    return results[a].error < results[b].error
+                        || (results[a].error == results[b].error && a < b);
+                }
+            );
+
+            // the best few distinct correspondences, refined on all LEDs in one batch
+            int refined = 0;
+
+            for(int k = 0; k < (int)order.size() && refined < REFINE_NO; k++)
+            {
+                const hypothesis& h = results[order[k]];
+
+                bool repeated = false;
+                for(int m = 0; m < k && !repeated; m++)
+                    repeated = std::equal(h.corres.begin(), h.corres.begin() + n, results[order[m]].corres.begin());
+                if(repeated)
+                    continue;
+
+                cv::Matx33d R_cv;
+                cv::Rodrigues(h.rvec, R_cv);
+
+                Eigen::Matrix3d R_h;
+                for(int r = 0; r < 3; r++)
+                    for(int c = 0; c < 3; c++)
+                        R_h(r, c) = R_cv(r, c);
+
+                vision::poseCandidate& candidate = candidates[refined];
+                candidate.pose = Sophus::SE3d(
+                    Eigen::Quaterniond(R_h).normalized(), 
+                    Eigen::Vector3d(h.tvec[0], h.tvec[1], h.tvec[2])
+                );
+                candidate.corres = h.corres.data();
+
+                refined++;
+            }
+
+            const int best = refiner.refineBatch(candidates.data(), refined, pts_model, pts_2d);
+
+            stats.refined = refined;
+            if(stats_out)
+                *stats_out = stats;
+
+            if(best < 0)
+                return false;
+
+            const vision::poseCandidate& winner = candidates[best];
+            corres.assign(winner.corres, winner.corres + n);
+            R = winner.pose.rotationMatrix();
+            t = winner.pose.translation();
+            error = winner.result.error;
+
+            return true;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledMultiTracker.h
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief several LED constellations from one camera: one decode and segmentation, one AIEKF per target
+ */
+
+#ifndef LEDMULTITRACKER_H
+#define LEDMULTITRACKER_H
+
+#include "ledTracker.h"
+#include "tools/workerPool.hpp"
+
+#include <memory>
+
+namespace alan
+{
+    typedef struct ledTarget
+    {
+        std::string name;
+        std::unique_ptr<ledTracker> tracker;
+        cv::Rect ROI;           // predicted window, empty while not tracking
+        bool tracking = false;
+        ledFrame item;          // its share of the blobs, the frame itself is shared
+        ledReport report;
+    }ledTarget;
+
+    /* every target is a full ledTracker with its own constellation and filter,
+    but only the first one decodes and segments: inside the union of the
+    predicted windows while all targets are tracked, the full frame otherwise.
+    blobs go to the target whose window holds them. blobs no window claims are
+    grouped by 3D distance and offered to the targets still initializing, one
+    group each, the first pick rotating over frames. the estimates then run
+    on a worker pool, one target per job. */
+    class ledMultiTracker
+    {
+        private:
+            std::vector<ledTarget> targets;
+            ledFrame frame_shared;
+            std::vector<cv::Rect> ROIs;
+
+            vision::workerPool workers;
+
+            // initialization groups
+            vision::depthSampler depth_sampler;
+            double group_radius = 0.5;
+            int init_turn = 0;
+            std::vector<int> owner;
+            std::vector<Eigen::Vector3d> pts_3d;
+            std::vector<int> group, group_size, fill;
+            std::vector<bool> group_taken;
+
+            void assign_blobs();
+            void group_unclaimed();
+
+        public:
+            ledMultiTracker(){};
+            ~ledMultiTracker(){};
+
+            /* "/alan_master/LED_targets", a list of structs with a name and any
+            keys that differ from the single-target ones (LED_positions,
+            LED_r_number, LED_g_number, LED_temp, ...). false if a target has
+            no constellation or the list is empty. */
+            bool config(const masterParams& params);
+            void setFramesInFlight(bool in_flight);
+
+            // one decode and segmentation, then the blobs shared out, false if the frame cannot be used
+            bool front_end(const ledInput& input);
+            // every target's correspondence/AIEKF, in parallel unless debug images are drawn
+            void estimate();
+
+            inline int size() const {return targets.size();};
+            inline const std::string& getName(int k) const {return targets[k].name;};
+            inline ledReport& getReport(int k) {return targets[k].report;};
+            inline vision::stageTracer* getTracer() {return targets.empty() ? nullptr : targets[0].tracker->getTracer();};
+    };
+}
+
+#endif
@@ -0,0 +1,504 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledSegmentation.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief single pass LED segmentation: depth gate + brightness gate + ROI over BGR and aligned 16-bit depth
+ */
+
+#ifndef LEDSEGMENTATION_HPP
+#define LEDSEGMENTATION_HPP
+
+#include <opencv2/core.hpp>
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LEDSEG_X86 1
+#include <immintrin.h>
+#else
+#define LEDSEG_X86 0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LEDSEG_NEON 1
+#include <arm_neon.h>
+#else
+#define LEDSEG_NEON 0
+#endif
+
+/* the brightness gate is the one of
+    cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+    cv::threshold(gray, gray, BINARY_THRES, 255, cv::THRESH_BINARY);
+i.e. gray = (1868 * b + 9617 * g + 4899 * r + 8192) >> 14 > BINARY_THRES,
+evaluated as 1868 * b + 9617 * g + 4899 * r + 8192 >= (BINARY_THRES + 1) << 14
+so no division is needed.
+the depth gate is the one of cv::threshold() on CV_16U, i.e.
+depth <= floor(LANDING_DISTANCE * 1000), and optionally depth > 0. */
+
+namespace vision
+{
+    enum SEG_SIMD
+    {
+        SEG_SCALAR,
+        SEG_SSSE3,
+        SEG_AVX2,
+        SEG_NEON
+    };
+
+    typedef struct segParam
+    {
+        uint16_t depth_far = 0;         // mm, inclusive
+        bool reject_zero_depth = true;
+        int32_t gray_limit = 0;         // (BINARY_THRES + 1) << 14
+    }segParam;
+
+    // horizontal run of mask pixels, [x_begin, x_end) in full-frame coordinates
+    typedef struct segRun
+    {
+        int row;
+        int x_begin;
+        int x_end;
+    }segRun;
+
+    inline segParam setSegParam(double landing_distance, int binary_thres, bool reject_zero_depth)
+    {
+        segParam param;
+        double far = std::floor(landing_distance * 1000);
+
+        param.depth_far = (uint16_t) std::min(std::max(far, 0.0), 65535.0);
+        param.reject_zero_depth = reject_zero_depth;
+        param.gray_limit = (std::min(std::max(binary_thres, -1), 255) + 1) << 14;
+
+        return param;
+    }
+
+    /* ================ scalar reference ================ */
+    inline void segmentRowScalar(
+        const uchar* bgr,
+        const uint16_t* depth,
+        uchar* mask,
+        int n,
+        const segParam& param
+    )
+    {
+        for(int x = 0; x < n; x++)
+        {
+            const int32_t weighted =
+                1868 * bgr[3 * x]
+                + 9617 * bgr[3 * x + 1]
+                + 4899 * bgr[3 * x + 2]
+                + 8192;
+
+            const bool depth_ok =
+                depth[x] <= param.depth_far
+                &&
+                (!param.reject_zero_depth || depth[x] != 0);
+
+            mask[x] = (weighted >= param.gray_limit && depth_ok) ? 255 : 0;
+        }
+    }
+
+#if LEDSEG_X86
+    /* ================ x86 ================ */
+    // 48 bytes of bgr -> 16 b, 16 g, 16 r
+    __attribute__((target("ssse3")))
+    inline void deinterleaveBGR(
+        const uchar* bgr,
+        __m128i& b,
+        __m128i& g,
+        __m128i& r
+    )
+    {
+        const __m128i a0 = _mm_loadu_si128((const __m128i*)(bgr));
+        const __m128i a1 = _mm_loadu_si128((const __m128i*)(bgr + 16));
+        const __m128i a2 = _mm_loadu_si128((const __m128i*)(bgr + 32));
+
+        b = _mm_or_si128(
+            _mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1))
+            ),
+            _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13))
+        );
+        g = _mm_or_si128(
+            _mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1))
+            ),
+            _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14))
+        );
+        r = _mm_or_si128(
+            _mm_or_si128(
+                _mm_shuffle_epi8(a0, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+                _mm_shuffle_epi8(a1, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1))
+            ),
+            _mm_shuffle_epi8(a2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15))
+        );
+    }
+
+    __attribute__((target("ssse3")))
+    inline void segmentRowSSSE3(
+        const uchar* bgr,
+        const uint16_t* depth,
+        uchar* mask,
+        int n,
+        const segParam& param
+    )
+    {
+        const __m128i zero = _mm_setzero_si128();
+        // (b, g) pairs and (r, 1) pairs through pmaddwd
+        const __m128i coeff_bg = _mm_set1_epi32((9617 << 16) | 1868);
+        const __m128i coeff_r1 = _mm_set1_epi32((8192 << 16) | 4899);
+        const __m128i one16 = _mm_set1_epi16(1);
+        const __m128i limit = _mm_set1_epi32(param.gray_limit - 1);
+        const __m128i far = _mm_set1_epi16((short)param.depth_far);
+        const __m128i zero_keep = param.reject_zero_depth ? zero : _mm_set1_epi8(-1);
+
+        int x = 0;
+        for(; x + 16 <= n; x += 16)
+        {
+            __m128i b, g, r;
+            deinterleaveBGR(bgr + 3 * x, b, g, r);
+
+            __m128i gray_pass[4];
+            for(int half = 0; half < 2; half++)
+            {
+                const __m128i b16 = half == 0 ? _mm_unpacklo_epi8(b, zero) : _mm_unpackhi_epi8(b, zero);
+                const __m128i g16 = half == 0 ? _mm_unpacklo_epi8(g, zero) : _mm_unpackhi_epi8(g, zero);
+                const __m128i r16 = half == 0 ? _mm_unpacklo_epi8(r, zero) : _mm_unpackhi_epi8(r, zero);
+
+                const __m128i sum_lo = _mm_add_epi32(
+                    _mm_madd_epi16(_mm_unpacklo_epi16(b16, g16), coeff_bg),
+                    _mm_madd_epi16(_mm_unpacklo_epi16(r16, one16), coeff_r1)
+                );
+                const __m128i sum_hi = _mm_add_epi32(
+                    _mm_madd_epi16(_mm_unpackhi_epi16(b16, g16), coeff_bg),
+                    _mm_madd_epi16(_mm_unpackhi_epi16(r16, one16), coeff_r1)
+                );
+
+                gray_pass[2 * half] = _mm_cmpgt_epi32(sum_lo, limit);
+                gray_pass[2 * half + 1] = _mm_cmpgt_epi32(sum_hi, limit);
+            }
+
+            const __m128i gray_mask = _mm_packs_epi16(
+                _mm_packs_epi32(gray_pass[0], gray_pass[1]),
+                _mm_packs_epi32(gray_pass[2], gray_pass[3])
+            );
+
+            const __m128i d0 = _mm_loadu_si128((const __m128i*)(depth + x));
+            const __m128i d1 = _mm_loadu_si128((const __m128i*)(depth + x + 8));
+
+            // unsigned d <= far  <=>  saturate(d - far) == 0
+            const __m128i near0 = _mm_cmpeq_epi16(_mm_subs_epu16(d0, far), zero);
+            const __m128i near1 = _mm_cmpeq_epi16(_mm_subs_epu16(d1, far), zero);
+            const __m128i valid0 = _mm_or_si128(_mm_xor_si128(_mm_cmpeq_epi16(d0, zero), _mm_set1_epi8(-1)), zero_keep);
+            const __m128i valid1 = _mm_or_si128(_mm_xor_si128(_mm_cmpeq_epi16(d1, zero), _mm_set1_epi8(-1)), zero_keep);
+
+            const __m128i depth_mask = _mm_packs_epi16(
+                _mm_and_si128(near0, valid0),
+                _mm_and_si128(near1, valid1)
+            );
+
+            _mm_storeu_si128((__m128i*)(mask + x), _mm_and_si128(gray_mask, depth_mask));
+        }
+
+        segmentRowScalar(bgr + 3 * x, depth + x, mask + x, n - x, param);
+    }
+
+    __attribute__((target("avx2")))
+    inline void segmentRowAVX2(
+        const uchar* bgr,
+        const uint16_t* depth,
+        uchar* mask,
+        int n,
+        const segParam& param
+    )
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i coeff_bg = _mm256_set1_epi32((9617 << 16) | 1868);
+        const __m256i coeff_r1 = _mm256_set1_epi32((8192 << 16) | 4899);
+        const __m256i one16 = _mm256_set1_epi16(1);
+        const __m256i limit = _mm256_set1_epi32(param.gray_limit - 1);
+        const __m256i far = _mm256_set1_epi16((short)param.depth_far);
+        const __m256i zero_keep = param.reject_zero_depth ? zero : _mm256_set1_epi8(-1);
+
+        int x = 0;
+        for(; x + 32 <= n; x += 32)
+        {
+            __m256i gray_pass16[2];
+
+            for(int half = 0; half < 2; half++)
+            {
+                __m128i b, g, r;
+                deinterleaveBGR(bgr + 3 * (x + 16 * half), b, g, r);
+
+                const __m256i b16 = _mm256_cvtepu8_epi16(b);
+                const __m256i g16 = _mm256_cvtepu8_epi16(g);
+                const __m256i r16 = _mm256_cvtepu8_epi16(r);
+
+                // in-lane unpack: lo = pixels 0-3 | 8-11, hi = pixels 4-7 | 12-15
+                const __m256i sum_lo = _mm256_add_epi32(
+                    _mm256_madd_epi16(_mm256_unpacklo_epi16(b16, g16), coeff_bg),
+                    _mm256_madd_epi16(_mm256_unpacklo_epi16(r16, one16), coeff_r1)
+                );
+                const __m256i sum_hi = _mm256_add_epi32(
+                    _mm256_madd_epi16(_mm256_unpackhi_epi16(b16, g16), coeff_bg),
+                    _mm256_madd_epi16(_mm256_unpackhi_epi16(r16, one16), coeff_r1)
+                );
+
+                // in-lane pack puts pixels 0-15 back in order
+                gray_pass16[half] = _mm256_packs_epi32(
+                    _mm256_cmpgt_epi32(sum_lo, limit),
+                    _mm256_cmpgt_epi32(sum_hi, limit)
+                );
+            }
+
+            const __m256i d0 = _mm256_loadu_si256((const __m256i*)(depth + x));
+            const __m256i d1 = _mm256_loadu_si256((const __m256i*)(depth + x + 16));
+
+            const __m256i near0 = _mm256_cmpeq_epi16(_mm256_subs_epu16(d0, far), zero);
+            const __m256i near1 = _mm256_cmpeq_epi16(_mm256_subs_epu16(d1, far), zero);
+            const __m256i valid0 = _mm256_or_si256(_mm256_xor_si256(_mm256_cmpeq_epi16(d0, zero), _mm256_set1_epi8(-1)), zero_keep);
+            const __m256i valid1 = _mm256_or_si256(_mm256_xor_si256(_mm256_cmpeq_epi16(d1, zero), _mm256_set1_epi8(-1)), zero_keep);
+
+            const __m256i pass0 = _mm256_and_si256(gray_pass16[0], _mm256_and_si256(near0, valid0));
+            const __m256i pass1 = _mm256_and_si256(gray_pass16[1], _mm256_and_si256(near1, valid1));
+
+            // in-lane pack gives 0-7 16-23 | 8-15 24-31, swap the middle quadwords back
+            const __m256i packed = _mm256_permute4x64_epi64(
+                _mm256_packs_epi16(pass0, pass1),
+                0xD8
+            );
+
+            _mm256_storeu_si256((__m256i*)(mask + x), packed);
+        }
+
+        segmentRowScalar(bgr + 3 * x, depth + x, mask + x, n - x, param);
+    }
+#endif
+
+#if LEDSEG_NEON
+    /* ================ arm ================ */
+    inline void segmentRowNEON(
+        const uchar* bgr,
+        const uint16_t* depth,
+        uchar* mask,
+        int n,
+        const segParam& param
+    )
+    {
+        const uint32x4_t limit = vdupq_n_u32((uint32_t)std::max(param.gray_limit, 0));
+        const uint32x4_t bias = vdupq_n_u32(8192);
+        const uint16x8_t far = vdupq_n_u16(param.depth_far);
+        const uint16x8_t zero_keep = vdupq_n_u16(param.reject_zero_depth ? 0 : 0xFFFF);
+
+        int x = 0;
+        for(; x + 16 <= n; x += 16)
+        {
+            const uint8x16x3_t px = vld3q_u8(bgr + 3 * x);
+
+            uint16x8_t gray_pass[2];
+            for(int half = 0; half < 2; half++)
+            {
+                const uint16x8_t b16 = vmovl_u8(half == 0 ? vget_low_u8(px.val[0]) : vget_high_u8(px.val[0]));
+                const uint16x8_t g16 = vmovl_u8(half == 0 ? vget_low_u8(px.val[1]) : vget_high_u8(px.val[1]));
+                const uint16x8_t r16 = vmovl_u8(half == 0 ? vget_low_u8(px.val[2]) : vget_high_u8(px.val[2]));
+
+                uint32x4_t sum_lo = vmlal_n_u16(bias, vget_low_u16(b16), 1868);
+                sum_lo = vmlal_n_u16(sum_lo, vget_low_u16(g16), 9617);
+                sum_lo = vmlal_n_u16(sum_lo, vget_low_u16(r16), 4899);
+
+                uint32x4_t sum_hi = vmlal_n_u16(bias, vget_high_u16(b16), 1868);
+                sum_hi = vmlal_n_u16(sum_hi, vget_high_u16(g16), 9617);
+                sum_hi = vmlal_n_u16(sum_hi, vget_high_u16(r16), 4899);
+
+                gray_pass[half] = vcombine_u16(
+                    vmovn_u32(vcgeq_u32(sum_lo, limit)),
+                    vmovn_u32(vcgeq_u32(sum_hi, limit))
+                );
+            }
+
+            const uint16x8_t d0 = vld1q_u16(depth + x);
+            const uint16x8_t d1 = vld1q_u16(depth + x + 8);
+
+            const uint16x8_t pass0 = vandq_u16(
+                gray_pass[0],
+                vandq_u16(vcleq_u16(d0, far), vorrq_u16(vtstq_u16(d0, d0), zero_keep))
+            );
+            const uint16x8_t pass1 = vandq_u16(
+                gray_pass[1],
+                vandq_u16(vcleq_u16(d1, far), vorrq_u16(vtstq_u16(d1, d1), zero_keep))
+            );
+
+            vst1q_u8(mask + x, vcombine_u8(vmovn_u16(pass0), vmovn_u16(pass1)));
+        }
+
+        segmentRowScalar(bgr + 3 * x, depth + x, mask + x, n - x, param);
+    }
+#endif
+
+    /* ================ dispatch ================ */
+    inline int getSegSIMD()
+    {
+#if LEDSEG_NEON
+        return SEG_NEON;
+#elif LEDSEG_X86
+        static const int level =
+            __builtin_cpu_supports("avx2") ? SEG_AVX2 :
+            (__builtin_cpu_supports("ssse3") ? SEG_SSSE3 : SEG_SCALAR);
+        return level;
+#else
+        return SEG_SCALAR;
+#endif
+    }
+
+    inline void segmentRow(
+        const uchar* bgr,
+        const uint16_t* depth,
+        uchar* mask,
+        int n,
+        const segParam& param,
+        int simd
+    )
+    {
+        switch (simd)
+        {
+#if LEDSEG_X86
+        case SEG_AVX2:
+            segmentRowAVX2(bgr, depth, mask, n, param);
+            break;
+        case SEG_SSSE3:
+            segmentRowSSSE3(bgr, depth, mask, n, param);
+            break;
+#endif
+#if LEDSEG_NEON
+        case SEG_NEON:
+            segmentRowNEON(bgr, depth, mask, n, param);
+            break;
+#endif
+        default:
+            segmentRowScalar(bgr, depth, mask, n, param);
+            break;
+        }
+    }
+
+    // appends the runs of one mask row, mask[0] sits at x_offset
+    inline void appendRuns(
+        const uchar* mask,
+        int n,
+        int row,
+        int x_offset,
+        std::vector<segRun>& runs
+    )
+    {
+        int x = 0;
+        while(x < n)
+        {
+            // LEDs are sparse, skip empty words
+            while(x + 8 <= n)
+            {
+                uint64_t word;
+                memcpy(&word, mask + x, 8);
+                if(word != 0)
+                    break;
+                x += 8;
+            }
+
+            while(x < n && mask[x] == 0)
+                x++;
+
+            if(x >= n)
+                break;
+
+            segRun run;
+            run.row = row;
+            run.x_begin = x + x_offset;
+
+            while(x < n && mask[x] != 0)
+                x++;
+
+            run.x_end = x + x_offset;
+            runs.push_back(run);
+        }
+    }
+
+    /* one pass over bgr (CV_8UC3) and aligned depth (CV_16UC1) inside roi.
+    mask is roi sized (CV_8U, 255 on LED pixels), runs are in full-frame coordinates.
+    both outputs keep their capacity between frames.
+    an empty depth turns the depth gate off, for callers that gate the detections later. */
+    inline bool segmentLED(
+        const cv::Mat& bgr,
+        const cv::Mat& depth,
+        cv::Rect roi,
+        const segParam& param,
+        cv::Mat& mask,
+        std::vector<segRun>& runs,
+        int simd = getSegSIMD()
+    )
+    {
+        runs.clear();
+
+        const bool depth_on = !depth.empty();
+
+        if(
+            bgr.type() != CV_8UC3
+            || (depth_on && (depth.type() != CV_16UC1 || bgr.size() != depth.size()))
+        )
+            return false;
+
+        roi &= cv::Rect(0, 0, bgr.cols, bgr.rows);
+        mask.create(roi.size(), CV_8U);
+
+        // without depth every pixel reads 0, which the gate keeps
+        static thread_local std::vector<uint16_t> no_depth;
+        segParam param_row = param;
+        if(!depth_on)
+        {
+            if(no_depth.size() < (size_t)roi.width)
+                no_depth.resize(roi.width, 0);
+            param_row.reject_zero_depth = false;
+        }
+
+        for(int y = 0; y < roi.height; y++)
+        {
+            uchar* mask_row = mask.ptr<uchar>(y);
+
+            segmentRow(
+                bgr.ptr<uchar>(roi.y + y) + 3 * roi.x,
+                depth_on ? depth.ptr<uint16_t>(roi.y + y) + roi.x : no_depth.data(),
+                mask_row,
+                roi.width,
+                param_row,
+                simd
+            );
+
+            appendRuns(mask_row, roi.width, roi.y + y, roi.x, runs);
+        }
+
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,355 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledTracker.h
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief LED pose estimation core: extraction, correspondence and AIEKF, without publishers or subscribers
+ */
+
+#ifndef LEDTRACKER_H
+#define LEDTRACKER_H
+
+#include "tools/essential.h"
+
+#include <std_msgs/Header.h>
+#include <sensor_msgs/CompressedImage.h>
+#include <sensor_msgs/Image.h>
+#include <cv_bridge/cv_bridge.h>
+
+#include <opencv2/calib3d.hpp>
+#include <sophus/se3.hpp>
+
+#include "tools/framePool.hpp"
+#include "tools/jpegDecoder.hpp"
+#include "tools/masterParams.hpp"
+#include "tools/spscRing.hpp"
+#include "tools/stageTracer.hpp"
+
+#include "aiekf.hpp"
+#include "cameraModel.hpp"
+#include "ledSegmentation.hpp"
+#include "depthSampler.hpp"
+#include "ledBlob.hpp"
+#include "ledColour.hpp"
+#include "ledMatcher.hpp"
+#include "ledAssociation.hpp"
+
+namespace correspondence
+{
+    typedef struct matchid
+        {
+            int detected_indices; //
+            bool detected_ornot = false;
+            double confidence = 0; // of the frame-to-frame association
+            Eigen::Vector3d pts_3d_correspond;
+            Eigen::Vector2d pts_2d_correspond;
+        }matchid;
+}
+
+namespace alan
+{
+    // hand-off between the stages: decode/extraction -> correspondence/AIEKF -> publish
+    typedef struct ledInput
+    {
+        sensor_msgs::CompressedImage::ConstPtr rgbmsg;
+        sensor_msgs::Image::ConstPtr depthmsg;
+        double tick = 0;    // arrival
+        bool display_on = false, input_on = false;  // debug images wanted for this frame
+    }ledInput;
+
+    typedef struct ledFrame
+    {
+        std_msgs::Header header;
+        double tick = 0;
+        cv_bridge::CvImageConstPtr depth_ptr;   // keeps the depth message alive
+        sensor_msgs::Image::ConstPtr depthmsg;  // same, when depth is only sampled
+        vision::depthView depth_view;
+        cv::Mat frame, depth, display, frame_input;
+        int frame_scale = 1;    // frame decoded at 1/frame_scale, detections are in full-frame pixels
+        bool display_on = false, input_on = false;
+        bool tracking = false;  // extracted in the predicted ROI, else full frame for initialization
+        bool reset = false;     // camera stalled, drop the track
+
+        std::vector<Eigen::Vector2d> pts_2d_detect;
+        std::vector<vision::ledBlob> blobs;
+        double min_blob_size = 0;
+
+        int frame_reallocs = 0;
+        long total_reallocs = 0;
+        int ROI_decode_no = 0;
+        double ms_front = 0;
+    }ledFrame;
+
+    typedef struct ledReport
+    {
+        std_msgs::Header header;
+        double tick = 0;
+        bool tracked = false, tracker_started = false, publish_pose = false;
+        Sophus::SE3d pose, velo;
+        Eigen::MatrixXd cov;
+
+        double BA_error = 0, depth_avg = 0;
+        int detect_no = 0;
+
+        cv::Mat display, frame_input;
+        bool display_on = false, input_on = false;
+
+        int frame_reallocs = 0;
+        long total_reallocs = 0;
+        int ROI_decode_no = 0;
+        long stale_no = 0;
+        long recover_no = 0;
+        double ms_front = 0, ms_estimate = 0;
+    }ledReport;
+
+    // last posterior, estimator -> decode for the ROI
+    typedef struct ledPrior
+    {
+        bool tracked = false;
+        bool recovering = false;    // lost, the rest is the last good posterior
+        double stamp = 0;
+        Sophus::SE3d pose, velo;
+        double sigma_p = 0, sigma_v = 0;    // its position (m) and velocity (m/s) spread
+    }ledPrior;
+
+    /* everything between a synchronized rgb/depth pair and the LED pose in the
+    camera frame. front_end() and estimate() may run on two threads, each only
+    touches its own members, the posterior for the next ROI goes back in ledPrior.
+    no ros::NodeHandle and no ros::Time::now(), so LedNodelet and the offline
+    benchmark (tools/led_bench.cpp) run the very same code. */
+    class ledTracker : private kf::aiekf
+    {
+        //primary objects
+            //frames, the estimator's view of the current ledFrame
+            cv::Mat frame, display;
+            cv::Mat frame_input;
+            int frame_scale = 1;
+            bool display_on = false;
+            bool input_on = false;
+
+            // recycled buffers, debug images are only filled when watched
+            vision::framePool frame_pool;
+
+            // partial decode, ROI while tracking, DCT-scaled for initialization
+            vision::jpegDecoder jpeg_decoder;
+            bool ROI_decode_on = true;
+            int init_decode_scale = 1;
+            int ROI_decode_no = 0;
+
+            vision::spscRing<ledPrior, 2> ring_prior;
+            ledPrior prior_front;
+            long stale_no = 0;
+            bool pose_to_publish = false;
+
+            vision::stageTracer stage_tracer;
+
+            //time related
+            std_msgs::Header led_pose_header, led_pose_header_previous;
+            double last_request = 0;
+            bool frame_received = false;
+
+            //LED config and correspondences
+            std::vector<Eigen::Vector3d> pts_on_body_frame;
+
+            // detect_no, correspondences(in order of 0->5)
+            std::tuple<int, std::vector<correspondence::matchid>> corres_global_current;
+            std::tuple<int, std::vector<correspondence::matchid>> corres_global_previous;
+
+            //poses
+            Sophus::SE3d pose_global_sophus;
+            Sophus::SE3d velo_global_sophus;
+            Eigen::MatrixXd covariance_global_sophus;
+
+            Sophus::SE3d pose_epnp_sophus;
+
+        //secondary objects
+            int i = 0;
+            bool tracker_started = false;
+
+            std::vector<vision::ledBlob> blobs_for_initialize;
+            int _width = 0, _height = 0;
+
+        //stages
+            double tick_front = 0;
+            bool decode_frame(const sensor_msgs::CompressedImage::ConstPtr & rgbmsg, ledFrame& item);
+
+            inline double get_deltaT(double stamp, double stamp_previous)
+            {
+                // stale or negative stamps, just use the last posterior
+                double deltaT_ = stamp - stamp_previous;
+                return (deltaT_ < 0 || deltaT_ > 0.1) ? 0 : deltaT_;
+            }
+
+        //main process & kf
+            void solve_pose_w_LED(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth, bool windowed);
+            void apiKF(int DOKF);
+            void recursive_filtering(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth);
+
+        //LED extraction tool
+            //objects
+            double LANDING_DISTANCE = 0;
+            int BINARY_THRES = 0;
+            cv::Rect rect_ROI_predicted;                    // bounding box of ROIs_merged, what gets decoded
+            std::vector<cv::Rect> ROIs_front, ROIs_merged;  // one window per tracked target
+            std::vector<vision::ledBlob> blobs_ROI;
+            Sophus::SE3d pose_priori_sophus;
+            std::vector<vision::segRun> seg_runs;
+            vision::ledBlobExtractor blob_extractor;
+
+            // sample() is shared by the decode and estimation stages, backproject() is estimation only
+            vision::depthSampler depth_sampler;
+            bool depth_sparse = false;
+
+            std::vector<Eigen::Vector3d> pts_on_body_frame_in_corres_order;
+            std::vector<Eigen::Vector2d> pts_detected_in_corres_order;
+
+            void LED_extract_POI(ledFrame& item);
+            void LED_extract_POI_alter(ledFrame& item);
+            void LED_depth_gate(ledFrame& item);
+            std::vector<Eigen::Vector3d> pointcloud_generate(
+                const std::vector<Eigen::Vector2d>& pts_2d_detected,
+                const vision::depthView& depth
+            );
+            cv::Rect get_predicted_ROI(const Sophus::SE3d& pose_priori, double margin = 0);
+
+        // correspondence search
+            //objects
+            int LED_no;
+            int LED_r_no;
+            int LED_g_no;
+            std::vector<Eigen::Vector2d> pts_2d_detect_correct_order;
+            correspondence::gatedAssigner led_assigner;
+            cv::Point3f pcl_center_point_wo_outlier_previous;
+            Eigen::Vector3d led_3d_posi_in_camera_frame_depth;
+
+            //functions
+            void get_correspondence(
+                std::vector<Eigen::Vector2d>& pts_2d_detected
+            );
+            void reject_outlier(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth);
+
+        // initialization
+            //objects
+            bool LED_tracker_initiated_or_tracked = false;
+            double MAD_dilate, MAD_max;
+            double MAD_x_threshold = 0, MAD_y_threshold = 0, MAD_z_threshold = 0;
+            double min_blob_size = 0;
+            vision::ledColourClassifier colour_classifier;
+            std::vector<vision::ledColour> colours;
+            std::vector<int> colour_order;
+            double colour_flip_conf = 0.2;  // a miscount may only move blobs less sure than this
+            correspondence::constellationMatcher constellation_matcher;
+            correspondence::matchStats match_stats;
+            //functions
+            bool initialization(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth);
+            void solve_pnp_initial_pose(
+                std::vector<Eigen::Vector2d> pts_2d,
+                std::vector<Eigen::Vector3d> body_frame_pts
+            );
+            double calculate_MAD(std::vector<double> norm_of_points);
+
+        // recovery, between a lost track and full initialization
+            //objects
+            double recovery_timeout = 0.5;  // s after the last good posterior, 0 for none
+            double recovery_sigma = 3.0;
+            double recovery_accel = 5.0;    // m/s^2 the constant velocity model leaves out
+            double recovery_max_area = 0.5; // window over frame, beyond it the full frame is searched
+            bool recovering = false;
+            ledPrior last_good;
+            Eigen::Matrix<double, 6, 6> P_last_good;
+            long recover_no = 0;
+            //functions
+            void keep_last_good();
+            bool relocalize(std::vector<Eigen::Vector2d>& pts_2d_detect);
+
+            // how far (m) the vehicle may be from the extrapolated last good pose, dt after it
+            inline double recovery_radius(const ledPrior& prior, double dt) const
+            {
+                return recovery_sigma * (prior.sigma_p + prior.sigma_v * dt) + 0.5 * recovery_accel * dt * dt;
+            };
+
+        // report
+            int detect_no = 0;
+            double BA_error = 0;
+            double depth_avg_of_all = 0;
+
+            double get_reprojection_error(
+                std::vector<Eigen::Vector3d> pts_3d,
+                std::vector<Eigen::Vector2d> pts_2d,
+                Sophus::SE3d pose,
+                bool draw_reproject
+            ) override
+            {
+                double e = 0;
+
+                Eigen::Vector2d reproject, error;
+
+                for(int i = 0; i < pts_3d.size(); i++)
+                {
+                    reproject = reproject_3D_2D(pts_3d[i], pose);
+                    error = pts_2d[i] - reproject;
+                    e = e + error.norm();
+
+                    if(draw_reproject && display_on)
+                        cv::circle(display, cv::Point(reproject(0), reproject(1)), 2.5, CV_RGB(0,255,0),-1);
+                }
+
+                return e;
+            };
+
+        //configs
+            void POI_config(const masterParams& params);
+            void camIntrinsic_config(const masterParams& params);
+            void LEDInBodyAndOutlierSetting_config(const masterParams& params);
+            void KF_config(const masterParams& params);
+
+        public:
+            ledTracker(){};
+            ~ledTracker(){};
+
+            // every "/alan_master" key the estimation reads, false if the LED constellation is missing
+            bool config(const masterParams& params);
+
+            // frames still held after estimate() (pipeline rings, debug images) keep their buffers
+            void setFramesInFlight(bool in_flight);
+
+            // decode/extraction, false if the frame cannot be used
+            bool front_end(const ledInput& input, ledFrame& item);
+
+            /* front_end() in three steps, so that ledMultiTracker decodes and
+            segments once for several targets:
+            begin_frame() takes the depth and flags a stalled camera,
+            predict_ROI() is this target's window, false while neither tracking nor recovering,
+            extract() decodes and segments inside ROIs if item.tracking, else the full frame. */
+            bool begin_frame(const ledInput& input, ledFrame& item);
+            bool predict_ROI(double stamp, bool reset, cv::Rect& ROI);
+            bool extract(const ledInput& input, ledFrame& item, const std::vector<cv::Rect>& ROIs);
+            // correspondence/AIEKF, item is consumed
+            void estimate(ledFrame& item, ledReport& report);
+
+            inline vision::stageTracer* getTracer() {return tracer ? tracer : &stage_tracer;};
+            // spans go to another tracker's tracer, after config()
+            inline void setTracer(vision::stageTracer* shared) {tracer = shared;};
+            inline const vision::depthSampler& getDepthSampler() const {return depth_sampler;};
+            inline int getLEDNo() const {return LED_no;};
+    };
+}
+
+#endif
@@ -44,6 +44,9 @@
 #include "alan_visualization/PolyhedronArray.h"
 
 #include "tools/RosTopicConfigs.h"
+#include "imuPropagator.hpp"
+
+#include <mutex>
 
 #define UAV_VRPN_POSE_SUB_TOPIC POSE_SUB_TOPIC_A
 #define UAV_VRPN_TWIST_SUB_TOPIC TWIST_SUB_TOPIC_A
@@ -69,6 +72,7 @@ namespace alan
             ros::Publisher ugv_pub_AlanPlannerMsg;
             ros::Publisher alan_sfc_pub;            
             ros::Publisher alan_all_sfc_pub;
+            ros::Publisher uav_imu_odom_pub;
 
         //subscriber
             //objects
@@ -92,6 +96,13 @@ namespace alan
             nav_msgs::Odometry led_odom;             
             bool led_odom_inititated = false;
 
+            // IMU_propagation_on: the uav planner message at IMU rate, /led fixes replayed over the IMU history
+            kf::imuPropagator uav_propagator;
+            bool imu_propagation_on = false;
+            double uav_imu_last_arrival = 0;
+            // the uav state & its message, written by the led, imu and vrpn callbacks, which run in parallel
+            std::mutex uav_state_mutex;
+
             //functions                    
             void uav_vrpn_pose_callback(const geometry_msgs::PoseStamped::ConstPtr& pose);
             void uav_vrpn_twist_callback(const geometry_msgs::TwistStamped::ConstPtr& twist);
@@ -102,6 +113,7 @@ namespace alan
             void ugv_imu_callback(const sensor_msgs::Imu::ConstPtr& imu);
 
             void led_odom_callback(const nav_msgs::Odometry::ConstPtr& odom);
+            void uav_propagation_publish(const ros::Time& stamp);   // uav_state_mutex held
         
              
             //private variables 
@@ -179,6 +191,11 @@ namespace alan
                 
                 setup_camera_config(nh);
 
+                nh.getParam("/alan_master/IMU_propagation_on", imu_propagation_on);
+                nh.getParam("/alan_master/IMU_history", uav_propagator.history);
+                nh.getParam("/alan_master/IMU_max_gap", uav_propagator.max_gap);
+                nh.getParam("/alan_master/IMU_horizon", uav_propagator.horizon);
+
                 RosTopicConfigs configs(nh, "/msgsync");
 
             //subscriber
@@ -220,6 +237,9 @@ namespace alan
 
                 alan_all_sfc_pub = nh.advertise<alan_visualization::PolyhedronArray>
                         ("/alan_state_estimation/msgsync/polyhedron_array", 1);   
+
+                uav_imu_odom_pub = nh.advertise<nav_msgs::Odometry>
+                        ("/alan_state_estimation/msgsync/uav/imu_odom", 1);
             }      
 
     };
@@ -0,0 +1,350 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file poseRefine.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief PnP pose refinement: Levenberg-Marquardt on SE3 with fixed-size Jacobians and robust kernels
+ */
+
+#ifndef POSEREFINE_HPP
+#define POSEREFINE_HPP
+
+#include <Eigen/Dense>
+#include <sophus/se3.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace vision
+{
+    enum refineKernel
+    {
+        KERNEL_NONE,
+        KERNEL_HUBER,
+        KERNEL_CAUCHY
+    };
+
+    enum refineStatus
+    {
+        REFINE_CONVERGED,       // step below converge_threshold, or cost no longer decreasing
+        REFINE_MAX_ITERATION,   // still moving after max_iteration
+        REFINE_DIVERGED,        // a point behind the camera or a non-finite step, pose left at the last good value
+        REFINE_DEGENERATE       // fewer than 3 points, or normal equations that stay singular
+    };
+
+    typedef struct refineResult
+    {
+        refineStatus status = REFINE_MAX_ITERATION;
+        int iterations = 0;
+        double cost = std::numeric_limits<double>::infinity();    // 0.5 * sum of rho(|e|^2) under the kernel
+        double error = std::numeric_limits<double>::infinity();   // sum of |e| (px), as get_reprojection_error()
+    }refineResult;
+
+    // one pose hypothesis of a batch, pts_2d[corres[j]] observes pts_3d[j], identity when corres is null
+    typedef struct poseCandidate
+    {
+        Sophus::SE3d pose;
+        const int* corres = nullptr;
+        refineResult result;
+    }poseCandidate;
+
+    inline refineKernel kernelFromString(const std::string& name)
+    {
+        if(name == "huber")
+            return KERNEL_HUBER;
+        if(name == "cauchy")
+            return KERNEL_CAUCHY;
+        return KERNEL_NONE;
+    }
+
+    /* minimises 0.5 * sum rho(|u(exp(dx) * pose * P_j) - p_j|^2) over the left perturbation
+    dx = [translation, rotation], the same convention as cameraModel and the AIEKF.
+    robust kernels enter as IRLS weights rho'(|e|^2) on each 2x6 block, recomputed at
+    every linearisation. damping is Nielsen's, scaled by diag(H). */
+    class poseRefiner
+    {
+    private:
+        double fx = 1, fy = 1, cx = 0, cy = 0;
+
+        // rho(s) and its derivative w, s = |e|^2
+        inline double rho(double s, double kernel_sq, double& w) const
+        {
+            switch(kernel)
+            {
+            case KERNEL_HUBER:
+                if(s <= kernel_sq)
+                {
+                    w = 1;
+                    return s;
+                }
+                else
+                {
+                    const double r = std::sqrt(s);
+                    w = kernel_px / r;
+                    return 2 * kernel_px * r - kernel_sq;
+                }
+            case KERNEL_CAUCHY:
+                w = 1 / (1 + s / kernel_sq);
+                return kernel_sq * std::log1p(s / kernel_sq);
+            default:
+                w = 1;
+                return s;
+            }
+        }
+
+        /* cost at pose, with H / g accumulated when H is given.
+        returns infinity if a point is not in front of the camera. */
+        double evaluate(
+            const Sophus::SE3d& pose,
+            const std::vector<Eigen::Vector3d>& pts_3d,
+            const std::vector<Eigen::Vector2d>& pts_2d,
+            const int* corres,
+            Eigen::Matrix<double, 6, 6>* H,
+            Eigen::Matrix<double, 6, 1>* g,
+            double& error
+        ) const
+        {
+            const Eigen::Matrix3d R = pose.rotationMatrix();
+            const Eigen::Vector3d t = pose.translation();
+
+            Eigen::Matrix<double, 2, 6> J;
+            Eigen::Vector2d e;
+            const double kernel_sq = kernel_px * kernel_px;
+            double cost = 0, w;
+
+            if(H)
+            {
+                H->setZero();
+                g->setZero();
+            }
+            error = 0;
+
+            for(int j = 0; j < (int)pts_3d.size(); j++)
+            {
+                const Eigen::Vector3d Pc = R * pts_3d[j] + t;
+                if(!(Pc.z() > 1e-6))
+                {
+                    error = std::numeric_limits<double>::infinity();
+                    return std::numeric_limits<double>::infinity();
+                }
+
+                const Eigen::Vector2d& p = pts_2d[corres ? corres[j] : j];
+                const double z_inv = 1.0 / Pc.z();
+                e <<
+                    fx * Pc.x() * z_inv + cx - p.x(),
+                    fy * Pc.y() * z_inv + cy - p.y();
+
+                const double s = e.squaredNorm();
+                cost += rho(s, kernel_sq, w);
+                error += std::sqrt(s);
+
+                if(!H)
+                    continue;
+
+                jacobian(J, Pc);
+                H->noalias() += w * J.transpose() * J;
+                g->noalias() += w * J.transpose() * e;
+            }
+
+            return 0.5 * cost;
+        }
+
+    public:
+        poseRefiner(){};
+        ~poseRefiner(){};
+
+        int max_iteration = 20;
+        double converge_threshold = 1e-6;   // on |dx|
+        double cost_tolerance = 1e-6;       // on the relative decrease of an accepted step
+        double lm_tau = 1e-5;
+        refineKernel kernel = KERNEL_NONE;
+        double kernel_px = 2.0;             // kernel width (px)
+
+        template<typename Derived>
+        inline void setCamera(const Eigen::MatrixBase<Derived>& K)
+        {
+            fx = K(0,0);
+            fy = K(1,1);
+            cx = K(0,2);
+            cy = K(1,2);
+        }
+
+        inline void setKernel(refineKernel kernel_, double kernel_px_)
+        {
+            kernel = kernel_;
+            kernel_px = kernel_px_;
+        }
+
+        // d u / d dx at the camera-frame point Pc
+        inline void jacobian(Eigen::Matrix<double, 2, 6>& J, const Eigen::Vector3d& Pc) const
+        {
+            const double x = Pc.x(), y = Pc.y();
+            const double z_inv = 1.0 / Pc.z();
+            const double z2_inv = z_inv * z_inv;
+
+            J <<
+                fx * z_inv, 0, -fx * x * z2_inv, -fx * x * y * z2_inv, fx + fx * x * x * z2_inv, -fx * y * z_inv,
+                0, fy * z_inv, -fy * y * z2_inv, -fy - fy * y * y * z2_inv, fy * x * y * z2_inv, fy * x * z_inv;
+        }
+
+        // pose is refined in place, and kept at its last accepted value whatever the status
+        refineResult refine(
+            Sophus::SE3d& pose,
+            const std::vector<Eigen::Vector3d>& pts_3d,
+            const std::vector<Eigen::Vector2d>& pts_2d,
+            const int* corres = nullptr
+        ) const
+        {
+            refineResult result;
+
+            Eigen::Matrix<double, 6, 6> H, H_trial;
+            Eigen::Matrix<double, 6, 1> g, dx, D;
+            double error_trial;
+
+            if(pts_3d.size() < 3 || (!corres && pts_2d.size() < pts_3d.size()))
+            {
+                result.status = REFINE_DEGENERATE;
+                return result;
+            }
+
+            result.cost = evaluate(pose, pts_3d, pts_2d, corres, &H, &g, result.error);
+
+            if(!std::isfinite(result.cost))
+            {
+                result.status = REFINE_DIVERGED;
+                return result;
+            }
+
+            double mu = lm_tau, nu = 2;
+
+            for(result.iterations = 0; result.iterations < max_iteration; result.iterations++)
+            {
+                D = H.diagonal().cwiseMax(1e-6);
+                H_trial = H;
+                H_trial.diagonal() += mu * D;
+
+                Eigen::LLT<Eigen::Matrix<double, 6, 6>> llt(H_trial);
+                if(llt.info() != Eigen::Success)
+                {
+                    mu *= nu;
+                    nu *= 2;
+                    if(mu > 1e16)
+                    {
+                        result.status = REFINE_DEGENERATE;
+                        return result;
+                    }
+                    continue;
+                }
+
+                dx = -llt.solve(g);
+                if(!dx.allFinite())
+                {
+                    result.status = REFINE_DIVERGED;
+                    return result;
+                }
+
+                const Sophus::SE3d pose_trial = Sophus::SE3d::exp(dx) * pose;
+                const bool small = dx.norm() < converge_threshold;
+
+                const double cost_trial = evaluate(pose_trial, pts_3d, pts_2d, corres, nullptr, nullptr, error_trial);
+                const double predicted = 0.5 * dx.dot(mu * D.cwiseProduct(dx) - g);
+                const double rho_gain = predicted > 0 ? (result.cost - cost_trial) / predicted : -1;
+
+                if(small)
+                {
+                    // at the minimum, the trial only differs by round-off
+                    if(cost_trial <= result.cost)
+                    {
+                        pose = pose_trial;
+                        result.cost = cost_trial;
+                        result.error = error_trial;
+                    }
+                    result.iterations++;
+                    result.status = REFINE_CONVERGED;
+                    return result;
+                }
+
+                if(rho_gain > 0)
+                {
+                    const double cost_last = result.cost;
+
+                    pose = pose_trial;
+                    result.cost = evaluate(pose, pts_3d, pts_2d, corres, &H, &g, result.error);
+
+                    // the reweighted problem has settled
+                    if(cost_last - result.cost <= cost_tolerance * cost_last)
+                    {
+                        result.iterations++;
+                        result.status = REFINE_CONVERGED;
+                        return result;
+                    }
+
+                    const double a = 2 * rho_gain - 1;
+                    mu *= std::max(1.0 / 3, 1 - a * a * a);
+                    nu = 2;
+                }
+                else
+                {
+                    mu *= nu;
+                    nu *= 2;
+                }
+            }
+
+            result.status = REFINE_MAX_ITERATION;
+            return result;
+        }
+
+        /* every candidate refined against the same points, each with its own correspondence.
+        returns the index of the lowest reprojection error, -1 if none ended finite.
+        ties go to the lower index. */
+        int refineBatch(
+            poseCandidate* candidates,
+            int candidate_no,
+            const std::vector<Eigen::Vector3d>& pts_3d,
+            const std::vector<Eigen::Vector2d>& pts_2d
+        ) const
+        {
+            int best = -1;
+            double error_best = std::numeric_limits<double>::infinity();
+
+            for(int k = 0; k < candidate_no; k++)
+            {
+                poseCandidate& c = candidates[k];
+                c.result = refine(c.pose, pts_3d, pts_2d, c.corres);
+
+                if(c.result.status == REFINE_DEGENERATE || c.result.status == REFINE_DIVERGED)
+                    continue;
+
+                if(c.result.error < error_best)
+                {
+                    error_best = c.result.error;
+                    best = k;
+                }
+            }
+
+            return best;
+        }
+    };
+}
+
+#endif
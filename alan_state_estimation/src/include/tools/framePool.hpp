@@ -0,0 +1,168 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file framePool.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief recycled per-frame image buffers, so that the steady state runs without heap allocation
+ */
+
+#ifndef FRAMEPOOL_HPP
+#define FRAMEPOOL_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace vision
+{
+    // one buffer per role in the per-frame pipeline
+    enum POOL_SLOT
+    {
+        POOL_COLOR,         // decoded bgr frame
+        POOL_COLOR_SCALED,  // DCT-scaled decode, initialization runs on it
+        POOL_GRAY,          // full-frame LED mask
+        POOL_ROI,           // LED mask of the ROIs, frame sized, used through a view
+        POOL_DISPLAY,       // "/processed_image"
+        POOL_INPUT,         // "/input_image"
+        POOL_SLOT_NO
+    };
+
+    // alternates per slot, for frames still held by later pipeline stages
+    static const int POOL_DEPTH_MAX = 8;
+
+    class framePool
+    {
+    private:
+        std::array<std::array<cv::Mat, POOL_DEPTH_MAX>, POOL_SLOT_NO> buffers;
+        std::array<int, POOL_SLOT_NO> current = {};
+        int depth = 1;
+
+        int reallocs_this_frame = 0;
+        long reallocs_total = 0;
+        long frames = 0;
+
+        // cv::Mat::create() keeps the old buffer when size and type match,
+        // so a moved data pointer means the slot got a fresh buffer; only the
+        // pool's own slots, not what OpenCV or the rest of the frame allocates
+        inline void count(const cv::Mat& buffer, const uchar* data_before)
+        {
+            if(buffer.data != data_before)
+            {
+                reallocs_this_frame++;
+                reallocs_total++;
+            }
+        }
+
+        // anyone besides the pool still looking at it
+        inline bool shared(const cv::Mat& buffer)
+        {
+            return buffer.u && buffer.u->refcount > 1;
+        }
+
+        inline void rotate(int slot)
+        {
+            // nobody downstream kept it, no reason to touch another buffer
+            if(!shared(buffers[slot][current[slot]]))
+                return;
+
+            for(int k = 1; k <= depth; k++)
+            {
+                const int idx = (current[slot] + k) % depth;
+                if(!shared(buffers[slot][idx]))
+                {
+                    current[slot] = idx;
+                    return;
+                }
+            }
+
+            // all still in use downstream, let them keep theirs, create() allocates anew
+            current[slot] = (current[slot] + 1) % depth;
+            buffers[slot][current[slot]].release();
+        }
+
+    public:
+        framePool(){};
+        ~framePool(){};
+
+        /* with depth > 1 a slot still referenced elsewhere at beginFrame() moves on
+        to a buffer nobody else references, so frames handed to other threads are
+        never overwritten, and only as many buffers as are in flight get allocated.
+        depth 1 keeps one buffer per slot, for a strictly serial caller. */
+        inline void setDepth(int depth_)
+        {
+            depth = std::max(1, std::min(depth_, POOL_DEPTH_MAX));
+        }
+
+        inline void beginFrame()
+        {
+            reallocs_this_frame = 0;
+            frames++;
+
+            if(depth > 1)
+                for(int slot = 0; slot < POOL_SLOT_NO; slot++)
+                    rotate(slot);
+        }
+
+        inline cv::Mat& get(int slot)
+        {
+            return buffers[slot][current[slot]];
+        }
+
+        inline cv::Mat& acquire(int slot, cv::Size size, int type)
+        {
+            cv::Mat& buffer = get(slot);
+            const uchar* data_before = buffer.data;
+
+            buffer.create(size, type);
+            count(buffer, data_before);
+
+            return buffer;
+        }
+
+        inline cv::Mat& decode(int slot, const std::vector<uchar>& data, int flags)
+        {
+            cv::Mat& buffer = get(slot);
+            const uchar* data_before = buffer.data;
+
+            cv::imdecode(data, flags, &buffer);
+            count(buffer, data_before);
+
+            return buffer;
+        }
+
+        inline cv::Mat& copy(int slot, const cv::Mat& src)
+        {
+            cv::Mat& buffer = acquire(slot, src.size(), src.type());
+            src.copyTo(buffer);
+
+            return buffer;
+        }
+
+        // slot buffers replaced this frame & since start, 0 once the sizes settle
+        inline int getFrameReallocs(){return reallocs_this_frame;};
+        inline long getTotalReallocs(){return reallocs_total;};
+        inline long getFrameNo(){return frames;};
+    };
+}
+
+#endif
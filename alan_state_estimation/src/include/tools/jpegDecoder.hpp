@@ -0,0 +1,202 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file jpegDecoder.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief partial JPEG decoding with libjpeg-turbo: ROI (MCU cropped) and DCT-scaled
+ */
+
+#ifndef JPEGDECODER_HPP
+#define JPEGDECODER_HPP
+
+#include <opencv2/core.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <csetjmp>
+#include <vector>
+
+#include <jpeglib.h>
+
+// jpeg_crop_scanline(), jpeg_skip_scanlines() and JCS_EXT_BGR are libjpeg-turbo only,
+// without them every call reports failure and the caller falls back to cv::imdecode
+#if defined(LIBJPEG_TURBO_VERSION) && defined(JCS_EXTENSIONS)
+#define JPEG_PARTIAL_DECODE_ON 1
+#else
+#define JPEG_PARTIAL_DECODE_ON 0
+#endif
+
+namespace vision
+{
+    class jpegDecoder
+    {
+    private:
+        typedef struct errorMgr
+        {
+            jpeg_error_mgr pub;
+            jmp_buf jump;
+        }errorMgr;
+
+        jpeg_decompress_struct cinfo;
+        errorMgr jerr;
+
+        // rows handed to libjpeg per jpeg_read_scanlines() call
+        static const int ROW_BATCH = 16;
+        JSAMPROW rows[ROW_BATCH];
+
+        static void onError(j_common_ptr cinfo_)
+        {
+            errorMgr* err = (errorMgr*) cinfo_->err;
+            longjmp(err->jump, 1);
+        }
+
+        // corrupt-data warnings are not worth a print per frame
+        static void onMessage(j_common_ptr){};
+
+    public:
+        jpegDecoder()
+        {
+            cinfo.err = jpeg_std_error(&jerr.pub);
+            jerr.pub.error_exit = onError;
+            jerr.pub.output_message = onMessage;
+            jpeg_create_decompress(&cinfo);
+        };
+
+        ~jpegDecoder()
+        {
+            jpeg_destroy_decompress(&cinfo);
+        };
+
+        /* decode only the scanlines and MCU columns that cover roi,
+        straight into dst at their full-frame position.
+        dst has to hold a full-frame CV_8UC3 image already, pixels outside
+        the decoded area are left untouched.
+        on success roi is widened to the area actually decoded, pixels inside
+        the requested roi are identical to a full decode. */
+        bool decodeROI(const std::vector<uchar>& data, cv::Mat& dst, cv::Rect& roi)
+        {
+#if JPEG_PARTIAL_DECODE_ON
+            if(data.empty() || dst.empty() || dst.type() != CV_8UC3 || roi.area() <= 0)
+                return false;
+
+            if(roi.x < 0 || roi.y < 0 || roi.x + roi.width > dst.cols || roi.y + roi.height > dst.rows)
+                return false;
+
+            if(setjmp(jerr.jump))
+            {
+                jpeg_abort_decompress(&cinfo);
+                return false;
+            }
+
+            jpeg_mem_src(&cinfo, data.data(), data.size());
+            jpeg_read_header(&cinfo, TRUE);
+
+            if(
+                cinfo.image_width != (JDIMENSION)dst.cols
+                ||
+                cinfo.image_height != (JDIMENSION)dst.rows
+            )
+            {
+                jpeg_abort_decompress(&cinfo);
+                return false;
+            }
+
+            cinfo.out_color_space = JCS_EXT_BGR;
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = 1;
+
+            jpeg_start_decompress(&cinfo);
+
+            // fancy upsampling smears the last column of a crop,
+            // so ask for one more iMCU on each side than needed
+            const int imcu = cinfo.max_h_samp_factor * DCTSIZE;
+            const int x_begin = std::max(roi.x - imcu, 0);
+            const int x_end = std::min(roi.x + roi.width + imcu, dst.cols);
+
+            JDIMENSION xoffset = x_begin;
+            JDIMENSION width = x_end - x_begin;
+            jpeg_crop_scanline(&cinfo, &xoffset, &width);
+
+            const JDIMENSION row_end = roi.y + roi.height;
+            if(roi.y > 0)
+                jpeg_skip_scanlines(&cinfo, roi.y);
+
+            while(cinfo.output_scanline < row_end)
+            {
+                int batch = 0;
+                for(; batch < ROW_BATCH && cinfo.output_scanline + batch < row_end; batch++)
+                    rows[batch] = dst.ptr<uchar>(cinfo.output_scanline + batch) + xoffset * 3;
+
+                jpeg_read_scanlines(&cinfo, rows, batch);
+            }
+
+            // rows below the ROI are never decoded
+            jpeg_abort_decompress(&cinfo);
+
+            roi = cv::Rect(xoffset, roi.y, width, roi.height);
+            return true;
+#else
+            return false;
+#endif
+        };
+
+        // DCT-domain downscaled decode, scale is 2, 4 or 8
+        bool decodeScaled(const std::vector<uchar>& data, cv::Mat& dst, int scale)
+        {
+#if JPEG_PARTIAL_DECODE_ON
+            if(data.empty() || (scale != 2 && scale != 4 && scale != 8))
+                return false;
+
+            if(setjmp(jerr.jump))
+            {
+                jpeg_abort_decompress(&cinfo);
+                return false;
+            }
+
+            jpeg_mem_src(&cinfo, data.data(), data.size());
+            jpeg_read_header(&cinfo, TRUE);
+
+            cinfo.out_color_space = JCS_EXT_BGR;
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = scale;
+
+            jpeg_start_decompress(&cinfo);
+
+            dst.create(cinfo.output_height, cinfo.output_width, CV_8UC3);
+
+            while(cinfo.output_scanline < cinfo.output_height)
+            {
+                int batch = 0;
+                for(; batch < ROW_BATCH && cinfo.output_scanline + batch < cinfo.output_height; batch++)
+                    rows[batch] = dst.ptr<uchar>(cinfo.output_scanline + batch);
+
+                jpeg_read_scanlines(&cinfo, rows, batch);
+            }
+
+            jpeg_finish_decompress(&cinfo);
+            return true;
+#else
+            return false;
+#endif
+        };
+    };
+}
+
+#endif
@@ -0,0 +1,137 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file masterParams.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief the /alan_master parameters as one XmlRpc struct, from the parameter server or any other source
+ */
+
+#ifndef MASTERPARAMS_HPP
+#define MASTERPARAMS_HPP
+
+#include <ros/ros.h>
+#include <xmlrpcpp/XmlRpcValue.h>
+
+#include <string>
+
+namespace alan
+{
+    /* getParam() behaves as ros::NodeHandle::getParam() on "/alan_master/<key>":
+    false and value untouched if the key is missing or of another type,
+    ints are taken for doubles. */
+    class masterParams
+    {
+    private:
+        // XmlRpcValue only converts from non-const
+        mutable XmlRpc::XmlRpcValue root;
+
+        inline XmlRpc::XmlRpcValue* find(const std::string& key) const
+        {
+            if(root.getType() != XmlRpc::XmlRpcValue::TypeStruct || !root.hasMember(key))
+                return nullptr;
+
+            return &root[key];
+        }
+
+    public:
+        masterParams(){};
+        masterParams(const XmlRpc::XmlRpcValue& root_) : root(root_){};
+        ~masterParams(){};
+
+        // the whole namespace in one call, no master needed afterwards
+        inline bool fromParamServer(ros::NodeHandle& nh, const std::string& ns = "/alan_master")
+        {
+            return nh.getParam(ns, root) && root.getType() == XmlRpc::XmlRpcValue::TypeStruct;
+        }
+
+        // a copy with the members of overrides (a struct) put in place of its own
+        inline masterParams overlay(const XmlRpc::XmlRpcValue& overrides) const
+        {
+            masterParams result(root);
+
+            if(overrides.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+                return result;
+
+            XmlRpc::XmlRpcValue members = overrides;
+            for(auto it = members.begin(); it != members.end(); ++it)
+                result.root[it->first] = it->second;
+
+            return result;
+        }
+
+        inline bool getParam(const std::string& key, XmlRpc::XmlRpcValue& value) const
+        {
+            XmlRpc::XmlRpcValue* found = find(key);
+            if(!found)
+                return false;
+
+            value = *found;
+            return true;
+        }
+
+        inline bool getParam(const std::string& key, bool& value) const
+        {
+            XmlRpc::XmlRpcValue* found = find(key);
+            if(!found || found->getType() != XmlRpc::XmlRpcValue::TypeBoolean)
+                return false;
+
+            value = static_cast<bool>(*found);
+            return true;
+        }
+
+        inline bool getParam(const std::string& key, int& value) const
+        {
+            XmlRpc::XmlRpcValue* found = find(key);
+            if(!found || found->getType() != XmlRpc::XmlRpcValue::TypeInt)
+                return false;
+
+            value = static_cast<int>(*found);
+            return true;
+        }
+
+        inline bool getParam(const std::string& key, double& value) const
+        {
+            XmlRpc::XmlRpcValue* found = find(key);
+            if(!found)
+                return false;
+
+            if(found->getType() == XmlRpc::XmlRpcValue::TypeDouble)
+                value = static_cast<double>(*found);
+            else if(found->getType() == XmlRpc::XmlRpcValue::TypeInt)
+                value = static_cast<int>(*found);
+            else
+                return false;
+
+            return true;
+        }
+
+        inline bool getParam(const std::string& key, std::string& value) const
+        {
+            XmlRpc::XmlRpcValue* found = find(key);
+            if(!found || found->getType() != XmlRpc::XmlRpcValue::TypeString)
+                return false;
+
+            value = static_cast<std::string>(*found);
+            return true;
+        }
+    };
+}
+
+#endif
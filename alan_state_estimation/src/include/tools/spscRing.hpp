@@ -0,0 +1,192 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file spscRing.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief bounded single-producer/single-consumer ring with drop-oldest, for hand-off between threads
+ */
+
+#ifndef SPSCRING_HPP
+#define SPSCRING_HPP
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+#include <utility>
+
+#include <semaphore.h>
+
+namespace vision
+{
+    /* sequence-numbered slots: a slot holding item k carries k + 1, a free slot
+    for item k carries k. the producer never waits on a slow consumer: when the
+    ring is full it claims the oldest item itself and overwrites it.
+    items are swapped in and out, so vector capacities and cv::Mat buffers
+    circulate between the two threads instead of being reallocated. */
+    template<typename T, int N>
+    class spscRing
+    {
+        // with one slot "holds item k" and "free for item k + 1" would read the same
+        static_assert(N >= 2 && (N & (N - 1)) == 0, "spscRing size has to be a power of 2, at least 2");
+
+    private:
+        typedef struct slot
+        {
+            std::atomic<uint64_t> seq;
+            T value;
+        }slot;
+
+        std::array<slot, N> slots;
+
+        alignas(64) std::atomic<uint64_t> head;    // next to read, advanced by the consumer, or by the producer to drop
+        alignas(64) uint64_t tail = 0;             // next to write, producer only
+
+        std::atomic<long> pushed;
+        std::atomic<long> dropped;
+
+        sem_t items;    // wakes the consumer, may run ahead of the fill after drops
+
+    public:
+        spscRing()
+        {
+            for(int i = 0; i < N; i++)
+                slots[i].seq.store(i, std::memory_order_relaxed);
+
+            head.store(0, std::memory_order_relaxed);
+            pushed.store(0, std::memory_order_relaxed);
+            dropped.store(0, std::memory_order_relaxed);
+
+            sem_init(&items, 0, 0);
+        };
+
+        ~spscRing()
+        {
+            sem_destroy(&items);
+        };
+
+        // item is swapped with a recycled one, returns false if the oldest item was dropped
+        bool push(T& item)
+        {
+            bool no_drop = true;
+
+            for(;;)
+            {
+                slot& s = slots[tail & (N - 1)];
+                const uint64_t seq = s.seq.load(std::memory_order_acquire);
+
+                if(seq == tail)
+                {
+                    std::swap(s.value, item);
+                    s.seq.store(tail + 1, std::memory_order_release);
+                    tail++;
+
+                    pushed.fetch_add(1, std::memory_order_relaxed);
+                    sem_post(&items);
+                    return no_drop;
+                }
+
+                // full, item tail - N is still unread: take it, unless the consumer just did
+                uint64_t oldest = tail - N;
+                if(
+                    seq == oldest + 1
+                    && head.compare_exchange_strong(oldest, oldest + 1, std::memory_order_acq_rel)
+                )
+                {
+                    s.seq.store(tail, std::memory_order_release);
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    no_drop = false;
+                    continue;
+                }
+
+                // the consumer is swapping that slot out right now
+                std::this_thread::yield();
+            }
+        }
+
+        bool pop(T& item)
+        {
+            uint64_t h = head.load(std::memory_order_acquire);
+
+            for(;;)
+            {
+                slot& s = slots[h & (N - 1)];
+                const uint64_t seq = s.seq.load(std::memory_order_acquire);
+                const int64_t diff = (int64_t)(seq - (h + 1));
+
+                if(diff < 0)
+                    return false;   // empty
+
+                if(diff > 0)
+                {
+                    // h was dropped by the producer meanwhile
+                    h = head.load(std::memory_order_acquire);
+                    continue;
+                }
+
+                if(head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel))
+                {
+                    std::swap(s.value, item);
+                    s.seq.store(h + N, std::memory_order_release);
+                    return true;
+                }
+            }
+        }
+
+        // pop, sleeping up to timeout_ms for an item
+        bool popWait(T& item, int timeout_ms)
+        {
+            for(;;)
+            {
+                if(pop(item))
+                {
+                    // keep the wake-up count close to the fill
+                    sem_trywait(&items);
+                    return true;
+                }
+
+                timespec until;
+                clock_gettime(CLOCK_REALTIME, &until);
+                until.tv_nsec += (long)timeout_ms * 1000000L;
+                until.tv_sec += until.tv_nsec / 1000000000L;
+                until.tv_nsec %= 1000000000L;
+
+                int ret;
+                while((ret = sem_timedwait(&items, &until)) != 0 && errno == EINTR);
+
+                if(ret != 0)
+                    return pop(item);
+            }
+        }
+
+        // wakes a consumer sleeping in popWait(), e.g. for shutdown
+        inline void wake()
+        {
+            sem_post(&items);
+        }
+
+        inline long getPushed(){return pushed.load(std::memory_order_relaxed);};
+        inline long getDropped(){return dropped.load(std::memory_order_relaxed);};
+    };
+}
+
+#endif
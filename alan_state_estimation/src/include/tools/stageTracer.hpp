@@ -0,0 +1,339 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file stageTracer.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief per-stage latency spans: lock-free multi-producer ring, rolling log-bucket histograms
+ */
+
+#ifndef STAGETRACER_HPP
+#define STAGETRACER_HPP
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+// set by CMake (option ALAN_TRACE), without it every TRACE_SPAN compiles to nothing
+#ifndef ALAN_TRACE_ON
+#define ALAN_TRACE_ON 0
+#endif
+
+namespace vision
+{
+    enum traceStage
+    {
+        TRACE_DECODE,
+        TRACE_SEGMENT,
+        TRACE_CORRES,
+        TRACE_DEPTH,
+        TRACE_KF_PREDICT,
+        TRACE_KF_OPTIMIZE,
+        TRACE_KF_UPDATE,
+        TRACE_PUBLISH,
+        TRACE_DEBUG_IMAGE,
+        TRACE_SYNC,         // first of the rgb/depth pair arrived -> pair handed to the callback
+        TRACE_STAGE_NO
+    };
+
+    inline const char* traceStageName(int stage)
+    {
+        static const char* names[TRACE_STAGE_NO] = {
+            "decode",
+            "segmentation",
+            "correspondence",
+            "depth",
+            "kf_predict",
+            "kf_optimize",
+            "kf_update",
+            "publish",
+            "debug_image",
+            "sync"
+        };
+        return stage >= 0 && stage < TRACE_STAGE_NO ? names[stage] : "unknown";
+    }
+
+    inline uint64_t traceNow()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+    /* 8 log-spaced buckets per power of 2 (at most 9 % wide), from 8 ns to ~4 s.
+    percentiles come back as the geometric middle of their bucket. */
+    class traceHistogram
+    {
+    private:
+        static const int SUB = 8;
+        static const int BUCKET_NO = 32 * SUB;
+
+        std::array<uint32_t, BUCKET_NO> count;
+        uint64_t total = 0;
+        uint64_t max_ns = 0;
+
+        static inline int bucket(uint64_t ns)
+        {
+            if(ns < SUB)
+                return (int)ns;
+
+            const int octave = 63 - __builtin_clzll(ns);    // >= 3
+            const int sub = (int)(ns >> (octave - 3)) & (SUB - 1);
+            const int b = (octave - 2) * SUB + sub;
+            return b < BUCKET_NO ? b : BUCKET_NO - 1;
+        }
+
+        static inline double lower(int b)
+        {
+            if(b < SUB)
+                return b;
+
+            const int octave = b / SUB + 2;
+            const int sub = b % SUB;
+            return (double)(SUB + sub) * (double)(1ull << (octave - 3));
+        }
+
+    public:
+        traceHistogram(){clear();};
+
+        inline void clear()
+        {
+            count.fill(0);
+            total = 0;
+            max_ns = 0;
+        }
+
+        inline void add(uint64_t ns)
+        {
+            count[bucket(ns)]++;
+            total++;
+            max_ns = ns > max_ns ? ns : max_ns;
+        }
+
+        inline void merge(const traceHistogram& other)
+        {
+            for(int b = 0; b < BUCKET_NO; b++)
+                count[b] += other.count[b];
+            total += other.total;
+            max_ns = other.max_ns > max_ns ? other.max_ns : max_ns;
+        }
+
+        // p in [0, 1], ns
+        double percentile(double p) const
+        {
+            if(total == 0)
+                return 0;
+
+            const uint64_t rank = (uint64_t)(p * (total - 1)) + 1;
+            uint64_t seen = 0;
+
+            for(int b = 0; b < BUCKET_NO; b++)
+            {
+                seen += count[b];
+                if(seen >= rank)
+                    return b < SUB ? b : std::sqrt(lower(b) * lower(b + 1));
+            }
+
+            return (double)max_ns;
+        }
+
+        inline uint64_t getTotal() const {return total;};
+        inline uint64_t getMax() const {return max_ns;};
+    };
+
+    typedef struct traceSummary
+    {
+        uint64_t count = 0;
+        double p50_us = 0, p95_us = 0, p99_us = 0, max_us = 0;
+    }traceSummary;
+
+    /* record() may be called from any thread, it claims a slot with one fetch_add
+    and publishes it seqlock style, so a slow reader never blocks a stage: when the
+    ring wraps the oldest spans are lost and counted.
+    drain(), roll(), summary() and dump() belong to one reader thread. */
+    class stageTracer
+    {
+    private:
+        static const int RING_SIZE = 4096;
+
+        typedef struct slot
+        {
+            std::atomic<uint64_t> seq;      // 2k + 2 once span k is complete, odd while written
+            std::atomic<uint64_t> packed;   // duration (ns) << 16 | stage
+        }slot;
+
+        std::array<slot, RING_SIZE> ring;
+        alignas(64) std::atomic<uint64_t> head;
+        alignas(64) uint64_t read_idx = 0;
+
+        std::atomic<bool> on;
+        long lost = 0;
+
+        // rolling window: percentiles are over the current and the previous window
+        std::array<traceHistogram, TRACE_STAGE_NO> hist_current, hist_previous;
+
+    public:
+        stageTracer()
+        {
+            for(auto& what : ring)
+                what.seq.store(0, std::memory_order_relaxed);
+            head.store(0, std::memory_order_relaxed);
+            on.store(ALAN_TRACE_ON, std::memory_order_relaxed);
+        };
+        ~stageTracer(){};
+
+        inline bool enabled() const {return on.load(std::memory_order_relaxed);};
+        inline void enable(bool on_) {on.store(on_ && ALAN_TRACE_ON, std::memory_order_relaxed);};
+
+        inline void record(int stage, uint64_t begin, uint64_t end)
+        {
+            const uint64_t k = head.fetch_add(1, std::memory_order_relaxed);
+            slot& s = ring[k & (RING_SIZE - 1)];
+
+            s.seq.store(2 * k + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            s.packed.store((end - begin) << 16 | (uint64_t)stage, std::memory_order_relaxed);
+
+            s.seq.store(2 * k + 2, std::memory_order_release);
+        }
+
+        // moves the completed spans into the histograms, returns how many
+        int drain()
+        {
+            const uint64_t end = head.load(std::memory_order_acquire);
+
+            if(end - read_idx > RING_SIZE)
+            {
+                lost += end - read_idx - RING_SIZE;
+                read_idx = end - RING_SIZE;
+            }
+
+            int drained = 0;
+
+            for(; read_idx < end; read_idx++)
+            {
+                slot& s = ring[read_idx & (RING_SIZE - 1)];
+
+                const uint64_t seq = s.seq.load(std::memory_order_acquire);
+                if(seq < 2 * read_idx + 2)
+                    break;  // still being written, next time
+
+                const uint64_t packed = s.packed.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if(seq != 2 * read_idx + 2 || s.seq.load(std::memory_order_relaxed) != seq)
+                {
+                    lost++;     // overwritten meanwhile
+                    continue;
+                }
+
+                const int stage = packed & 0xFFFF;
+                if(stage < TRACE_STAGE_NO)
+                    hist_current[stage].add(packed >> 16);
+                drained++;
+            }
+
+            return drained;
+        }
+
+        inline void roll()
+        {
+            hist_previous = hist_current;
+            for(auto& what : hist_current)
+                what.clear();
+        }
+
+        traceSummary summary(int stage) const
+        {
+            traceHistogram h = hist_previous[stage];
+            h.merge(hist_current[stage]);
+
+            traceSummary out;
+            out.count = h.getTotal();
+            out.p50_us = h.percentile(0.50) * 1e-3;
+            out.p95_us = h.percentile(0.95) * 1e-3;
+            out.p99_us = h.percentile(0.99) * 1e-3;
+            out.max_us = h.getMax() * 1e-3;
+            return out;
+        }
+
+        inline long getLost() const {return lost;};
+
+        // csv, one row per stage over the rolling window
+        bool dump(const std::string& path) const
+        {
+            std::ofstream file(path);
+            if(!file)
+                return false;
+
+            file<<"stage,count,p50_us,p95_us,p99_us,max_us\n";
+            for(int stage = 0; stage < TRACE_STAGE_NO; stage++)
+            {
+                const traceSummary s = summary(stage);
+                file<<traceStageName(stage)<<","<<s.count<<","
+                    <<s.p50_us<<","<<s.p95_us<<","<<s.p99_us<<","<<s.max_us<<"\n";
+            }
+            file<<"# lost spans,"<<lost<<"\n";
+
+            return true;
+        }
+    };
+
+    // one span from construction to end of scope, nothing if tracer is null or off
+    class traceScope
+    {
+    private:
+        stageTracer* tracer;
+        int stage;
+        uint64_t begin = 0;
+
+    public:
+        traceScope(stageTracer* tracer_, int stage_)
+        : tracer(tracer_ && tracer_->enabled() ? tracer_ : nullptr), stage(stage_)
+        {
+            if(tracer)
+                begin = traceNow();
+        };
+
+        ~traceScope()
+        {
+            if(tracer)
+                tracer->record(stage, begin, traceNow());
+        };
+
+        traceScope(const traceScope&) = delete;
+        traceScope& operator=(const traceScope&) = delete;
+    };
+}
+
+#define TRACE_CAT_(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT_(a, b)
+
+#if ALAN_TRACE_ON
+#define TRACE_SPAN(tracer_ptr, stage) vision::traceScope TRACE_CAT(trace_scope_, __LINE__)(tracer_ptr, stage)
+#else
+#define TRACE_SPAN(tracer_ptr, stage) ((void)0)
+#endif
+
+#endif
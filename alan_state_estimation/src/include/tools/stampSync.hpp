@@ -0,0 +1,203 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file stampSync.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief colour / depth pairing on the header stamp, one pending message per stream, newest pair wins
+ */
+
+#ifndef STAMPSYNC_HPP
+#define STAMPSYNC_HPP
+
+#include <ros/ros.h>
+
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "stageTracer.hpp"
+
+namespace vision
+{
+    typedef struct syncStats
+    {
+        long paired = 0;
+        long dropped_a = 0, dropped_b = 0;  // replaced while pending, or older than the other stream
+        long dropped_busy = 0;              // pairs replaced while the callback was still running
+        double latency_avg_ms = 0, latency_max_ms = 0;  // first arrival -> pair handed over, since the last read
+    }syncStats;
+
+    /* replaces message_filters::ApproximateTime for two camera streams of one
+    device: stamps within tolerance are a pair, and as both streams come in
+    stamp order, a pending message older than the other stream's can never
+    pair and is dropped at once. there is no queue to search, at most one
+    message per stream and one finished pair are held. the callback runs on
+    the subscriber thread that completed the pair, never twice at a time;
+    a pair completed meanwhile waits for it, replacing any older one. */
+    template<class A, class B>
+    class stampSync
+    {
+    public:
+        typedef typename A::ConstPtr APtr;
+        typedef typename B::ConstPtr BPtr;
+        typedef std::function<void(const APtr&, const BPtr&)> pairCallback;
+
+    private:
+        ros::Subscriber sub_a, sub_b;
+        pairCallback callback;
+
+        std::mutex mutex;
+        APtr pending_a, ready_a;
+        BPtr pending_b, ready_b;
+        uint64_t arrival_a = 0, arrival_b = 0, arrival_ready = 0;
+        bool delivering = false;
+
+        syncStats stats;
+        double latency_sum_ms = 0;
+        long latency_no = 0;
+
+        inline void addA(const APtr& msg)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if(pending_a)
+                stats.dropped_a++;
+            pending_a = msg;
+            arrival_a = traceNow();
+            match(lock);
+        }
+
+        inline void addB(const BPtr& msg)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if(pending_b)
+                stats.dropped_b++;
+            pending_b = msg;
+            arrival_b = traceNow();
+            match(lock);
+        }
+
+        inline void match(std::unique_lock<std::mutex>& lock)
+        {
+            if(!pending_a || !pending_b)
+                return;
+
+            const double dt = pending_a->header.stamp.toSec() - pending_b->header.stamp.toSec();
+
+            if(std::fabs(dt) > tolerance)
+            {
+                // the older one's partner has been and gone
+                if(dt < 0)
+                {
+                    pending_a.reset();
+                    stats.dropped_a++;
+                }
+                else
+                {
+                    pending_b.reset();
+                    stats.dropped_b++;
+                }
+                return;
+            }
+
+            if(ready_a)
+                stats.dropped_busy++;
+
+            ready_a.swap(pending_a);
+            ready_b.swap(pending_b);
+            pending_a.reset();
+            pending_b.reset();
+            arrival_ready = std::min(arrival_a, arrival_b);
+            stats.paired++;
+
+            if(delivering)
+                return;
+
+            // this thread hands over every pair that completes until the callback is idle
+            delivering = true;
+
+            while(ready_a)
+            {
+                APtr a;
+                BPtr b;
+                a.swap(ready_a);
+                b.swap(ready_b);
+
+                const uint64_t begin = arrival_ready;
+                const uint64_t end = traceNow();
+                const double latency_ms = (end - begin) * 1e-6;
+                latency_sum_ms += latency_ms;
+                latency_no++;
+                stats.latency_max_ms = std::max(stats.latency_max_ms, latency_ms);
+
+                lock.unlock();
+
+                if(tracer && tracer->enabled())
+                    tracer->record(TRACE_SYNC, begin, end);
+
+                callback(a, b);
+
+                lock.lock();
+            }
+
+            delivering = false;
+        }
+
+    public:
+        stampSync(){};
+        ~stampSync(){};
+
+        stampSync(const stampSync&) = delete;
+        stampSync& operator=(const stampSync&) = delete;
+
+        double tolerance = 0.015;           // s between the two stamps of a pair
+        stageTracer* tracer = nullptr;      // pairing latency as TRACE_SYNC, none if null
+
+        inline void subscribe(
+            ros::NodeHandle& nh,
+            const std::string& topic_a,
+            const std::string& topic_b,
+            const pairCallback& callback_
+        )
+        {
+            callback = callback_;
+
+            sub_a = nh.subscribe<A>(topic_a, 1, &stampSync::addA, this, ros::TransportHints().tcpNoDelay());
+            sub_b = nh.subscribe<B>(topic_b, 1, &stampSync::addB, this, ros::TransportHints().tcpNoDelay());
+        }
+
+        // counters since start, latency since the last call
+        inline syncStats getStats()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            syncStats result = stats;
+            result.latency_avg_ms = latency_no > 0 ? latency_sum_ms / latency_no : 0;
+
+            latency_sum_ms = 0;
+            latency_no = 0;
+            stats.latency_max_ms = 0;
+
+            return result;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,149 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file workerPool.hpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief fixed set of threads for fork-join loops, the calling thread takes part
+ */
+
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vision
+{
+    /* run(n, job) calls job(0) .. job(n - 1) on the workers and the caller and
+    returns once all have finished. the threads live as long as the pool,
+    so a loop per frame costs two wake-ups, not n thread starts.
+    one run() at a time. */
+    class workerPool
+    {
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable cv_job, cv_done;
+
+        const std::function<void(int)>* job = nullptr;
+        int job_no = 0;
+        std::atomic<int> next{0};
+        int busy = 0;
+        long generation = 0;
+        bool running = false;
+
+        inline void take()
+        {
+            for(int i = next.fetch_add(1); i < job_no; i = next.fetch_add(1))
+                (*job)(i);
+        }
+
+        inline void loop()
+        {
+            long seen = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+
+            while(true)
+            {
+                cv_job.wait(lock, [&]{return !running || generation != seen;});
+                if(!running)
+                    return;
+
+                seen = generation;
+
+                lock.unlock();
+                take();
+                lock.lock();
+
+                if(--busy == 0)
+                    cv_done.notify_one();
+            }
+        }
+
+    public:
+        workerPool(){};
+        ~workerPool(){stop();};
+
+        workerPool(const workerPool&) = delete;
+        workerPool& operator=(const workerPool&) = delete;
+
+        // threads besides the caller, 0 runs every job on the caller
+        inline void start(int thread_no)
+        {
+            stop();
+
+            running = true;
+            for(int i = 0; i < thread_no; i++)
+                workers.emplace_back(&workerPool::loop, this);
+        }
+
+        inline void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running = false;
+            }
+            cv_job.notify_all();
+
+            for(auto& what : workers)
+                if(what.joinable())
+                    what.join();
+
+            workers.clear();
+        }
+
+        inline int size() const {return workers.size();};
+
+        inline void run(int n, const std::function<void(int)>& job_)
+        {
+            if(n <= 0)
+                return;
+
+            if(workers.empty() || n == 1)
+            {
+                for(int i = 0; i < n; i++)
+                    job_(i);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                job = &job_;
+                job_no = n;
+                next = 0;
+                busy = workers.size();
+                generation++;
+            }
+            cv_job.notify_all();
+
+            take();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            cv_done.wait(lock, [&]{return busy == 0;});
+            job = nullptr;
+        }
+    };
+}
+
+#endif
@@ -36,9 +36,6 @@
 #include <image_transport/image_transport.h>
 #include <cv_bridge/cv_bridge.h>
 #include <sensor_msgs/image_encodings.h>
-#include <message_filters/subscriber.h>
-#include <message_filters/synchronizer.h>
-#include <message_filters/sync_policies/approximate_time.h>
 #include <sensor_msgs/Image.h>
 
 #include <opencv2/dnn.hpp>
@@ -49,6 +46,7 @@
 #include <pthread.h>
 
 #include "tools/RosTopicConfigs.h"
+#include "tools/stampSync.hpp"
 // map definition for convinience
 #define COLOR_SUB_TOPIC CAMERA_SUB_TOPIC_A
 #define DEPTH_SUB_TOPIC CAMERA_SUB_TOPIC_B
@@ -71,11 +69,7 @@ namespace alan{
             cv::Mat frame;
             bool intiated = false;
 
-            message_filters::Subscriber<sensor_msgs::CompressedImage> subimage;
-            message_filters::Subscriber<sensor_msgs::Image> subdepth;
-            typedef message_filters::sync_policies::ApproximateTime<sensor_msgs::CompressedImage, sensor_msgs::Image> MySyncPolicy;
-            typedef message_filters::Synchronizer<MySyncPolicy> sync;//(MySyncPolicy(10), subimage, subdepth);
-            boost::shared_ptr<sync> sync_;
+            vision::stampSync<sensor_msgs::CompressedImage, sensor_msgs::Image> cam_sync;
 
             // cv::String cfg_file;
             // cv::String weights_file;
@@ -127,10 +121,13 @@ namespace alan{
                 std::cout<<classnamepath<<std::endl;
 
                 //subscribe
-                subimage.subscribe(nh, "/camera/color/image_raw/compressed", 1);
-                subdepth.subscribe(nh, "/camera/aligned_depth_to_color/image_raw", 1);                
-                sync_.reset(new sync( MySyncPolicy(10), subimage, subdepth));            
-                sync_->registerCallback(boost::bind(&CnnNodelet::camera_callback, this, _1, _2));
+                nh.getParam("/alan_master/SYNC_tolerance", cam_sync.tolerance);
+                cam_sync.subscribe(
+                    nh, 
+                    "/camera/color/image_raw/compressed", 
+                    "/camera/aligned_depth_to_color/image_raw",
+                    boost::bind(&CnnNodelet::camera_callback, this, _1, _2)
+                );
 
                 ROS_INFO("CNN Nodelet Initiated...");
             }
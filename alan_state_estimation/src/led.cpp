@@ -30,71 +30,247 @@ void alan::LedNodelet::camera_callback(
     const sensor_msgs::Image::ConstPtr& depthmsg
 )
 {
-    cv_bridge::CvImageConstPtr depth_ptr;
-    led_pose_header = rgbmsg->header;
-
-    try
+    ledInput input;
+    input.rgbmsg = rgbmsg;
+    input.depthmsg = depthmsg;
+    input.tick = ros::Time::now().toSec();
+
+    // nothing is drawn or copied for debug images nobody watches, nor above DEBUG_IMAGE_hz
+    bool debug_due = debug_hz <= 0 || input.tick - debug_last >= 1.0 / debug_hz;
+    input.display_on = debug_due && pubimage.getNumSubscribers() > 0;
+    input.input_on = debug_due && pubimage_input.getNumSubscribers() > 0;
+    if(input.display_on || input.input_on)
+        debug_last = input.tick;
+
+    if(pipeline_on)
     {
-        depth_ptr  = cv_bridge::toCvCopy(depthmsg, depthmsg->encoding);
+        // the decode thread takes it from here, a busy one loses its oldest frame
+        ring_input.push(input);
+        return;
     }
-    catch (cv_bridge::Exception& e)
+
+    if(multi_on)
     {
-        ROS_ERROR("cv_bridge exception: %s", e.what());
+        if(!multi_tracker.front_end(input))
+            return;
+
+        multi_tracker.estimate();
+        output_multi();
         return;
     }
 
-    cv::Mat depth = depth_ptr->image;
+    if(!tracker.front_end(input, frame_serial))
+        return;
+
+    tracker.estimate(frame_serial, report_serial);
+    output(report_serial);
+} 
+
+/* ================ pipeline shell below ================ */
+    /* ledTracker::front_end() and ledTracker::estimate() run one after another
+    in the callback, or on their own threads with a ring in between, 
+    output() publishes whatever the estimator reports. */
+
+void alan::LedNodelet::output(ledReport& report)
+{
+    double tock = ros::Time::now().toSec();  
+
+    if(report.publish_pose)
+        map_SE3_to_publish(
+            report.pose, 
+            report.velo,
+            report.cov,
+            report.header
+        );
+
+    if(report.tracker_started)
+        total_no++;
+
+    terminal_msg_display(1 / (tock - report.tick), report);
+
+    debug_push(report, 1 / (tock - report.tick));
+
+    if(report.tracked)
+        log(tock - report.tick);
+}
+
+void alan::LedNodelet::output_multi()
+{
+    double tock = ros::Time::now().toSec();
 
-    try
+    for(int k = 0; k < (int)multi_tracker.size(); k++)
     {
-        frame = cv::imdecode(cv::Mat(rgbmsg->data), 1);
-        display = frame.clone();
-        hsv = frame.clone();
-        frame_temp = frame.clone();
+        ledReport& report = multi_tracker.getReport(k);
+
+        if(report.publish_pose)
+            map_SE3_to_publish(
+                report.pose, 
+                report.velo,
+                report.cov,
+                report.header,
+                k
+            );
+
+        if(report.tracker_started)
+            total_no++;
+
+        terminal_msg_display(1 / (tock - report.tick), report, multi_tracker.getName(k));
     }
-    catch (cv_bridge::Exception& e)
+
+    // every target draws on the same display, the log keeps to the first one
+    ledReport& first = multi_tracker.getReport(0);
+
+    debug_push(first, 1 / (tock - first.tick));
+
+    if(first.tracked)
+        log(tock - first.tick);
+}
+
+void alan::LedNodelet::debug_push(ledReport& report, double hz)
+{
+    if(!report.display_on && !report.input_on)
+        return;
+
+    // drawing, conversion and compression happen on the debug thread
+    debug_out.header = report.header;
+    debug_out.display = report.display_on ? report.display : cv::Mat();
+    debug_out.frame_input = report.input_on ? report.frame_input : cv::Mat();
+    debug_out.hz = hz;
+    debug_out.BA_error = report.BA_error;
+    debug_out.depth_avg = report.depth_avg;
+    debug_out.detect_no = report.detect_no;
+
+    ring_debug.push(debug_out);
+
+    debug_out.display.release();
+    debug_out.frame_input.release();
+}
+
+void alan::LedNodelet::front_loop()
+{
+    ledInput input;
+    ledFrame item;
+    item.pts_2d_detect.reserve(64);
+    item.blobs.reserve(64);
+
+    while(pipeline_running)
     {
-        ROS_ERROR("cv_bridge exception: %s", e.what());
+        if(!ring_input.popWait(input, 100))
+            continue;
+
+        bool ok = tracker.front_end(input, item);
+
+        // the rgb/depth messages are not needed past decoding
+        input = ledInput();
+
+        if(ok)
+            ring_frame.push(item);
     }
+}
 
-    double tick = ros::Time::now().toSec(); 
+void alan::LedNodelet::estimate_loop()
+{
+    ledFrame item;
+    ledReport report;
 
-    if(tick - last_request > ros::Duration(0.1).toSec() && nodelet_activated)
+    while(pipeline_running)
     {
-        LED_tracker_initiated_or_tracked = false;
-        printf("\033c");
-        ROS_RED_STREAM("RESET TERMINAL!");
-    }           
+        if(!ring_frame.popWait(item, 100))
+            continue;
 
-    std::cout<<frame.cols<<std::endl;
-    std::cout<<frame.rows<<std::endl;
+        tracker.estimate(item, report);
 
-    std::cout<<depth.cols<<std::endl;
-    std::cout<<depth.rows<<std::endl;
+        item.frame.release();
+        item.depth.release();
+        item.display.release();
+        item.frame_input.release();
+        item.depth_ptr.reset();
+        item.depthmsg.reset();
 
-           
-    solve_pose_w_LED(frame, depth);
-    
-    double tock = ros::Time::now().toSec();  
+        ring_report.push(report);
+    }
+}
 
-    if(tracker_started)
-        total_no++;
+void alan::LedNodelet::output_loop()
+{
+    ledReport report;
+
+    while(pipeline_running)
+    {
+        if(!ring_report.popWait(report, 100))
+            continue;
 
-    terminal_msg_display(1 / (tock - tick));
+        output(report);
 
-    set_image_to_publish(1 / (tock - tick), rgbmsg);
+        report.display.release();
+        report.frame_input.release();
+    }
+}
 
-    if(LED_tracker_initiated_or_tracked)
-        log(tock - tick);
-                    
-    last_request = ros::Time::now().toSec();
+void alan::LedNodelet::pipeline_start()
+{
+    pipeline_running = true;
 
-    if(!nodelet_activated)
-        nodelet_activated = true;
+    front_thread = std::thread(&LedNodelet::front_loop, this);
+    estimate_thread = std::thread(&LedNodelet::estimate_loop, this);
+    output_thread = std::thread(&LedNodelet::output_loop, this);
 
-    led_pose_header_previous = led_pose_header;
+    ROS_GREEN_STREAM("LED PIPELINE ON!");
+}
 
-} 
+void alan::LedNodelet::pipeline_stop()
+{
+    if(!pipeline_running)
+        return;
+
+    pipeline_running = false;
+
+    ring_input.wake();
+    ring_frame.wake();
+    ring_report.wake();
+
+    if(front_thread.joinable())
+        front_thread.join();
+    if(estimate_thread.joinable())
+        estimate_thread.join();
+    if(output_thread.joinable())
+        output_thread.join();
+}
+
+void alan::LedNodelet::debug_loop()
+{
+    ledDebug item;
+
+    while(debug_running)
+    {
+        if(!ring_debug.popWait(item, 100))
+            continue;
+
+        set_image_to_publish(item);
+
+        // hand the buffers back to the pool
+        item.display.release();
+        item.frame_input.release();
+    }
+}
+
+void alan::LedNodelet::debug_start()
+{
+    debug_running = true;
+    debug_thread = std::thread(&LedNodelet::debug_loop, this);
+}
+
+void alan::LedNodelet::debug_stop()
+{
+    if(!debug_running)
+        return;
+
+    debug_running = false;
+    ring_debug.wake();
+
+    if(debug_thread.joinable())
+        debug_thread.join();
+}
 
 Sophus::SE3d alan::LedNodelet::posemsg_to_SE3(const geometry_msgs::PoseStamped pose)
 {
@@ -199,1133 +375,219 @@ void alan::LedNodelet::uav_setpt_callback(const geometry_msgs::PoseStamped::Cons
 void alan::LedNodelet::map_SE3_to_publish(
     Sophus::SE3d pose_led_inCamera_SE3,
     Sophus::SE3d velo_led_inCamera_SE3,
-    Eigen::MatrixXd cov_inCamera_SE3
+    Eigen::MatrixXd cov_inCamera_SE3,
+    std_msgs::Header header,
+    int target
 )
 {
-    pose_led_inWorld_SE3 = 
+    TRACE_SPAN(getTracer(), vision::TRACE_PUBLISH);
+
+    Sophus::SE3d pose_inWorld = 
         pose_cam_inWorld_SE3 
         * pose_cam_inGeneralBodySE3 
         * pose_led_inCamera_SE3;
     
     Sophus::SE3d temp = pose_cam_inWorld_SE3;
     temp.translation().setZero();
-    velo_led_inWorld_SE3 = 
+    Sophus::SE3d velo_inWorld = 
         temp
         * pose_cam_inGeneralBodySE3
         * velo_led_inCamera_SE3;
-        
-    std::cout<<(pose_led_inWorld_SE3.translation() - pose_uav_inWorld_SE3.translation()).norm()<<std::endl;
     
-    led_pose_header.frame_id = "world";
-    led_pose_estimated_msg = SE3_to_posemsg(
-        pose_led_inWorld_SE3, 
-        led_pose_header
+    header.frame_id = "world";
+    geometry_msgs::PoseStamped pose_msg = SE3_to_posemsg(
+        pose_inWorld, 
+        header
     );
 
-    ledpose_pub.publish(led_pose_estimated_msg);
-
     //odom publish
-    led_odom_estimated_msg = SE3_to_odommsg(
-        pose_led_inWorld_SE3,
-        velo_led_inWorld_SE3,
-        led_pose_header
+    nav_msgs::Odometry odom_msg = SE3_to_odommsg(
+        pose_inWorld,
+        velo_inWorld,
+        header
     );
-    
-    ledodom_pub.publish(led_odom_estimated_msg);
-}
 
-void alan::LedNodelet::solve_pose_w_LED(cv::Mat& frame, cv::Mat depth)
-{    
-    if(!LED_tracker_initiated_or_tracked)        
+    if(target >= 0)
     {
-        LED_tracker_initiated_or_tracked = initialization(frame, depth);
-        // try to initialize here...
-
-        if(LED_tracker_initiated_or_tracked)
-        {
-            printf("\n");
-            ROS_GREEN_STREAM("TRACKER INITIALIZED!");
-            ROS_GREEN_STREAM("SHOULD BE FINE...HOPEFULLY?\n");
-            tracker_started = true;
-
-            if(BA_error > LED_no * 2)
-            {
-                ROS_WARN("REPROJECTION_ERROR OVER @ INITIALIZATION %d", LED_no * 2);          
-            }                    
-
-            if(!kf_initiated)
-            {
-                kf_initiated = true;
-                apiKF(kfINITIATE);                
-            }
-            else
-                apiKF(kfREINITIATE);            
-            
-            map_SE3_to_publish(
-                pose_global_sophus, 
-                velo_global_sophus,
-                covariance_global_sophus
-            );
-        }
-        else
-        {
-            ROS_CYAN_STREAM("WAITING FOR INITIALIZATION...");
-        }
+        target_pose_pub[target].publish(pose_msg);
+        target_odom_pub[target].publish(odom_msg);
     }
-    else
-    {
-        recursive_filtering(frame, depth);
 
-        if(!LED_tracker_initiated_or_tracked)
-            ROS_RED_STREAM("TRACKER FAIL");
-        else       
-            map_SE3_to_publish(
-                pose_global_sophus, 
-                velo_global_sophus,
-                covariance_global_sophus
-            );
-    }
-
-}
-
-void alan::LedNodelet::apiKF(int DOKF)
-{
-    switch (DOKF)
-    {
-    case kfINITIATE:
-        initKF(pose_global_sophus);
-
-        pose_global_sophus = XcurrentPosterori.X_SE3;
-        velo_global_sophus = XcurrentPosterori.V_SE3;
-        covariance_global_sophus = XcurrentPosterori.PCov;
-        break;
-    
-    case kfREINITIATE:
-        reinitKF(pose_global_sophus);
-
-        pose_global_sophus = XcurrentPosterori.X_SE3;
-        velo_global_sophus = XcurrentPosterori.V_SE3;
-        covariance_global_sophus = XcurrentPosterori.PCov;
-        break;
-
-    case kfNORMALKF:
-        run_AIEKF(
-            led_pose_header.stamp.toSec() - led_pose_header_previous.stamp.toSec(),
-            pts_on_body_frame_in_corres_order, 
-            pts_detected_in_corres_order
-        );
-
-        pose_global_sophus = XcurrentPosterori.X_SE3;
-        velo_global_sophus = XcurrentPosterori.V_SE3;
-        covariance_global_sophus = XcurrentPosterori.PCov;
-
-        break;
-    
-    default:
-        // pc::pattyDebug();
-        break;
-    }
-}
-
-void alan::LedNodelet::recursive_filtering(cv::Mat& frame, cv::Mat depth)
-{
-    std::vector<Eigen::Vector2d> pts_2d_detect;
-
-    pts_2d_detect = LED_extract_POI_alter(frame, depth);
-
-    detect_no = pts_2d_detect.size();
-
-    if(detect_no < 3)
-    {
-        // std::cout<<i<<std::endl;
-        LED_tracker_initiated_or_tracked = false;
-        cv::imwrite("/home/patty/alan_ws/meas_less3" + std::to_string(detect_no) + "_"+  std::to_string(i) + ".jpg", frame_input);
-        // i++;
-        return;
-    }
-
-    get_correspondence(pts_2d_detect);
-    pointcloud_generate(pts_2d_detect, depth);
-    detect_no = pts_detected_in_corres_order.size();
-
-    if(detect_no < 3)
-    {
-        // std::cout<<i<<std::endl;
-        LED_tracker_initiated_or_tracked = false;
-        // cv::imwrite("/home/patty/alan_ws/kmeans_less3_" + std::to_string(detect_no) + "_"+ std::to_string(i) + ".jpg", frame_input);
-        // i++;
+    // the first target stands in for the single one, log() and the planner read these
+    if(target > 0)
         return;
-    }
-
-    apiKF(kfNORMALKF);
 
-    BA_error = get_reprojection_error(
-        pts_on_body_frame_in_corres_order,
-        pts_detected_in_corres_order,
-        pose_global_sophus,
-        true
-    );
+    pose_led_inWorld_SE3 = pose_inWorld;
+    velo_led_inWorld_SE3 = velo_inWorld;
+    led_pose_estimated_msg = pose_msg;
+    led_odom_estimated_msg = odom_msg;
 
-    if(BA_error > 4 * LED_no)
-    {
-        LED_tracker_initiated_or_tracked = false;
-        // cv::imwrite("/home/patty/alan_ws/BA" + std::to_string(BA_error) + ".jpg", frame_input);
-    }
+    ledpose_pub.publish(led_pose_estimated_msg);
+    ledodom_pub.publish(led_odom_estimated_msg);
 }
 
-void alan::LedNodelet::get_correspondence(
-    std::vector<Eigen::Vector2d>& pts_2d_detected
-)
-{
-    std::vector<Eigen::Vector2d> pts;
-    std::vector<Eigen::Vector2d> pts_detected_previous_in_order;
+/* ================ UI utilities function below ================ */
 
-    if(BA_error < 5.0)
-    {
-        Eigen::Vector2d reproject_temp;
-        for(auto what : pts_on_body_frame)
-        {
-            reproject_temp = reproject_3D_2D(
-                    what, 
-                    pose_global_sophus
-                );
-            pts.emplace_back(reproject_temp);
-            
-        }
-
-        if(
-            pts_2d_detected.size() == LED_no 
-            && 
-            std::get<0>(corres_global_previous) == LED_no
-        )
-        {
-            pts_detected_previous_in_order =  shift2D(
-                pts,
-                pts_2d_detected
-            );
-        }
-        else
-            pts_detected_previous_in_order = pts;
-    }
-    else
-    {
-        ROS_WARN("use previous detection 2D");
-
-        for(auto what : std::get<1>(corres_global_previous))
-            pts.emplace_back(what.pts_2d_correspond);
-
-        if(
-            pts_2d_detected.size() == LED_no 
-            && 
-            std::get<0>(corres_global_previous) == LED_no
-        )
-        {
-            pts_detected_previous_in_order =  shift2D(
-                pts,
-                pts_2d_detected
-            );
-        }
-        else
-            pts_detected_previous_in_order = pts;
+void alan::LedNodelet::set_image_to_publish(ledDebug& item)
+{    
+    TRACE_SPAN(getTracer(), vision::TRACE_DEBUG_IMAGE);
 
-        // cv::imwrite("/home/patty/alan_ws/lala" + std::to_string(i) + ".jpg", frame_input);
-        // pc::pattyDebug("check check");
-        
-    }
+    char hz[40];
+    char fps[10] = " fps";
+    sprintf(hz, "%.2f", item.hz);
+    strcat(hz, fps);
 
-    correspondence_search_2D2DCompare(
-        pts_2d_detected,
-        pts_detected_previous_in_order
-    );
+    char BA[40] = "BA: ";
+    char BA_error_display[10];
+    sprintf(BA_error_display, "%.2f", item.BA_error);
+    strcat(BA, BA_error_display);
 
-    corres_global_previous = corres_global_current;
+    char depth[40] = "DPTH: ";
+    char depth_display[10];
+    sprintf(depth_display, "%.2f", item.depth_avg);
+    strcat(depth, depth_display);
     
-    pts_on_body_frame_in_corres_order.clear();
-    pts_detected_in_corres_order.clear(); 
-
-    for(int i = 0; i < std::get<1>(corres_global_current).size(); i++)
-    {            
-        if(std::get<1>(corres_global_current)[i].detected_ornot)
-        {  
-            pts_detected_in_corres_order.push_back(
-                std::get<1>(corres_global_current)[i].pts_2d_correspond
-            );             
-            pts_on_body_frame_in_corres_order.push_back(pts_on_body_frame[i]);
-            std::get<1>(corres_global_current)[i].detected_ornot = false; 
-            // reset for next time step
-        }        
-    }
-
-    i++;        
-}
-
-std::vector<Eigen::Vector2d> alan::LedNodelet::shift2D(
-    std::vector<Eigen::Vector2d>& pts_2D_previous,
-    std::vector<Eigen::Vector2d>& pts_detect_current
-)
-{
-    std::vector<Eigen::Vector2d> shifted_pts;
-    int total_no = 0;
-
-    // get average previous
-    Eigen::Vector2d cg_previous;
-    cg_previous.setZero();
-    total_no = 0;
-    for(auto& what : pts_2D_previous)
+    if(!item.display.empty())
     {
-        
-        cg_previous += what;
-        total_no++;
-        
+        cv::putText(item.display, hz, cv::Point(20,40), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));  
+        cv::putText(item.display, std::to_string(item.detect_no), cv::Point(720,460), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));
+        cv::putText(item.display, BA, cv::Point(720,60), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));
+        cv::putText(item.display, depth, cv::Point(20,460), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));
+
+        // toImageMsg() copies, no need to clone here
+        cv_bridge::CvImage for_visual;
+        for_visual.header = item.header;
+        for_visual.encoding = sensor_msgs::image_encodings::BGR8;
+        for_visual.image = item.display;
+        this->pubimage.publish(for_visual.toImageMsg());
     }
-    cg_previous /= total_no;
 
-    // get average current
-    Eigen::Vector2d cg_current;
-    cg_current.setZero();
-    total_no = 0;
-    for(auto& what : pts_detect_current)
+    if(!item.frame_input.empty())
     {
-        cv::circle(
-            frame_input, 
-            cv::Point(what(0), what(1)), 
-            2.5, 
-            CV_RGB(0,255,0),
-            -1
-        );
-        cg_current += what;
-        total_no++;
+        cv_bridge::CvImage for_visual_input;
+        for_visual_input.header = item.header;
+        for_visual_input.encoding = sensor_msgs::image_encodings::BGR8;
+        for_visual_input.image = item.frame_input;
+        this->pubimage_input.publish(for_visual_input.toImageMsg());   
     }
-    cg_current /= total_no;
 
-    Eigen::Vector2d delta2D = cg_current - cg_previous;
-    Eigen::Vector2d reproject_temp;
-
-    // shift pts
-    for(auto& what : pts_2D_previous)
-    {
-        reproject_temp = what + delta2D;
-        shifted_pts.emplace_back(reproject_temp);
-        cv::circle(
-            frame_input, 
-            cv::Point(reproject_temp(0), reproject_temp(1)), 
-            1.0, 
-            CV_RGB(0,0,255),
-            -1
-        );
-    }
-        
-    return shifted_pts;
 }
 
-void alan::LedNodelet::solve_pnp_initial_pose(std::vector<Eigen::Vector2d> pts_2d, std::vector<Eigen::Vector3d> pts_3d)
+void alan::LedNodelet::log(double ms)
 {
-    Eigen::Matrix3d R;
-    Eigen::Vector3d t;
-
-    cv::Mat distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
-    // distCoeffs.at<double>(0) = -0.056986890733242035;
-    // distCoeffs.at<double>(1) = 0.06356718391180038;
-    // distCoeffs.at<double>(2) = -0.0012483829632401466;
-    // distCoeffs.at<double>(3) = -0.00018130485841538757;
-    // distCoeffs.at<double>(4) = -0.019809694960713387;
-
-    cv::Mat no_ro_rmat = cv::Mat::eye(3,3,CV_64F);
-    
-    cv::Vec3d rvec, tvec;
-    // cv::Rodrigues(no_ro_rmat, rvec);
-
-    cv::Mat camMat = cv::Mat::eye(3,3,CV_64F);
-    std::vector<cv::Point3f> pts_3d_;
-    std::vector<cv::Point2f> pts_2d_;
-
-    cv::Point3f temp3d;
-    cv::Point2f temp2d;
-
-    for(auto what : pts_3d)
-    {
-        temp3d.x = what(0);
-        temp3d.y = what(1);
-        temp3d.z = what(2);
-
-        pts_3d_.push_back(temp3d);
-    }
-
-    for(auto what : pts_2d)
-    {
-        temp2d.x = what(0);
-        temp2d.y = what(1);    
-
-        pts_2d_.push_back(temp2d);
-    }
-
-    camMat.at<double>(0,0) = cameraMat(0,0);
-    camMat.at<double>(0,2) = cameraMat(0,2);
-    camMat.at<double>(1,1) = cameraMat(1,1);
-    camMat.at<double>(1,2) = cameraMat(1,2);
-
-    // either one
-    // cv::solvePnP(pts_3d_, pts_2d_ ,camMat, distCoeffs, rvec, tvec, cv::SOLVEPNP_EPNP);
-    cv::solvePnP(pts_3d_, pts_2d_ ,camMat, distCoeffs, rvec, tvec, cv::SOLVEPNP_ITERATIVE);
-    
-    //opt pnp algorithm
-    //, cv::SOLVEPNP_EPNP
-    //, cv::SOLVEPNP_IPPE
-    //, cv::SOLVEPNP_P3P
-
-    //return values
-    cv::Mat rmat = cv::Mat::eye(3,3,CV_64F);
-    cv::Rodrigues(rvec, rmat);
-
-    R <<
-        rmat.at<double>(0,0), rmat.at<double>(0,1), rmat.at<double>(0,2),
-        rmat.at<double>(1,0), rmat.at<double>(1,1), rmat.at<double>(1,2),
-        rmat.at<double>(2,0), rmat.at<double>(2,1), rmat.at<double>(2,2);
-
-    Eigen::Matrix3d reverse_mat;
-    reverse_mat <<
-            1.0000000,  0.0000000,  0.0000000,
-            0.0000000, -1.0000000, -0.0000000,
-            0.0000000,  0.0000000, -1.0000000;
-
-    
-
-    t =  Eigen::Vector3d(
-          tvec(0),
-          tvec(1),
-          tvec(2)  
-        );
-
-    if(tvec(2) < 0) //sometimes opencv yeilds reversed results, flip it 
-    {
-        R = R * reverse_mat;
-        t = (-1) * t;
-    }
-
-    pose_epnp_sophus = Sophus::SE3d(R, t);
-    
-    // pose_depth_sophus = Sophus::SE3d(R, t);
-
-    // if(LED_tracker_initiated_or_tracked)
-    // {
-    //     // cout<<"depth"<<endl;
-    //     t = led_3d_posi_in_camera_frame_depth;
-    //     pose_depth_sophus = Sophus::SE3d(R, t);
-    // }
-
-}
-
-/* ================ POI Extraction utilities function below ================ */
-std::vector<Eigen::Vector2d> alan::LedNodelet::LED_extract_POI(cv::Mat& frame, cv::Mat depth)
-{   
-    cv::Mat depth_mask_src = depth.clone(), depth_mask_dst1, depth_mask_dst2;
-
-    cv::threshold(depth_mask_src, depth_mask_dst1, LANDING_DISTANCE * 1000, 50000, cv::THRESH_BINARY_INV);
-    //filter out far depths
-
-    cv::threshold(depth_mask_src, depth_mask_dst2, 0.5, 50000, cv::THRESH_BINARY); 
-    //filter out zeros
+    const bool publish_led = record_led_pub.getNumSubscribers() > 0;
+    const bool publish_uav = record_uav_pub.getNumSubscribers() > 0;
 
-    cv::bitwise_and(depth_mask_dst1, depth_mask_dst2, depth_mask_src);
-    
-    depth_mask_src.convertTo(depth_mask_src, CV_8U);
-   
-    cv::cvtColor(frame, frame, cv::COLOR_BGR2GRAY);
-    cv::threshold(frame, frame, BINARY_THRES, 255, cv::THRESH_BINARY);
-    frame_initial_thresholded = frame.clone();
-
-    // detect frame after filter out background
-    cv::bitwise_and(depth_mask_src, frame, frame); //filter out with depth information
-
-    // Blob method
-    std::vector<cv::KeyPoint> keypoints_rgb_d;
-	cv::SimpleBlobDetector::Params params;
-
-	params.filterByArea = false;
-    params.filterByColor = false;
-	params.filterByCircularity = false;
-	params.filterByConvexity = false;
-	params.filterByInertia = false;
-    params.minDistBetweenBlobs = 0.01;
-
-	cv::Ptr<cv::SimpleBlobDetector> detector = cv::SimpleBlobDetector::create(params);
-
-    detector->detect(frame, keypoints_rgb_d);
-	// cv::drawKeypoints( frame, keypoints_rgb_d, im_with_keypoints,CV_RGB(255,0,0), cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS );
-
-    
-    blobs_for_initialize = keypoints_rgb_d;
-
-    min_blob_size = INFINITY;
-
-    std::vector<Eigen::Vector2d> POI;
-    for(auto what : keypoints_rgb_d)
-    {
-        min_blob_size =(what.size < min_blob_size ? what.size : min_blob_size);
-        POI.push_back(Eigen::Vector2d(what.pt.x, what.pt.y));
-    }
-
-    return POI;
-}
-
-std::vector<Eigen::Vector2d> alan::LedNodelet::LED_extract_POI_alter(cv::Mat& frame, cv::Mat depth)
-{   
-    std::vector<Eigen::Vector2d> pts_2d_detected;
-
-
-    cv::Mat depth_mask_src = depth.clone(), depth_mask_dst1, depth_mask_dst2;
-
-    cv::threshold(depth_mask_src, depth_mask_dst1, LANDING_DISTANCE * 1000, 50000, cv::THRESH_BINARY_INV);
-    //filter out far depths
-    
-    depth_mask_dst1.convertTo(depth_mask_dst1, CV_8U);
-   
-    cv::cvtColor(frame, frame, cv::COLOR_BGR2GRAY);
-    cv::threshold(frame, frame, BINARY_THRES, 255, cv::THRESH_BINARY);
-    frame_initial_thresholded = frame.clone();
-
-    // detect frame after filter out background
-    cv::bitwise_and(depth_mask_dst1, frame, frame); //filter out with depth information
-
-    Eigen::MatrixXd reproject_2d_pts_matrix;
-    reproject_2d_pts_matrix.resize(LED_no, 2);
-
-    for(int i = 0; i < LED_no; i++)
-    {
-        reproject_2d_pts_matrix.block<1,2>(i, 0) = reproject_3D_2D(
-            pts_on_body_frame[i],
-            pose_global_sophus
-        );
-    }
-
-    Eigen::Vector2d minXY = reproject_2d_pts_matrix.colwise().minCoeff();
-    Eigen::Vector2d maxXY = reproject_2d_pts_matrix.colwise().maxCoeff();
-    Eigen::Vector2d deltaXY = maxXY - minXY;
-
-    minXY = minXY - deltaXY / 2;
-    maxXY = maxXY + deltaXY / 2;
+    if(!flight_log.isOpen() && !publish_led && !publish_uav)
+        return;
 
-    cv::Rect rect_ROI(
-        cv::Point2i(minXY.x(), minXY.y()), 
-        cv::Point2i(maxXY.x(), maxXY.y())
-    );
+    const double stamp = led_pose_estimated_msg.header.stamp.toSec();
 
-    cv::Mat ROI_mask = cv::Mat::zeros(
-        frame.size(),
-        frame.type()
+    Eigen::Vector3d rpy_led = q2rpy(
+        Eigen::Quaterniond(pose_led_inWorld_SE3.rotationMatrix())
     );
+    double orientation_led = Eigen::AngleAxisd(pose_led_inWorld_SE3.rotationMatrix()).angle();
 
-    cv::rectangle(ROI_mask, rect_ROI, CV_RGB(255, 255, 255), -1, 8, 0);
-    cv::Mat final_ROI;
-    frame.copyTo(final_ROI, ROI_mask);
-    // final input should be final_ROI here!!!!!!!!!!!
-    cv::GaussianBlur(final_ROI, final_ROI, cv::Size(0,0), 1.0, 1.0, cv::BORDER_DEFAULT);
+    double depth = (pose_cam_inWorld_SE3.translation() - pose_uav_inWorld_SE3.translation()).norm();
 
-    // Blob method
-    std::vector<cv::KeyPoint> keypoints_rgb_d;
-	cv::SimpleBlobDetector::Params params;
-
-	params.filterByArea = false;
-    params.filterByColor = false;
-	params.filterByCircularity = false;
-	params.filterByConvexity = false;
-	params.filterByInertia = false;
-    params.minDistBetweenBlobs = 0.01;
-
-	cv::Ptr<cv::SimpleBlobDetector> detector = cv::SimpleBlobDetector::create(params);
-
-    // cv::imshow("test", final_ROI);
-    // cv::waitKey(4);
-
-    detector->detect(final_ROI, keypoints_rgb_d);
-	cv::drawKeypoints(final_ROI, keypoints_rgb_d, im_with_keypoints,CV_RGB(255,0,0), cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
-   
-    
-    blobs_for_initialize = keypoints_rgb_d;
-
-    std::vector<cv::Point2f> POI_pts;
-    std::vector<cv::Point2f> centers;
-    cv::Mat labels;
-
-    // no k-means
-        for(auto what : keypoints_rgb_d)
-        {
-            pts_2d_detected.emplace_back(Eigen::Vector2d(what.pt.x, what.pt.y));
-        }   
-
-        frame_input = im_with_keypoints.clone();
-        int temp = pts_2d_detected.size();
-
-        if(pts_2d_detected.size() > LED_no)
-        {
-            ROS_WARN("LED_No over detection!!!!");
-            // std::cout<<i<<std::endl;
-            // cv::imwrite("/home/patty/alan_ws/over_detect_" 
-            //             + std::to_string(temp) + "__" + std::to_string(i) + ".jpg", frame_input);
-            // cv::imwrite("/home/patty/alan_ws/over_detect_" 
-            //             + std::to_string(temp) + "__" + std::to_string(i) + "_origin.jpg", frame_temp);
-            // i++;
-            // pc::pattyDebug("new method got shit!");
-        }
-
-        return pts_2d_detected;
-
-    // with k-means
-        // for(auto what : keypoints_rgb_d)
-        // {
-        //     POI_pts.emplace_back(cv::Point2f(what.pt.x, what.pt.y));
-        // }   
-        // int no_cluster = (POI_pts.size() > LED_no ? LED_no : POI_pts.size());
-
-        // cv::kmeans(POI_pts, no_cluster, labels, cv::TermCriteria(CV_TERMCRIT_EPS + CV_TERMCRIT_ITER, 10, 1), 8, cv::KMEANS_PP_CENTERS, centers);
-
-        // for(int i = 0; i < centers.size(); i++)
-        // {
-        //     pts_2d_detected.emplace_back(centers[i].x, centers[i].y);
-        // }
-
-        // frame_input = im_with_keypoints.clone();
-
-        // if(pts_2d_detected.size() > LED_no)
-        // {
-        //     ROS_WARN("LED_No over detection!!!!");
-        //     // pc::pattyDebug("new method got shit!");
-        // }
-
-        // return pts_2d_detected;
-}
-
-std::vector<Eigen::Vector3d> alan::LedNodelet::pointcloud_generate(std::vector<Eigen::Vector2d> pts_2d_detected, cv::Mat depthimage)
-{
-    //get 9 pixels around the point of interest
-    int no_pixels = 9;
-    int POI_width = (sqrt(9) - 1 ) / 2;
-
-    std::vector<Eigen::Vector3d> pointclouds;
-
-    int x_pixel, y_pixel;
-    Eigen::Vector3d temp;
-
-    depth_avg_of_all = 0;
-    
-
-    for(int i = 0; i < pts_2d_detected.size(); i++)
-    {
-
-        x_pixel = pts_2d_detected[i].x();
-        y_pixel = pts_2d_detected[i].y();
-        
-        cv::Point depthbox_vertice1 = cv::Point(x_pixel - POI_width, y_pixel - POI_width);
-        cv::Point depthbox_vertice2 = cv::Point(x_pixel + POI_width, y_pixel + POI_width);
-        cv::Rect letsgetdepth(depthbox_vertice1, depthbox_vertice2);
-
-        cv::Mat ROI(depthimage, letsgetdepth);
-        cv::Mat ROIframe;
-        ROI.copyTo(ROIframe);
-        std::vector<cv::Point> nonzeros;
-
-        cv::findNonZero(ROIframe, nonzeros);
-        std::vector<double> nonzerosvalue;
-        for(auto temp : nonzeros)
-        {
-            double depth = ROIframe.at<ushort>(temp);
-            nonzerosvalue.push_back(depth);
-        }
-
-        double depth_average;
-        if(nonzerosvalue.size() != 0)
-            depth_average = accumulate(nonzerosvalue.begin(), nonzerosvalue.end(),0.0)/nonzerosvalue.size();
-
-        double z_depth = 0.001 * depth_average;
-
-        depth_avg_of_all = depth_avg_of_all + z_depth;
-
-        temp.x() = x_pixel;
-        temp.y() = y_pixel;
-        temp.z() = 1;
-
-        temp = z_depth * cameraMat.inverse() * temp;
-        
-        pointclouds.push_back(temp);
-    }
-
-    depth_avg_of_all = depth_avg_of_all / pointclouds.size();
-
-    // cout<<"pcl"<<endl;
-    // cout<<depth_avg_of_all<<endl;
-
-    return pointclouds;
-}
-
-
-/* ================ Init. utilities function below ================ */
-
-bool alan::LedNodelet::initialization(cv::Mat& frame, cv::Mat depth)
-{
-    std::get<1>(corres_global_current).clear();
-
-    std::vector<Eigen::Vector2d> pts_2d_detect = LED_extract_POI(frame, depth); 
-    std::vector<Eigen::Vector3d> pts_3d_pcl_detect = pointcloud_generate(pts_2d_detect, depth);
-
-    //after above, I got:
-    //pointcloud in {c}
-    std::vector<double> norm_of_x_points, norm_of_y_points, norm_of_z_points;
+    Eigen::Vector3d rpy_uav = q2rpy(
+        Eigen::Quaterniond(pose_uav_inWorld_SE3.rotationMatrix())
+    );
+    double orientation_uav = Eigen::AngleAxisd(pose_uav_inWorld_SE3.rotationMatrix()).angle();
 
-    for(auto what :  pts_3d_pcl_detect)
+    if(flight_log.isOpen())
     {
-        norm_of_x_points.push_back(what.x());
-        norm_of_y_points.push_back(what.y());
-        norm_of_z_points.push_back(what.z());
+        flight_log.write(log_led, stamp, {
+            pose_led_inWorld_SE3.translation().x(),
+            pose_led_inWorld_SE3.translation().y(),
+            pose_led_inWorld_SE3.translation().z(),
+            uav_stpt_msg.pose.position.x,
+            uav_stpt_msg.pose.position.y,
+            uav_stpt_msg.pose.position.z,
+            rpy_led(0), rpy_led(1), rpy_led(2),
+            orientation_led,
+            ms,
+            depth,
+            pose_ugv_inWorld_SE3.translation().x(),
+            pose_ugv_inWorld_SE3.translation().y(),
+            pose_ugv_inWorld_SE3.translation().z(),
+            velo_led_inWorld_SE3.translation().x(),
+            velo_led_inWorld_SE3.translation().y(),
+            velo_led_inWorld_SE3.translation().z()
+        });
+
+        flight_log.write(log_uav, stamp, {
+            pose_uav_inWorld_SE3.translation().x(),
+            pose_uav_inWorld_SE3.translation().y(),
+            pose_uav_inWorld_SE3.translation().z(),
+            rpy_uav(0), rpy_uav(1), rpy_uav(2),
+            orientation_uav,
+            0, 0    // ms & dpth, never set on uav_log either
+        });
     }
 
-    // cout<<pts_3d_pcl_detect.size()<<endl;
-    // cout<<LED_no<<endl;
-
-    if(pts_3d_pcl_detect.size() == LED_no  //we got LED_no
-        && calculate_MAD(norm_of_x_points) < MAD_x_threshold //no outlier
-        && calculate_MAD(norm_of_y_points) < MAD_y_threshold 
-        && calculate_MAD(norm_of_z_points) < MAD_z_threshold) 
+    if(publish_led)
     {
-        Sophus::SE3d pose;
-
-        int i = 0;
-
-        //hsv detect color feature
-        cv::cvtColor(hsv, hsv, CV_RGB2HSV);
-        std::vector<bool> g_or_r; //g = true
-
-        std::vector<int> corres_g;
-        std::vector<int> corres_r;
-
-        for(int i = 0 ; i < blobs_for_initialize.size(); i++)
-        {
-            cv::Point hsv_vertice1 = cv::Point(pts_2d_detect[i].x() - 2 * blobs_for_initialize[i].size,
-                                               pts_2d_detect[i].y() - 2 * blobs_for_initialize[i].size);
-            cv::Point hsv_vertice2 = cv::Point(pts_2d_detect[i].x() + 2 * blobs_for_initialize[i].size,
-                                               pts_2d_detect[i].y() + 2 * blobs_for_initialize[i].size);
-
-            cv::Rect letsgethsv(hsv_vertice1, hsv_vertice2);
-
-            cv::Mat ROI(hsv, letsgethsv);
-
-            int size = ROI.cols * ROI.rows;
-            
-            double accu = 0;
-
-            cv::Vec3b hsv_value;
-
-            for(int i = 0; i < ROI.rows; i++)
-            {
-                for(int j = 0; j < ROI.cols; j++)
-                {
-                    hsv_value = ROI.at<cv::Vec3b>(i, j);
-
-                    if(hsv_value[0] == 0)                    
-                        size = size - 1;                
-                    else
-                        accu = accu + hsv_value[0];
-                }
-            }
-
-            if(accu/size < 100)
-                corres_g.push_back(i);
-            else   
-                corres_r.push_back(i);
-        }
-
-        std::vector<int> corres(LED_no);
-
-        if(corres_g.size() != LED_g_no || corres_r.size() != LED_r_no)
-        {
-            // cout<<"color"<<endl;
-            // cout<<corres_g.size()<<endl;
-            // cout<<corres_r.size()<<endl;
-            return false;
-        }
-
-        std::vector<int> final_corres;
-        double error_total = INFINITY;
-
-        Eigen::Matrix3d R;
-        Eigen::Vector3d t;
-
-        do
-        {
-            do
-            {
-                corres.clear();
-                for(auto what : corres_g)
-                    corres.push_back(what);
-                for(auto what : corres_r)
-                    corres.push_back(what);
-
-                std::vector<Eigen::Vector2d> pts_2d_detect_temp;   
-
-                for(auto what : corres)
-                {
-                    pts_2d_detect_temp.push_back(pts_2d_detect[what]);
-                }
-                                                        
-                solve_pnp_initial_pose(pts_2d_detect_temp, pts_on_body_frame);
-                
-                pose_global_sophus = pose_epnp_sophus;
-
-                double e = get_reprojection_error(                    
-                    pts_on_body_frame,
-                    pts_2d_detect_temp,
-                    pose_global_sophus,
-                    false
-                );
-
-                if(e < error_total)
-                {                    
-                    error_total = e;
-                    final_corres = corres;
-                    
-                    // if(error_total < 5)
-                    //     break;
-                }                        
-            } while (next_permutation(corres_r.begin(), corres_r.end()));
-
-        } while(next_permutation(corres_g.begin(), corres_g.end()));
-
-                
-        BA_error = error_total;
-
-        if(BA_error > LED_no * 2)
-        {
-            ROS_WARN("HELLO?");
-            return false;
-        }
-
-        correspondence::matchid corres_temp;
-        
-        pts_2d_detect_correct_order.clear();
+        alan_state_estimation::alan_log logdata_entry_led;
         
-        for(auto what : final_corres)
-        {
-            corres_temp.detected_indices = what;
-            corres_temp.detected_ornot = true;
-            corres_temp.pts_3d_correspond = pts_3d_pcl_detect[what];            
-            corres_temp.pts_2d_correspond = pts_2d_detect[what];
+        logdata_entry_led.px = pose_led_inWorld_SE3.translation().x();
+        logdata_entry_led.py = pose_led_inWorld_SE3.translation().y();
+        logdata_entry_led.pz = pose_led_inWorld_SE3.translation().z();
 
-            pts_2d_detect_correct_order.push_back(pts_2d_detect[what]); 
+        logdata_entry_led.set_px = uav_stpt_msg.pose.position.x;
+        logdata_entry_led.set_py = uav_stpt_msg.pose.position.y;
+        logdata_entry_led.set_pz = uav_stpt_msg.pose.position.z;
 
-            std::get<1>(corres_global_current).push_back(corres_temp);
-        }
+        logdata_entry_led.vx = velo_led_inWorld_SE3.translation().x();
+        logdata_entry_led.vy = velo_led_inWorld_SE3.translation().y();
+        logdata_entry_led.vz = velo_led_inWorld_SE3.translation().z();
 
-        if(std::get<1>(corres_global_current).size() != LED_no)
-        {
-            ROS_RED_STREAM("PLEASE DEBUG");
+        logdata_entry_led.roll  = rpy_led(0);
+        logdata_entry_led.pitch = rpy_led(1);
+        logdata_entry_led.yaw   = rpy_led(2);
+        logdata_entry_led.orientation = orientation_led;
 
-        }
+        logdata_entry_led.ms = ms;
+        logdata_entry_led.depth = depth;
 
-        camOptimize(
-            pose_global_sophus, 
-            pts_on_body_frame, 
-            pts_2d_detect_correct_order,
-            BA_error
-        );
+        logdata_entry_led.header.stamp = led_pose_estimated_msg.header.stamp;
 
-        detect_no = 6;
-        std::get<0>(corres_global_current) = detect_no;
-        corres_global_previous = corres_global_current;
-
-        return true;
+        record_led_pub.publish(logdata_entry_led);
     }
-    else
-        return false;
-}
-
-/* ================ k-means utilities function below ================ */
-
-void alan::LedNodelet::correspondence_search_2D2DCompare(
-    std::vector<Eigen::Vector2d>& pts_2d_detected,
-    std::vector<Eigen::Vector2d>& pts_2d_detected_previous
-)
-{
-    std::vector<cv::Point2f> pts;
-
-    for(auto what : pts_2d_detected_previous)
-        pts.emplace_back(cv::Point2f(what.x(), what.y()));
-    
-    //first emplace back pts_on_body_frame in 2D at this frame
-    //in preset order
-
-    for(auto what : pts_2d_detected)
-        pts.emplace_back(cv::Point2f(what.x(), what.y()));
-    
-    std::vector<cv::Point2f> centers;
-    cv::Mat labels;
 
-    cv::kmeans(pts, LED_no, labels, cv::TermCriteria(CV_TERMCRIT_EPS + CV_TERMCRIT_ITER, 10, 1), 8, cv::KMEANS_PP_CENTERS, centers);
-
-    int error_count = 0;
-
-    for(int i = 0; i < LED_no; i++)
-    {
-        int clusterIdx = labels.at<int>(i);
-        for(int k = 0; k < pts.size(); k++)
-        {
-            if(i == k)
-                continue;
-            int clusterIdx_detected = labels.at<int>(k);
-            if(clusterIdx == clusterIdx_detected)
-            {
-                if(k < LED_no)
-                {
-                    error_count++;
-                    break;
-                }  
-                else
-                {
-                    std::get<1>(corres_global_current)[i].detected_ornot = true;
-                    std::get<1>(corres_global_current)[i].pts_2d_correspond = pts_2d_detected[k - LED_no];
-                }                                                    
-            }
-        }
-    }    
-}
-
-inline double alan::LedNodelet::calculate_MAD(std::vector<double> norm_of_points)
-{
-    int n = norm_of_points.size();
-    double mean = 0, delta_sum = 0, MAD;
-    if(n != 0)
+    if(publish_uav)
     {
-        mean = accumulate(norm_of_points.begin(), norm_of_points.end(), 0.0) / n;
-        for(int i = 0; i < n; i++)
-            delta_sum = delta_sum + abs(norm_of_points[i] - mean);        
-        MAD = delta_sum / n;
-    }   
-
-    return MAD;
-}
-
-/* ================ Outlier Rejection utilities function below ================ */
-    /* in outlier rejection, we first calculate the MAD (mean average deviation)
-    to see whether there exists some outlier or not.
-    then, we try to do clustering with k-means algorithm.
-    as we are processing 3D points, at most time, 
-    the LED blobs should be close enough, 
-    while others being at some other coordinates that are pretty far away
-    hence, we set the clustering no. as 2.
-    we then calcullate the distance between the centroid of the cluster to the
-    center at previous time step(pcl_center_point_wo_outlier_previous)
-    and determine which cluster is the one that we want */
-
-void alan::LedNodelet::reject_outlier(std::vector<Eigen::Vector2d>& pts_2d_detect, cv::Mat depth)
-{
-    std::vector<Eigen::Vector3d> pts_3d_detect = pointcloud_generate(pts_2d_detect, depth);
-    //what is this for?
-    //to get 3d coordinates in body frame, so that 
-    //outlier rejection could be performed
-    int n = pts_3d_detect.size();
-
-    std::vector<cv::Point3f> pts;
-    std::vector<double> norm_of_x_points;
-    std::vector<double> norm_of_y_points;
-    std::vector<double> norm_of_z_points;
-
-    for(auto what :  pts_3d_detect)
-    {
-        norm_of_x_points.push_back(what.x());
-        norm_of_y_points.push_back(what.y());
-        norm_of_z_points.push_back(what.z());
-
-        pts.push_back(cv::Point3f(what.x(), what.y(), what.z()));
-    }
-
-    cv::Mat labels;
-    std::vector<cv::Point3f> centers;
-
-    
-    if(calculate_MAD(norm_of_x_points) > MAD_x_threshold  
-        || calculate_MAD(norm_of_y_points) > MAD_y_threshold
-        || calculate_MAD(norm_of_z_points) > MAD_z_threshold)
-    {   
-        ROS_WARN("GOT SOME REJECTION TO DO!");
-        // cout<<"got some rejection to do"<<endl;
-        cv::kmeans(pts, 2, labels, cv::TermCriteria(CV_TERMCRIT_EPS + CV_TERMCRIT_ITER, 10, 1), 8, cv::KMEANS_PP_CENTERS, centers);
-
-        double d0 = cv::norm(pcl_center_point_wo_outlier_previous - centers[0]);
-        double d1 = cv::norm(pcl_center_point_wo_outlier_previous - centers[1]);
-
-        std::vector<Eigen::Vector2d> pts_2d_result;
-        std::vector<Eigen::Vector3d> pts_3d_result;
-
-        if(d0 < d1) //then get index with 0
-        {           
-            for(int i = 0; i < labels.rows; i++)
-            {
-                if(labels.at<int>(0,i) == 0)
-                {
-                    pts_2d_result.push_back(pts_2d_detect[i]);
-                    pts_3d_result.push_back(pts_3d_detect[i]); 
-                }                    
-            }            
-            pcl_center_point_wo_outlier_previous = centers[0];
-        }
-        else
-        {
-            for(int i = 0; i < labels.rows; i++)
-            {
-
-                if(labels.at<int>(0,i) == 1)
-                {                    
-                    pts_2d_result.push_back(pts_2d_detect[i]);
-                    pts_3d_result.push_back(pts_3d_detect[i]);                    
-                }
-            }
-            pcl_center_point_wo_outlier_previous = centers[1];
-        }
-            
-        pts_2d_detect.clear();
-        pts_2d_detect = pts_2d_result;
-
-        pts_3d_detect.clear();
-        pts_3d_detect = pts_3d_result;
-
-    }
-    else
-    {
-        cv::Mat temp;
+        alan_state_estimation::alan_log logdata_entry_uav;
         
-        cv::reduce(pts, temp, 01, CV_REDUCE_AVG);
-        pcl_center_point_wo_outlier_previous = cv::Point3f(temp.at<float>(0,0), temp.at<float>(0,1), temp.at<float>(0,2));
-
-    }
-
-    led_3d_posi_in_camera_frame_depth = Eigen::Vector3d(
-        pcl_center_point_wo_outlier_previous.x,
-        pcl_center_point_wo_outlier_previous.y,
-        pcl_center_point_wo_outlier_previous.z
-    );
-}
-
-/* ================ UI utilities function below ================ */
-
-void alan::LedNodelet::set_image_to_publish(double freq, const sensor_msgs::CompressedImageConstPtr & rgbmsg)
-{    
-    char hz[40];
-    char fps[10] = " fps";
-    sprintf(hz, "%.2f", freq);
-    strcat(hz, fps);
-
-    char BA[40] = "BA: ";
-    char BA_error_display[10];
-    sprintf(BA_error_display, "%.2f", BA_error);
-    strcat(BA, BA_error_display);
-
-    char depth[40] = "DPTH: ";
-    char depth_display[10];
-    sprintf(depth_display, "%.2f", depth_avg_of_all);
-    strcat(depth, depth_display);
-    
-    cv::putText(display, hz, cv::Point(20,40), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));  
-    cv::putText(display, std::to_string(detect_no), cv::Point(720,460), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));
-    cv::putText(display, BA, cv::Point(720,60), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));
-    cv::putText(display, depth, cv::Point(20,460), cv::FONT_HERSHEY_PLAIN, 1.6, CV_RGB(255,0,0));
-
-    cv::Mat imageoutput = display.clone();
-    cv_bridge::CvImage for_visual;
-    for_visual.header = rgbmsg->header;
-    for_visual.encoding = sensor_msgs::image_encodings::BGR8;
-    for_visual.image = imageoutput;
-    this->pubimage.publish(for_visual.toImageMsg());
-
-
-    cv_bridge::CvImage for_visual_input;
-    for_visual_input.header = rgbmsg->header;
-    for_visual_input.encoding = sensor_msgs::image_encodings::BGR8;
-    for_visual_input.image = frame_input;
-    this->pubimage_input.publish(for_visual_input.toImageMsg());   
-
-}
+        logdata_entry_uav.px = pose_uav_inWorld_SE3.translation().x();
+        logdata_entry_uav.py = pose_uav_inWorld_SE3.translation().y();
+        logdata_entry_uav.pz = pose_uav_inWorld_SE3.translation().z();
 
-void alan::LedNodelet::log(double ms)
-{
-    alan_state_estimation::alan_log logdata_entry_led;
-    
-    logdata_entry_led.px = pose_led_inWorld_SE3.translation().x();
-    logdata_entry_led.py = pose_led_inWorld_SE3.translation().y();
-    logdata_entry_led.pz = pose_led_inWorld_SE3.translation().z();
-
-    logdata_entry_led.set_px = uav_stpt_msg.pose.position.x;
-    logdata_entry_led.set_py = uav_stpt_msg.pose.position.y;
-    logdata_entry_led.set_pz = uav_stpt_msg.pose.position.z;
-
-    logdata_entry_led.vx = velo_led_inWorld_SE3.translation().x();
-    logdata_entry_led.vy = velo_led_inWorld_SE3.translation().y();
-    logdata_entry_led.vz = velo_led_inWorld_SE3.translation().z();
-    
-    Eigen::Vector3d rpy = q2rpy(
-        Eigen::Quaterniond(pose_led_inWorld_SE3.rotationMatrix())
-    );
-
-    logdata_entry_led.roll  = rpy(0);
-    logdata_entry_led.pitch = rpy(1);
-    logdata_entry_led.yaw   = rpy(2);
-
-    Eigen::AngleAxisd angle_axis_led = Eigen::AngleAxisd(pose_led_inWorld_SE3.rotationMatrix());
-    logdata_entry_led.orientation = angle_axis_led.angle();
-
-    logdata_entry_led.ms = ms;
-    logdata_entry_led.depth = abs(
-        sqrt(
-            pow(
-                pose_cam_inWorld_SE3.translation().x() - pose_uav_inWorld_SE3.translation().x(),
-                2
-            ) +
-            pow(pose_cam_inWorld_SE3.translation().y() - pose_uav_inWorld_SE3.translation().y(),
-                2
-            ) +
-            pow(pose_cam_inWorld_SE3.translation().z() - pose_uav_inWorld_SE3.translation().z(),
-                2
-            )
-        )        
-    );
-
-    logdata_entry_led.header.stamp = led_pose_header.stamp;
-
-    record_led_pub.publish(logdata_entry_led);
+        logdata_entry_uav.roll  = rpy_uav(0);
+        logdata_entry_uav.pitch = rpy_uav(1);
+        logdata_entry_uav.yaw   = rpy_uav(2);
+        logdata_entry_uav.orientation = orientation_uav;
 
-    ///////////////////////////////////////////////////////////
+        logdata_entry_uav.header.stamp = led_pose_estimated_msg.header.stamp;
 
-    alan_state_estimation::alan_log logdata_entry_uav;
-    
-    logdata_entry_uav.px = pose_uav_inWorld_SE3.translation().x();
-    logdata_entry_uav.py = pose_uav_inWorld_SE3.translation().y();
-    logdata_entry_uav.pz = pose_uav_inWorld_SE3.translation().z();
-    
-    rpy = q2rpy(
-        Eigen::Quaterniond(pose_uav_inWorld_SE3.rotationMatrix())
-    );
-
-    logdata_entry_uav.roll  = rpy(0);
-    logdata_entry_uav.pitch = rpy(1);
-    logdata_entry_uav.yaw   = rpy(2);
-
-    Eigen::AngleAxisd angle_axis_uav = Eigen::AngleAxisd(pose_uav_inWorld_SE3.rotationMatrix());
-    logdata_entry_uav.orientation = angle_axis_uav.angle();
-
-    logdata_entry_uav.header.stamp = led_pose_header.stamp;
-
-    record_uav_pub.publish(logdata_entry_uav);
+        record_uav_pub.publish(logdata_entry_uav);
+    }
 }
 
-void alan::LedNodelet::terminal_msg_display(double hz)
+void alan::LedNodelet::terminal_msg_display(double hz, ledReport& report, const std::string& name)
 {
-    std::string LED_terminal_display = "DETECT_no: " + std::to_string(detect_no);
+    std::string LED_terminal_display = "DETECT_no: " + std::to_string(report.detect_no);
+    if(!name.empty())
+        LED_terminal_display = name + " || " + LED_terminal_display;
 
     std::ostringstream out1;
     out1.precision(2);
-    out1<<std::fixed<<BA_error;
+    out1<<std::fixed<<report.BA_error;
     std::string BA_terminal_display = " || BA_ERROR: " + out1.str();
 
     std::ostringstream out2;
     out2.precision(2);
-    out2<<std::fixed<<depth_avg_of_all;
+    out2<<std::fixed<<report.depth_avg;
     std::string depth_terminal_display = " || depth: " + out2.str();
 
     std::ostringstream out3;
@@ -1333,14 +595,35 @@ void alan::LedNodelet::terminal_msg_display(double hz)
     out3<<std::fixed<<hz;
     std::string hz_terminal_display = " || hz: " + out3.str();
 
+    std::string realloc_terminal_display = " || pool reallocs: " 
+        + std::to_string(report.frame_reallocs)
+        + " (" + std::to_string(report.total_reallocs) + ")"
+        + " || ROI decode: " + std::to_string(report.ROI_decode_no)
+        + " || recovered: " + std::to_string(report.recover_no);
+
     std::string final_msg = LED_terminal_display 
         + BA_terminal_display 
         + depth_terminal_display
-        + hz_terminal_display;
+        + hz_terminal_display
+        + realloc_terminal_display;
+
+    if(pipeline_on)
+    {
+        // per stage ms, then frames lost at each hand-off and frames skipped by the estimator
+        std::ostringstream out4;
+        out4.precision(2);
+        out4<<std::fixed<<report.ms_front<<" / "<<report.ms_estimate;
+        final_msg = final_msg 
+            + " || stage ms: " + out4.str()
+            + " || dropped: " + std::to_string(ring_input.getDropped())
+            + " / " + std::to_string(ring_frame.getDropped())
+            + " / " + std::to_string(ring_report.getDropped())
+            + " || stale: " + std::to_string(report.stale_no);
+    }
 
     std::string LED_tracker_status_display;
 
-    if(LED_tracker_initiated_or_tracked)
+    if(report.tracked)
     {
         final_msg = "LED GOOD || " + final_msg;
         ROS_GREEN_STREAM(final_msg);
@@ -1349,8 +632,93 @@ void alan::LedNodelet::terminal_msg_display(double hz)
     {
         final_msg = "LED BAD! || " + final_msg;
         ROS_RED_STREAM(final_msg);
-        if(tracker_started)
+        if(report.tracker_started)
             error_no ++;
     }
     std::cout<<"fail: "<< error_no<<" / "<<total_no<<std::endl;
 }
+
+void alan::LedNodelet::trace_callback(const ros::TimerEvent& event)
+{
+    // only reader of the tracer: drain, publish the rolling percentiles, roll the window
+    vision::stageTracer& stage_tracer = *getTracer();
+    stage_tracer.drain();
+
+    diagnostic_msgs::DiagnosticArray diag;
+    diag.header.stamp = event.current_real;
+
+    auto key_value = [](const std::string& key, double value)
+    {
+        std::ostringstream out;
+        out.precision(2);
+        out<<std::fixed<<value;
+
+        diagnostic_msgs::KeyValue kv;
+        kv.key = key;
+        kv.value = out.str();
+        return kv;
+    };
+
+    for(int stage = 0; stage < vision::TRACE_STAGE_NO; stage++)
+    {
+        const vision::traceSummary summary = stage_tracer.summary(stage);
+
+        diagnostic_msgs::DiagnosticStatus status;
+        status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        status.name = std::string("led/") + vision::traceStageName(stage);
+        status.hardware_id = "alan_state_estimation";
+        status.message = std::to_string(summary.count) + " spans";
+        status.values.push_back(key_value("p50_us", summary.p50_us));
+        status.values.push_back(key_value("p95_us", summary.p95_us));
+        status.values.push_back(key_value("p99_us", summary.p99_us));
+        status.values.push_back(key_value("max_us", summary.max_us));
+        diag.status.push_back(status);
+    }
+
+    // pairing of the camera streams, drops per stream and pairs replaced behind a busy callback
+    const vision::syncStats sync = cam_sync.getStats();
+
+    diagnostic_msgs::DiagnosticStatus status_sync;
+    status_sync.level = diagnostic_msgs::DiagnosticStatus::OK;
+    status_sync.name = "led/sync";
+    status_sync.hardware_id = "alan_state_estimation";
+    status_sync.message = std::to_string(sync.paired) + " pairs";
+    status_sync.values.push_back(key_value("dropped_rgb", sync.dropped_a));
+    status_sync.values.push_back(key_value("dropped_depth", sync.dropped_b));
+    status_sync.values.push_back(key_value("dropped_busy", sync.dropped_busy));
+    status_sync.values.push_back(key_value("latency_avg_ms", sync.latency_avg_ms));
+    status_sync.values.push_back(key_value("latency_max_ms", sync.latency_max_ms));
+    diag.status.push_back(status_sync);
+
+    diagnostic_msgs::DiagnosticStatus status;
+    status.level = stage_tracer.getLost() > 0 
+        ? diagnostic_msgs::DiagnosticStatus::WARN 
+        : diagnostic_msgs::DiagnosticStatus::OK;
+    status.name = "led/trace";
+    status.hardware_id = "alan_state_estimation";
+    status.message = std::to_string(stage_tracer.getLost()) + " spans lost";
+    diag.status.push_back(status);
+
+    trace_pub.publish(diag);
+
+    if(event.current_real.toSec() - trace_last_roll >= trace_window)
+    {
+        stage_tracer.roll();
+        trace_last_roll = event.current_real.toSec();
+    }
+}
+
+void alan::LedNodelet::trace_dump()
+{
+    vision::stageTracer& stage_tracer = *getTracer();
+
+    if(trace_dump_file.empty() || !stage_tracer.enabled())
+        return;
+
+    stage_tracer.drain();
+
+    if(stage_tracer.dump(trace_dump_file))
+        ROS_INFO_STREAM("LATENCY TRACE DUMPED TO " << trace_dump_file);
+    else
+        ROS_ERROR_STREAM("CANNOT WRITE LATENCY TRACE TO " << trace_dump_file);
+}
@@ -0,0 +1,333 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledMultiTracker.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief several LED constellations from one camera: one decode and segmentation, one AIEKF per target
+ */
+
+#include "include/ledMultiTracker.h"
+
+/* ================ configs below ================ */
+
+bool alan::ledMultiTracker::config(const masterParams& params)
+{
+    XmlRpc::XmlRpcValue target_list;
+
+    if(
+        !params.getParam("LED_targets", target_list)
+        || target_list.getType() != XmlRpc::XmlRpcValue::TypeArray
+        || target_list.size() == 0
+    )
+    {
+        ROS_ERROR("NO TARGETS IN /alan_master/LED_targets!");
+        return false;
+    }
+
+    targets.clear();
+    targets.resize(target_list.size());
+
+    for(int k = 0; k < (int)targets.size(); k++)
+    {
+        ledTarget& target = targets[k];
+
+        target.name = "target" + std::to_string(k);
+        if(target_list[k].getType() == XmlRpc::XmlRpcValue::TypeStruct && target_list[k].hasMember("name"))
+            target.name = static_cast<std::string>(target_list[k]["name"]);
+
+        std::cout<<"\nTARGET "<<target.name<<std::endl;
+
+        target.tracker.reset(new ledTracker());
+        if(!target.tracker->config(params.overlay(target_list[k])))
+            return false;
+
+        // one set of stage latencies, whichever thread a target runs on
+        if(k > 0)
+            target.tracker->setTracer(targets[0].tracker->getTracer());
+
+        target.item.pts_2d_detect.reserve(64);
+        target.item.blobs.reserve(64);
+    }
+
+    frame_shared.pts_2d_detect.reserve(64 * targets.size());
+    frame_shared.blobs.reserve(64 * targets.size());
+
+    params.getParam("LED_group_radius", group_radius);
+    depth_sampler = targets[0].tracker->getDepthSampler();
+
+    // the caller takes one target itself
+    int thread_no = targets.size() - 1;
+    params.getParam("LED_target_threads", thread_no);
+    workers.start(std::max(0, std::min<int>(thread_no, targets.size() - 1)));
+
+    ROS_GREEN_STREAM(std::to_string(targets.size()) + " LED TARGETS, "
+        + std::to_string(workers.size()) + " WORKER THREADS!");
+
+    return true;
+}
+
+void alan::ledMultiTracker::setFramesInFlight(bool in_flight)
+{
+    // only the first target decodes
+    if(!targets.empty())
+        targets[0].tracker->setFramesInFlight(in_flight);
+}
+
+/* ================ shared front end below ================ */
+
+bool alan::ledMultiTracker::front_end(const ledInput& input)
+{
+    ledTracker& front = *targets[0].tracker;
+
+    // let go of the last frame everywhere, so the pool can reuse its buffers
+    for(auto& target : targets)
+    {
+        target.item.frame.release();
+        target.item.display.release();
+        target.item.frame_input.release();
+        target.item.depth.release();
+        target.item.depth_ptr.reset();
+        target.item.depthmsg.reset();
+    }
+
+    if(!front.begin_frame(input, frame_shared))
+        return false;
+
+    ROIs.clear();
+    frame_shared.tracking = true;
+
+    for(auto& target : targets)
+    {
+        target.tracking = target.tracker->predict_ROI(
+            frame_shared.header.stamp.toSec(),
+            frame_shared.reset,
+            target.ROI
+        );
+
+        frame_shared.tracking = frame_shared.tracking && target.tracking;
+
+        if(target.tracking)
+            ROIs.push_back(target.ROI);
+    }
+
+    if(!front.extract(input, frame_shared, ROIs))
+        return false;
+
+    assign_blobs();
+
+    return true;
+}
+
+void alan::ledMultiTracker::assign_blobs()
+{
+    const int n = frame_shared.blobs.size();
+    owner.assign(n, -1);
+
+    // tracked targets, overlapping windows go to the nearer centre
+    for(int i = 0; i < n; i++)
+    {
+        const vision::ledBlob& blob = frame_shared.blobs[i];
+        double d_best = INFINITY;
+
+        for(int k = 0; k < (int)targets.size(); k++)
+        {
+            const cv::Rect& ROI = targets[k].ROI;
+
+            if(!targets[k].tracking || !ROI.contains(cv::Point(blob.x, blob.y)))
+                continue;
+
+            const double d = std::hypot(
+                blob.x - (ROI.x + 0.5 * ROI.width),
+                blob.y - (ROI.y + 0.5 * ROI.height)
+            );
+
+            if(d < d_best)
+            {
+                d_best = d;
+                owner[i] = k;
+            }
+        }
+    }
+
+    // targets still initializing
+    int waiting_no = 0, waiting_one = -1;
+    for(int k = 0; k < (int)targets.size(); k++)
+        if(!targets[k].tracking)
+        {
+            waiting_no++;
+            waiting_one = k;
+        }
+
+    if(waiting_no == 1)
+    {
+        // everything left, as the single-target tracker would see it
+        for(int i = 0; i < n; i++)
+            if(owner[i] < 0)
+                owner[i] = waiting_one;
+    }
+    else if(waiting_no > 1)
+    {
+        group_unclaimed();
+
+        const int first = init_turn++ % targets.size();
+
+        for(int j = 0; j < (int)targets.size(); j++)
+        {
+            const int k = (first + j) % targets.size();
+            if(targets[k].tracking)
+                continue;
+
+            // a group of its LED count, else the largest one left
+            int pick = -1;
+            for(int g = 0; g < (int)group_size.size(); g++)
+            {
+                if(group_taken[g])
+                    continue;
+
+                if(group_size[g] == targets[k].tracker->getLEDNo())
+                {
+                    pick = g;
+                    break;
+                }
+
+                if(pick < 0 || group_size[g] > group_size[pick])
+                    pick = g;
+            }
+
+            if(pick < 0)
+                break;
+
+            group_taken[pick] = true;
+            for(int i = 0; i < n; i++)
+                if(owner[i] < 0 && group[i] == pick)
+                    owner[i] = k;
+        }
+    }
+
+    for(int k = 0; k < (int)targets.size(); k++)
+    {
+        ledFrame& item = targets[k].item;
+
+        item.header = frame_shared.header;
+        item.tick = frame_shared.tick;
+        item.depth_ptr = frame_shared.depth_ptr;
+        item.depthmsg = frame_shared.depthmsg;
+        item.depth_view = frame_shared.depth_view;
+        item.frame = frame_shared.frame;
+        item.frame_scale = frame_shared.frame_scale;
+        item.depth = frame_shared.depth;
+        item.display = frame_shared.display;
+        item.frame_input = frame_shared.frame_input;
+        item.display_on = frame_shared.display_on;
+        item.input_on = frame_shared.input_on;
+        item.reset = frame_shared.reset;
+        item.tracking = targets[k].tracking;
+
+        item.pts_2d_detect.clear();
+        item.blobs.clear();
+        item.min_blob_size = INFINITY;
+
+        for(int i = 0; i < n; i++)
+        {
+            if(owner[i] != k)
+                continue;
+
+            const vision::ledBlob& blob = frame_shared.blobs[i];
+            item.blobs.push_back(blob);
+            item.pts_2d_detect.emplace_back(blob.x, blob.y);
+            item.min_blob_size = std::min(item.min_blob_size, blob.size);
+        }
+
+        item.frame_reallocs = frame_shared.frame_reallocs;
+        item.total_reallocs = frame_shared.total_reallocs;
+        item.ROI_decode_no = frame_shared.ROI_decode_no;
+        item.ms_front = frame_shared.ms_front;
+    }
+}
+
+void alan::ledMultiTracker::group_unclaimed()
+{
+    /* single linkage in the camera frame: blobs closer than LED_group_radius
+    belong to one vehicle. blobs without depth stay on their own. */
+    const int n = frame_shared.blobs.size();
+
+    // pts_2d_detect is in step with blobs
+    depth_sampler.backproject(frame_shared.depth_view, frame_shared.pts_2d_detect, pts_3d);
+
+    group.assign(n, -1);
+    group_size.clear();
+
+    for(int i = 0; i < n; i++)
+    {
+        if(owner[i] >= 0 || group[i] >= 0)
+            continue;
+
+        const int g = group_size.size();
+        group[i] = g;
+        group_size.push_back(1);
+
+        if(pts_3d[i].z() <= 0)
+            continue;
+
+        fill.clear();
+        fill.push_back(i);
+
+        while(!fill.empty())
+        {
+            const int a = fill.back();
+            fill.pop_back();
+
+            for(int j = i + 1; j < n; j++)
+            {
+                if(owner[j] >= 0 || group[j] >= 0 || pts_3d[j].z() <= 0)
+                    continue;
+
+                if((pts_3d[j] - pts_3d[a]).norm() < group_radius)
+                {
+                    group[j] = g;
+                    group_size[g]++;
+                    fill.push_back(j);
+                }
+            }
+        }
+    }
+
+    group_taken.assign(group_size.size(), false);
+}
+
+/* ================ per-target estimation below ================ */
+
+void alan::ledMultiTracker::estimate()
+{
+    auto estimate_one = [this](int k)
+    {
+        targets[k].tracker->estimate(targets[k].item, targets[k].report);
+    };
+
+    // debug images are one Mat every target draws on
+    if(frame_shared.display_on || frame_shared.input_on)
+    {
+        for(int k = 0; k < (int)targets.size(); k++)
+            estimate_one(k);
+        return;
+    }
+
+    workers.run(targets.size(), estimate_one);
+}
@@ -0,0 +1,1478 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file ledTracker.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief LED pose estimation core: extraction, correspondence and AIEKF, without publishers or subscribers
+ */
+
+#include "include/ledTracker.h"
+
+/* ================ configs below ================ */
+
+bool alan::ledTracker::config(const masterParams& params)
+{
+    POI_config(params);
+    camIntrinsic_config(params);
+    LEDInBodyAndOutlierSetting_config(params);
+    KF_config(params);
+
+    seg_runs.reserve(_width * 4);
+    blob_extractor.reserve(_width * 4, 64, blobs_for_initialize);
+    blobs_ROI.reserve(64);
+
+    if(pts_on_body_frame.size() < 3)
+    {
+        ROS_ERROR("NO LED CONSTELLATION IN /alan_master/LED_positions!");
+        return false;
+    }
+
+    return true;
+}
+
+void alan::ledTracker::setFramesInFlight(bool in_flight)
+{
+    frame_pool.setDepth(in_flight ? vision::POOL_DEPTH_MAX : 1);
+}
+
+void alan::ledTracker::POI_config(const masterParams& params)
+{
+    // load POI_extract config
+    params.getParam("LANDING_DISTANCE", LANDING_DISTANCE);
+    params.getParam("BINARY_threshold", BINARY_THRES);
+    params.getParam("frame_width", _width);
+    params.getParam("frame_height", _height);
+    params.getParam("LED_min_blob_area", blob_extractor.min_area);
+    params.getParam("JPEG_ROI_decode", ROI_decode_on);
+    params.getParam("JPEG_init_scale", init_decode_scale);
+
+    bool trace_on = true;
+    params.getParam("TRACE_ON", trace_on);
+    stage_tracer.enable(trace_on);
+    tracer = &stage_tracer;
+
+    if(trace_on && !ALAN_TRACE_ON)
+        ROS_WARN("BUILT WITHOUT ALAN_TRACE, LATENCY TRACE OFF!");
+
+    std::string depth_stat = "median";
+    params.getParam("DEPTH_sample", depth_stat);
+    params.getParam("DEPTH_sample_window", depth_sampler.half_window);
+    params.getParam("DEPTH_SPARSE", depth_sparse);
+    depth_sampler.stat = vision::depthStatFromString(depth_stat);
+
+    if(!JPEG_PARTIAL_DECODE_ON)
+        ROS_WARN("NO LIBJPEG-TURBO, PARTIAL DECODE OFF!");
+}
+
+void alan::ledTracker::camIntrinsic_config(const masterParams& params)
+{
+    // load camera intrinsics
+    XmlRpc::XmlRpcValue intrinsics_list;
+    params.getParam("cam_intrinsics_455", intrinsics_list);
+
+    for(int i = 0; i < 3; i++)
+        for(int j = 0; j < 3; j++)
+        {
+            std::ostringstream ostr;
+            ostr << intrinsics_list[3 * i+ j];
+            std::istringstream istr(ostr.str());
+            istr >> cameraMat(i, j);
+        }
+
+    depth_sampler.setCamera(cameraMat);
+}
+
+void alan::ledTracker::LEDInBodyAndOutlierSetting_config(const masterParams& params)
+{
+    //load LED potisions in body frame
+    XmlRpc::XmlRpcValue LED_list;
+    double temp_delta = 0;
+    params.getParam("LED_positions", LED_list); 
+    params.getParam("LED_temp", temp_delta); 
+
+    std::vector<double> norm_of_x_points, norm_of_y_points, norm_of_z_points;
+
+    std::cout<<"\nPts on body frame (X Y Z):\n";
+    for(int i = 0; i < LED_list.size(); i++)
+    {
+        Eigen::Vector3d temp(LED_list[i]["x"], LED_list[i]["y"], LED_list[i]["z"]);
+        
+        temp.x() -= temp_delta;
+
+        norm_of_x_points.push_back(temp.x());
+        norm_of_y_points.push_back(temp.y());
+        norm_of_z_points.push_back(temp.z());                    
+        std::cout<<"-----"<<std::endl;
+        std::cout<<temp.x()<<" "<<temp.y()<<" "<<temp.z()<<" "<<std::endl; 
+        
+        pts_on_body_frame.push_back(temp);
+    }   
+    std::cout<<std::endl;
+
+    LED_no = pts_on_body_frame.size();
+
+    params.getParam("LED_r_number", LED_r_no);
+    params.getParam("LED_g_number", LED_g_no);
+
+    params.getParam("LED_colour_min_chroma", colour_classifier.min_chroma);
+    params.getParam("LED_colour_flip_conf", colour_flip_conf);
+    colour_classifier.build();
+
+    // constellation invariants for the initial correspondence search
+    double match_depth_tol = 0.02;
+    params.getParam("LED_match_depth_tol", match_depth_tol);
+    params.getParam("LED_match_gate", constellation_matcher.gate_px);
+
+    if(pts_on_body_frame.size() > correspondence::MATCH_MAX_LED)
+        ROS_ERROR("TOO MANY LEDS FOR CORRESPONDENCE SEARCH!");
+
+    params.getParam("LED_assoc_gate", led_assigner.gate_chi2);
+    params.getParam("LED_assoc_px_floor", led_assigner.px_floor);
+
+    // lost track: windowed search around the last good pose before initialization
+    params.getParam("LED_recovery_timeout", recovery_timeout);
+    params.getParam("LED_recovery_sigma", recovery_sigma);
+    params.getParam("LED_recovery_accel", recovery_accel);
+    params.getParam("LED_recovery_max_area", recovery_max_area);
+
+    // refinement of the matched initial pose
+    std::string BA_kernel = "none";
+    params.getParam("BA_kernel", BA_kernel);
+    params.getParam("BA_kernel_px", BA_refiner.kernel_px);
+    BA_refiner.kernel = vision::kernelFromString(BA_kernel);
+
+    constellation_matcher.setConstellation(
+        pts_on_body_frame, 
+        LED_g_no, 
+        cameraMat, 
+        match_depth_tol
+    );
+
+    //load outlier rejection info
+    params.getParam("MAD_dilate", MAD_dilate);
+    params.getParam("MAD_max", MAD_max);
+
+    MAD_x_threshold = (calculate_MAD(norm_of_x_points) * MAD_dilate > MAD_max ? MAD_max : calculate_MAD(norm_of_x_points) * MAD_dilate);
+    MAD_y_threshold = (calculate_MAD(norm_of_y_points) * MAD_dilate > MAD_max ? MAD_max : calculate_MAD(norm_of_y_points) * MAD_dilate);
+    MAD_z_threshold = (calculate_MAD(norm_of_z_points) * MAD_dilate > MAD_max ? MAD_max : calculate_MAD(norm_of_z_points) * MAD_dilate);
+}
+
+void alan::ledTracker::KF_config(const masterParams& params)
+{
+    double Q_val;
+    double R_val_p;
+    double R_val_v;
+
+    params.getParam("Q_val", Q_val);
+    params.getParam("R_val_p", R_val_p);
+    params.getParam("R_val_v", R_val_v);
+    params.getParam("Q_alpha", QAdaptiveAlpha);
+    params.getParam("R_beta", RAdaptiveBeta);
+    params.getParam("kf_size", kf_size);
+    params.getParam("kfZ_size", kfZ_size);
+    params.getParam("velo_IIR_alpha", velo_IIR_alpha);
+    params.getParam("OPT_MAX_ITERATION", MAX_ITERATION);
+    params.getParam("CONVERGE_THRESHOLD", CONVERGE_THRESHOLD);
+
+    params.getParam("KF_ON", KF_ON);
+
+    if(KF_ON)        
+        ROS_GREEN_STREAM("KF IS ON!");                
+
+    Q_init.resize(kf_size, kf_size);
+    Q_init.setIdentity();
+    Q_init = Q_init * Q_val;
+
+    R_init.resize(kfZ_size, kfZ_size);
+    R_init.setIdentity();
+    R_init.block<2,2>(0,0) = R_init.block<2,2>(0,0) * R_val_p;
+    R_init.block<3,3>(2,2) = R_init.block<3,3>(2,2) * R_val_v;
+}
+
+/* ================ pipeline stages below ================ */
+    /* decode/extraction and correspondence/AIEKF, either one after another
+    or each on its own thread (LedNodelet's pipelined mode). every stage only
+    touches its own members, per-frame data travels in ledFrame / ledReport,
+    and the posterior for the next ROI travels back in ledPrior. */
+
+bool alan::ledTracker::front_end(const ledInput& input, ledFrame& item)
+{
+    if(!begin_frame(input, item))
+        return false;
+
+    cv::Rect ROI;
+    item.tracking = predict_ROI(item.header.stamp.toSec(), item.reset, ROI);
+
+    ROIs_front.clear();
+    if(item.tracking)
+        ROIs_front.push_back(ROI);
+
+    return extract(input, item, ROIs_front);
+}
+
+bool alan::ledTracker::begin_frame(const ledInput& input, ledFrame& item)
+{
+    tick_front = vision::traceNow() * 1e-9;
+
+    item.header = input.rgbmsg->header;
+    item.tick = input.tick;
+
+    // let go of the last frame first, so the pool can reuse its buffers
+    item.frame.release();
+    item.frame_scale = 1;
+    item.display.release();
+    item.frame_input.release();
+    item.depth.release();
+    item.depth_ptr.reset();
+    item.depthmsg.reset();
+
+    if(depth_sparse)
+    {
+        // no depth image at all, the detections are sampled in the message buffer
+        item.depthmsg = input.depthmsg;
+        item.depth_view = vision::viewDepth(
+            item.depthmsg->data.data(),
+            item.depthmsg->width,
+            item.depthmsg->height,
+            item.depthmsg->step,
+            item.depthmsg->encoding,
+            item.depthmsg->is_bigendian
+        );
+    }
+    else
+    {
+        try
+        {
+            // shares the message buffer, depth is only read downstream
+            item.depth_ptr = cv_bridge::toCvShare(input.depthmsg, input.depthmsg->encoding);
+        }
+        catch (cv_bridge::Exception& e)
+        {
+            ROS_ERROR("cv_bridge exception: %s", e.what());
+            return false;
+        }
+
+        item.depth = item.depth_ptr->image;
+        item.depth_view = vision::viewDepth(item.depth);
+    }
+
+    if(item.depth_view.empty())
+    {
+        ROS_ERROR("DEPTH NEEDS 16UC1 OR 32FC1!");
+        return false;
+    }
+
+    frame_pool.beginFrame();
+    item.display_on = input.display_on;
+    item.input_on = input.input_on;
+
+    // camera stalled, the estimator drops the track
+    item.reset = input.tick - last_request > 0.1 && frame_received;
+    last_request = input.tick;
+    frame_received = true;
+
+    return true;
+}
+
+bool alan::ledTracker::predict_ROI(double stamp, bool reset, cv::Rect& ROI)
+{
+    ledPrior prior_latest;
+    while(ring_prior.pop(prior_latest))
+        prior_front = prior_latest;
+
+    ROI = cv::Rect();
+
+    if(reset || !(prior_front.tracked || prior_front.recovering))
+        return false;
+
+    if(prior_front.tracked)
+    {
+        ROI = get_predicted_ROI(
+            extrapolate(
+                prior_front.pose,
+                prior_front.velo,
+                get_deltaT(stamp, prior_front.stamp)
+            )
+        );
+
+        return true;
+    }
+
+    // lost: the window follows the last good motion and grows with the time since
+    const double dt = stamp - prior_front.stamp;
+    if(dt < 0 || dt > recovery_timeout)
+        return false;
+
+    ROI = get_predicted_ROI(
+        extrapolate(prior_front.pose, prior_front.velo, dt),
+        recovery_radius(prior_front, dt)
+    );
+
+    if(ROI.area() <= 0 || ROI.area() > recovery_max_area * _width * _height)
+    {
+        ROI = cv::Rect();
+        return false;
+    }
+
+    return true;
+}
+
+bool alan::ledTracker::extract(const ledInput& input, ledFrame& item, const std::vector<cv::Rect>& ROIs)
+{
+    // overlapping windows are segmented once, the decoder gets their bounding box
+    ROIs_merged.assign(ROIs.begin(), ROIs.end());
+    for(int i = 0; i < (int)ROIs_merged.size(); i++)
+        for(int j = i + 1; j < (int)ROIs_merged.size(); j++)
+            if((ROIs_merged[i] & ROIs_merged[j]).area() > 0)
+            {
+                ROIs_merged[i] |= ROIs_merged[j];
+                ROIs_merged.erase(ROIs_merged.begin() + j);
+                j = i;
+            }
+
+    rect_ROI_predicted = cv::Rect();
+    for(auto& what : ROIs_merged)
+        rect_ROI_predicted = rect_ROI_predicted.area() > 0 ? rect_ROI_predicted | what : what;
+
+    if(!decode_frame(input.rgbmsg, item))
+        return false;
+
+    if(item.display_on)
+        item.display = frame_pool.copy(vision::POOL_DISPLAY, item.frame);
+
+    if(item.tracking)
+        LED_extract_POI_alter(item);
+    else
+        LED_extract_POI(item);
+
+    // a scaled frame was segmented without depth, the gate goes to the detections
+    if(depth_sparse || item.frame_scale > 1)
+        LED_depth_gate(item);
+
+    item.frame_reallocs = frame_pool.getFrameReallocs();
+    item.total_reallocs = frame_pool.getTotalReallocs();
+    item.ROI_decode_no = ROI_decode_no;
+    item.ms_front = (vision::traceNow() * 1e-9 - tick_front) * 1000;
+
+    return true;
+}
+
+void alan::ledTracker::estimate(ledFrame& item, ledReport& report)
+{
+    double tick = vision::traceNow() * 1e-9;
+
+    frame = item.frame;
+    frame_scale = item.frame_scale;
+    display = item.display;
+    frame_input = item.frame_input;
+    display_on = item.display_on;
+    input_on = item.input_on;
+    blobs_for_initialize.swap(item.blobs);
+    min_blob_size = item.min_blob_size;
+    led_pose_header = item.header;
+
+    if(item.reset)
+    {
+        LED_tracker_initiated_or_tracked = false;
+        recovering = false;
+        ROS_RED_STREAM("CAMERA STALLED, TRACKER RESET!");
+    }           
+
+    pose_to_publish = false;
+
+    // extracted for the other mode, the track changed while this frame was queued,
+    // while recovering either will do
+    if(!recovering && item.tracking != LED_tracker_initiated_or_tracked)
+        stale_no++;
+    else
+    {
+        if(LED_tracker_initiated_or_tracked)
+            pose_priori_sophus = getPosePriori(
+                get_deltaT(led_pose_header.stamp.toSec(), led_pose_header_previous.stamp.toSec())
+            );
+
+        solve_pose_w_LED(item.pts_2d_detect, item.depth_view, item.tracking);
+        led_pose_header_previous = led_pose_header;
+    }
+
+    ledPrior prior;
+    if(recovering)
+    {
+        prior = last_good;
+        prior.tracked = false;
+        prior.recovering = true;
+    }
+    else
+    {
+        prior.tracked = LED_tracker_initiated_or_tracked;
+        prior.stamp = led_pose_header.stamp.toSec();
+        prior.pose = XcurrentPosterori.X_SE3;
+        prior.velo = XcurrentPosterori.V_SE3;
+    }
+    ring_prior.push(prior);
+
+    report.header = item.header;
+    report.tick = item.tick;
+    report.tracked = LED_tracker_initiated_or_tracked;
+    report.tracker_started = tracker_started;
+    report.publish_pose = pose_to_publish;
+    report.pose = pose_global_sophus;
+    report.velo = velo_global_sophus;
+    report.cov = covariance_global_sophus;
+    report.BA_error = BA_error;
+    report.depth_avg = depth_avg_of_all;
+    report.detect_no = detect_no;
+    report.display = display;
+    report.frame_input = frame_input;
+    report.display_on = display_on;
+    report.input_on = input_on;
+    report.frame_reallocs = item.frame_reallocs;
+    report.total_reallocs = item.total_reallocs;
+    report.ROI_decode_no = item.ROI_decode_no;
+    report.stale_no = stale_no;
+    report.recover_no = recover_no;
+    report.ms_front = item.ms_front;
+    report.ms_estimate = (vision::traceNow() * 1e-9 - tick) * 1000;
+}
+
+bool alan::ledTracker::decode_frame(const sensor_msgs::CompressedImage::ConstPtr& rgbmsg, ledFrame& item)
+{
+    TRACE_SPAN(tracer, vision::TRACE_DECODE);
+
+    // ROI and scaled decode need the full-frame buffer from an earlier full decode
+    cv::Mat& color = frame_pool.get(vision::POOL_COLOR);
+    bool is_jpeg = rgbmsg->format.find("jpeg") != std::string::npos;
+
+    if(is_jpeg && !color.empty())
+    {
+        // only the predicted LED window is decoded, the rest keeps an older frame, 
+        // hence full decode whenever "/processed_image" is watched
+        if(item.tracking && ROI_decode_on && !item.display_on && rect_ROI_predicted.area() > 0)
+        {
+            cv::Rect rect_decoded = rect_ROI_predicted;
+            if(jpeg_decoder.decodeROI(rgbmsg->data, color, rect_decoded))
+            {
+                item.frame = color;
+                ROI_decode_no++;
+                return true;
+            }
+        }
+
+        // initialization detects on the scaled frame itself, 
+        // full decode while "/processed_image" is drawn in full-frame pixels
+        if(!item.tracking && init_decode_scale > 1 && !item.display_on)
+        {
+            cv::Mat& color_scaled = frame_pool.acquire(
+                vision::POOL_COLOR_SCALED,
+                cv::Size(
+                    (color.cols + init_decode_scale - 1) / init_decode_scale,
+                    (color.rows + init_decode_scale - 1) / init_decode_scale
+                ),
+                CV_8UC3
+            );
+
+            if(jpeg_decoder.decodeScaled(rgbmsg->data, color_scaled, init_decode_scale))
+            {
+                item.frame = color_scaled;
+                item.frame_scale = init_decode_scale;
+                return true;
+            }
+        }
+    }
+
+    // fallback, full frame
+    try
+    {
+        item.frame = frame_pool.decode(vision::POOL_COLOR, rgbmsg->data, cv::IMREAD_COLOR);
+    }
+    catch (cv::Exception& e)
+    {
+        ROS_ERROR("imdecode exception: %s", e.what());
+        return false;
+    }
+
+    if(item.frame.empty())
+    {
+        ROS_ERROR("imdecode failed!");
+        return false;
+    }
+
+    return true;
+}
+
+void alan::ledTracker::solve_pose_w_LED(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth, bool windowed)
+{    
+    if(!LED_tracker_initiated_or_tracked && recovering)
+    {
+        LED_tracker_initiated_or_tracked = relocalize(pts_2d_detect);
+
+        if(LED_tracker_initiated_or_tracked)
+        {
+            ROS_GREEN_STREAM("TRACKER RECOVERED!");
+            recover_no++;
+            recovering = false;
+            pose_to_publish = true;
+            keep_last_good();
+            return;
+        }
+
+        if(led_pose_header.stamp.toSec() - last_good.stamp > recovery_timeout)
+        {
+            recovering = false;
+            ROS_RED_STREAM("RECOVERY TIMED OUT");
+        }
+
+        // window detections only, initialization needs the full frame
+        if(windowed)
+        {
+            ROS_CYAN_STREAM("RECOVERING...");
+            return;
+        }
+    }
+
+    if(!LED_tracker_initiated_or_tracked)        
+    {
+        LED_tracker_initiated_or_tracked = initialization(pts_2d_detect, depth);
+        // try to initialize here...
+
+        if(LED_tracker_initiated_or_tracked)
+        {
+            printf("\n");
+            ROS_GREEN_STREAM("TRACKER INITIALIZED!");
+            ROS_GREEN_STREAM("SHOULD BE FINE...HOPEFULLY?\n");
+            tracker_started = true;
+
+            if(BA_error > LED_no * 2)
+            {
+                ROS_WARN("REPROJECTION_ERROR OVER @ INITIALIZATION %d", LED_no * 2);          
+            }                    
+
+            if(!kf_initiated)
+            {
+                kf_initiated = true;
+                apiKF(kfINITIATE);                
+            }
+            else
+                apiKF(kfREINITIATE);            
+            
+            pose_to_publish = true;
+            recovering = false;
+            keep_last_good();
+        }
+        else
+        {
+            ROS_CYAN_STREAM("WAITING FOR INITIALIZATION...");
+        }
+    }
+    else
+    {
+        recursive_filtering(pts_2d_detect, depth);
+
+        if(!LED_tracker_initiated_or_tracked)
+        {
+            ROS_RED_STREAM("TRACKER FAIL");
+            recovering = recovery_timeout > 0;
+        }
+        else
+        {
+            pose_to_publish = true;
+            keep_last_good();
+        }
+    }
+
+}
+
+void alan::ledTracker::apiKF(int DOKF)
+{
+    switch (DOKF)
+    {
+    case kfINITIATE:
+        initKF(pose_global_sophus);
+
+        pose_global_sophus = XcurrentPosterori.X_SE3;
+        velo_global_sophus = XcurrentPosterori.V_SE3;
+        covariance_global_sophus = XcurrentPosterori.PCov;
+        break;
+    
+    case kfREINITIATE:
+        reinitKF(pose_global_sophus);
+
+        pose_global_sophus = XcurrentPosterori.X_SE3;
+        velo_global_sophus = XcurrentPosterori.V_SE3;
+        covariance_global_sophus = XcurrentPosterori.PCov;
+        break;
+
+    case kfNORMALKF:
+        run_AIEKF(
+            led_pose_header.stamp.toSec() - led_pose_header_previous.stamp.toSec(),
+            pts_on_body_frame_in_corres_order, 
+            pts_detected_in_corres_order
+        );
+
+        pose_global_sophus = XcurrentPosterori.X_SE3;
+        velo_global_sophus = XcurrentPosterori.V_SE3;
+        covariance_global_sophus = XcurrentPosterori.PCov;
+
+        break;
+    
+    default:
+        // pc::pattyDebug();
+        break;
+    }
+}
+
+void alan::ledTracker::recursive_filtering(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth)
+{
+    detect_no = pts_2d_detect.size();
+
+    if(detect_no < 3)
+    {
+        // std::cout<<i<<std::endl;
+        LED_tracker_initiated_or_tracked = false;
+        return;
+    }
+
+    get_correspondence(pts_2d_detect);
+    pointcloud_generate(pts_2d_detect, depth);
+    detect_no = pts_detected_in_corres_order.size();
+
+    if(detect_no < 3)
+    {
+        // std::cout<<i<<std::endl;
+        LED_tracker_initiated_or_tracked = false;
+        // cv::imwrite("/home/patty/alan_ws/kmeans_less3_" + std::to_string(detect_no) + "_"+ std::to_string(i) + ".jpg", frame_input);
+        // i++;
+        return;
+    }
+
+    apiKF(kfNORMALKF);
+
+    BA_error = get_reprojection_error(
+        pts_on_body_frame_in_corres_order,
+        pts_detected_in_corres_order,
+        pose_global_sophus,
+        true
+    );
+
+    if(BA_error > 4 * LED_no)
+    {
+        LED_tracker_initiated_or_tracked = false;
+        // cv::imwrite("/home/patty/alan_ws/BA" + std::to_string(BA_error) + ".jpg", frame_input);
+    }
+}
+
+void alan::ledTracker::get_correspondence(
+    std::vector<Eigen::Vector2d>& pts_2d_detected
+)
+{
+    TRACE_SPAN(tracer, vision::TRACE_CORRES);
+
+    led_assigner.begin(LED_no);
+
+    if(BA_error < 5.0)
+    {
+        // gate on the predicted reprojection covariance of the filter
+        Eigen::Matrix<double, 6, 6> P_pose = 
+            XcurrentPosterori.PCov.topLeftCorner<6,6>() 
+            + Q_init.topLeftCorner<6,6>();
+        Eigen::Matrix3d K = cameraMat;
+
+        for(int i = 0; i < LED_no; i++)
+            led_assigner.predict(
+                i, 
+                pose_priori_sophus, 
+                P_pose, 
+                pts_on_body_frame[i], 
+                K
+            );
+    }
+    else
+    {
+        ROS_WARN("use previous detection 2D");
+
+        Eigen::Matrix2d S = Eigen::Matrix2d::Identity() * led_assigner.fallback_px * led_assigner.fallback_px;
+
+        for(int i = 0; i < LED_no; i++)
+            led_assigner.setPrediction(
+                i, 
+                std::get<1>(corres_global_previous)[i].pts_2d_correspond, 
+                S
+            );
+
+        // cv::imwrite("/home/patty/alan_ws/lala" + std::to_string(i) + ".jpg", frame_input);
+        // pc::pattyDebug("check check");
+    }
+
+    // all LEDs in sight, take out the common image motion first
+    led_assigner.assign(
+        pts_2d_detected, 
+        pts_2d_detected.size() == LED_no && std::get<0>(corres_global_previous) == LED_no
+    );
+
+    if(input_on)
+    {
+        for(auto& what : pts_2d_detected)
+            cv::circle(frame_input, cv::Point(what(0), what(1)), 2.5, CV_RGB(0,255,0), -1);
+
+        for(int i = 0; i < LED_no; i++)
+        {
+            Eigen::Vector2d predicted = led_assigner.getPrediction(i);
+            cv::circle(frame_input, cv::Point(predicted(0), predicted(1)), 1.0, CV_RGB(0,0,255), -1);
+        }
+    }
+
+    for(int i = 0; i < LED_no; i++)
+    {
+        correspondence::matchid& corres = std::get<1>(corres_global_current)[i];
+
+        corres.confidence = led_assigner.confidence[i];
+
+        if(led_assigner.match[i] < 0)
+            continue;
+
+        corres.detected_indices = led_assigner.match[i];
+        corres.detected_ornot = true;
+        corres.pts_2d_correspond = pts_2d_detected[led_assigner.match[i]];
+    }
+
+    corres_global_previous = corres_global_current;
+    
+    pts_on_body_frame_in_corres_order.clear();
+    pts_detected_in_corres_order.clear(); 
+
+    for(int i = 0; i < std::get<1>(corres_global_current).size(); i++)
+    {            
+        if(std::get<1>(corres_global_current)[i].detected_ornot)
+        {  
+            pts_detected_in_corres_order.push_back(
+                std::get<1>(corres_global_current)[i].pts_2d_correspond
+            );             
+            pts_on_body_frame_in_corres_order.push_back(pts_on_body_frame[i]);
+            std::get<1>(corres_global_current)[i].detected_ornot = false; 
+            // reset for next time step
+        }        
+    }
+
+    i++;        
+}
+
+void alan::ledTracker::solve_pnp_initial_pose(std::vector<Eigen::Vector2d> pts_2d, std::vector<Eigen::Vector3d> pts_3d)
+{
+    Eigen::Matrix3d R;
+    Eigen::Vector3d t;
+
+    cv::Mat distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
+    // distCoeffs.at<double>(0) = -0.056986890733242035;
+    // distCoeffs.at<double>(1) = 0.06356718391180038;
+    // distCoeffs.at<double>(2) = -0.0012483829632401466;
+    // distCoeffs.at<double>(3) = -0.00018130485841538757;
+    // distCoeffs.at<double>(4) = -0.019809694960713387;
+
+    cv::Mat no_ro_rmat = cv::Mat::eye(3,3,CV_64F);
+    
+    cv::Vec3d rvec, tvec;
+    // cv::Rodrigues(no_ro_rmat, rvec);
+
+    cv::Mat camMat = cv::Mat::eye(3,3,CV_64F);
+    std::vector<cv::Point3f> pts_3d_;
+    std::vector<cv::Point2f> pts_2d_;
+
+    cv::Point3f temp3d;
+    cv::Point2f temp2d;
+
+    for(auto what : pts_3d)
+    {
+        temp3d.x = what(0);
+        temp3d.y = what(1);
+        temp3d.z = what(2);
+
+        pts_3d_.push_back(temp3d);
+    }
+
+    for(auto what : pts_2d)
+    {
+        temp2d.x = what(0);
+        temp2d.y = what(1);    
+
+        pts_2d_.push_back(temp2d);
+    }
+
+    camMat.at<double>(0,0) = cameraMat(0,0);
+    camMat.at<double>(0,2) = cameraMat(0,2);
+    camMat.at<double>(1,1) = cameraMat(1,1);
+    camMat.at<double>(1,2) = cameraMat(1,2);
+
+    // either one
+    // cv::solvePnP(pts_3d_, pts_2d_ ,camMat, distCoeffs, rvec, tvec, cv::SOLVEPNP_EPNP);
+    cv::solvePnP(pts_3d_, pts_2d_ ,camMat, distCoeffs, rvec, tvec, cv::SOLVEPNP_ITERATIVE);
+    
+    //opt pnp algorithm
+    //, cv::SOLVEPNP_EPNP
+    //, cv::SOLVEPNP_IPPE
+    //, cv::SOLVEPNP_P3P
+
+    //return values
+    cv::Mat rmat = cv::Mat::eye(3,3,CV_64F);
+    cv::Rodrigues(rvec, rmat);
+
+    R <<
+        rmat.at<double>(0,0), rmat.at<double>(0,1), rmat.at<double>(0,2),
+        rmat.at<double>(1,0), rmat.at<double>(1,1), rmat.at<double>(1,2),
+        rmat.at<double>(2,0), rmat.at<double>(2,1), rmat.at<double>(2,2);
+
+    Eigen::Matrix3d reverse_mat;
+    reverse_mat <<
+            1.0000000,  0.0000000,  0.0000000,
+            0.0000000, -1.0000000, -0.0000000,
+            0.0000000,  0.0000000, -1.0000000;
+
+    
+
+    t =  Eigen::Vector3d(
+          tvec(0),
+          tvec(1),
+          tvec(2)  
+        );
+
+    if(tvec(2) < 0) //sometimes opencv yeilds reversed results, flip it 
+    {
+        R = R * reverse_mat;
+        t = (-1) * t;
+    }
+
+    pose_epnp_sophus = Sophus::SE3d(R, t);
+    
+    // pose_depth_sophus = Sophus::SE3d(R, t);
+
+    // if(LED_tracker_initiated_or_tracked)
+    // {
+    //     // cout<<"depth"<<endl;
+    //     t = led_3d_posi_in_camera_frame_depth;
+    //     pose_depth_sophus = Sophus::SE3d(R, t);
+    // }
+
+}
+
+/* ================ POI Extraction utilities function below ================ */
+void alan::ledTracker::LED_extract_POI(ledFrame& item)
+{   
+    TRACE_SPAN(tracer, vision::TRACE_SEGMENT);
+
+    cv::Mat& frame = item.frame;
+    item.pts_2d_detect.clear();
+    item.blobs.clear();
+
+    // one pass: depth gate, brightness gate, frame stays in colour;
+    // a scaled frame has no depth of its size, see LED_depth_gate
+    cv::Mat& gray = frame_pool.acquire(vision::POOL_GRAY, frame.size(), CV_8U);
+
+    if(
+        !vision::segmentLED(
+            frame, 
+            item.frame_scale > 1 ? cv::Mat() : item.depth, 
+            cv::Rect(0, 0, frame.cols, frame.rows),
+            vision::setSegParam(LANDING_DISTANCE, BINARY_THRES, true),
+            gray,
+            seg_runs
+        )
+    )
+    {
+        ROS_ERROR("LED SEGMENTATION NEEDS BGR8 + 16UC1 OF SAME SIZE!");
+        return;
+    }
+
+    blob_extractor.extract(seg_runs, frame, item.blobs);
+
+    item.min_blob_size = INFINITY;
+
+    for(auto& what : item.blobs)
+    {
+        if(item.frame_scale > 1)
+            what = vision::upscaleBlob(what, item.frame_scale);
+
+        item.min_blob_size =(what.size < item.min_blob_size ? what.size : item.min_blob_size);
+        item.pts_2d_detect.push_back(Eigen::Vector2d(what.x, what.y));
+    }
+}
+
+void alan::ledTracker::LED_extract_POI_alter(ledFrame& item)
+{   
+    TRACE_SPAN(tracer, vision::TRACE_SEGMENT);
+
+    cv::Mat& frame = item.frame;
+    std::vector<Eigen::Vector2d>& pts_2d_detected = item.pts_2d_detect;
+    pts_2d_detected.clear();
+    item.blobs.clear();
+
+    if(item.input_on)
+    {
+        item.frame_input = frame_pool.acquire(vision::POOL_INPUT, frame.size(), CV_8UC3);
+        item.frame_input.setTo(0);
+    }
+
+    // same windows the decoder was given, 
+    // only those are gated, and far depth only (zeros kept)
+    const cv::Rect rect_frame(0, 0, frame.cols, frame.rows);
+    const cv::Rect rect_bound = rect_ROI_predicted & rect_frame;
+
+    if(rect_bound.area() <= 0)
+        return;
+
+    // one mask over the bounding box, each window segments into its part of it;
+    // the buffer is frame sized, as the box changes size on almost every frame
+    cv::Mat mask_bound = frame_pool.acquire(vision::POOL_ROI, frame.size(), CV_8U)(rect_bound);
+
+    for(auto& what : ROIs_merged)
+    {
+        cv::Rect rect_ROI = what & rect_frame;
+
+        if(rect_ROI.area() <= 0)
+            continue;
+
+        cv::Mat final_ROI = mask_bound(rect_ROI - rect_bound.tl());
+
+        if(
+            !vision::segmentLED(
+                frame, 
+                item.depth, 
+                rect_ROI,
+                vision::setSegParam(LANDING_DISTANCE, BINARY_THRES, false),
+                final_ROI,
+                seg_runs
+            )
+        )
+        {
+            ROS_ERROR("LED SEGMENTATION NEEDS BGR8 + 16UC1 OF SAME SIZE!");
+            return;
+        }
+
+        blob_extractor.extract(seg_runs, frame, blobs_ROI);
+        item.blobs.insert(item.blobs.end(), blobs_ROI.begin(), blobs_ROI.end());
+
+        if(item.input_on)
+            cv::cvtColor(final_ROI, item.frame_input(rect_ROI), cv::COLOR_GRAY2BGR);
+    }
+
+    if(item.input_on)
+        for(auto& what : item.blobs)
+            cv::circle(
+                item.frame_input, 
+                cv::Point(what.x, what.y), 
+                what.size / 2 + 2, 
+                CV_RGB(255,0,0)
+            );
+
+    for(auto& what : item.blobs)
+        pts_2d_detected.emplace_back(Eigen::Vector2d(what.x, what.y));
+
+    // several windows are several targets, see ledMultiTracker
+    if(ROIs_merged.size() == 1 && (int)pts_2d_detected.size() > LED_no)
+        ROS_WARN("LED_No over detection!!!!");
+}
+
+std::vector<Eigen::Vector3d> alan::ledTracker::pointcloud_generate(
+    const std::vector<Eigen::Vector2d>& pts_2d_detected, 
+    const vision::depthView& depth
+)
+{
+    TRACE_SPAN(tracer, vision::TRACE_DEPTH);
+
+    // LEDs without a depth return come back as (0, 0, 0)
+    std::vector<Eigen::Vector3d> pointclouds;
+    const int depth_no = depth_sampler.backproject(depth, pts_2d_detected, pointclouds);
+
+    depth_avg_of_all = 0;
+    for(auto& what : pointclouds)
+        depth_avg_of_all = depth_avg_of_all + what.z();
+
+    if(depth_no > 0)
+        depth_avg_of_all = depth_avg_of_all / depth_no;
+
+    return pointclouds;
+}
+
+void alan::ledTracker::LED_depth_gate(ledFrame& item)
+{
+    /* segmentLED() ran without depth, so its per-pixel gate is applied
+    to the detections instead: beyond LANDING_DISTANCE is dropped, and
+    so is no return at all while initializing. blobs stay in step. */
+    TRACE_SPAN(tracer, vision::TRACE_DEPTH);
+
+    int kept = 0, valid;
+
+    for(int i = 0; i < (int)item.pts_2d_detect.size(); i++)
+    {
+        const double z = depth_sampler.sample(
+            item.depth_view, 
+            item.pts_2d_detect[i].x(), 
+            item.pts_2d_detect[i].y(), 
+            valid
+        );
+
+        if(z > LANDING_DISTANCE || (!item.tracking && valid == 0))
+            continue;
+
+        item.pts_2d_detect[kept] = item.pts_2d_detect[i];
+        item.blobs[kept] = item.blobs[i];
+        kept++;
+    }
+
+    item.pts_2d_detect.resize(kept);
+    item.blobs.resize(kept);
+}
+
+
+cv::Rect alan::ledTracker::get_predicted_ROI(const Sophus::SE3d& pose_priori, double margin)
+{
+    Eigen::MatrixXd reproject_2d_pts_matrix;
+    reproject_2d_pts_matrix.resize(LED_no, 2);
+    double z_min = INFINITY;
+
+    for(int i = 0; i < LED_no; i++)
+    {
+        const double z = (pose_priori * pts_on_body_frame[i]).z();
+        if(z <= 0)
+            return cv::Rect();
+
+        z_min = std::min(z_min, z);
+
+        reproject_2d_pts_matrix.block<1,2>(i, 0) = reproject_3D_2D(
+            pts_on_body_frame[i],
+            pose_priori
+        );
+    }
+
+    Eigen::Vector2d minXY = reproject_2d_pts_matrix.colwise().minCoeff();
+    Eigen::Vector2d maxXY = reproject_2d_pts_matrix.colwise().maxCoeff();
+    Eigen::Vector2d deltaXY = maxXY - minXY;
+
+    // margin (m) seen at the nearest LED
+    const Eigen::Vector2d margin_px(
+        cameraMat(0,0) * margin / z_min,
+        cameraMat(1,1) * margin / z_min
+    );
+
+    minXY = minXY - deltaXY / 2 - margin_px;
+    maxXY = maxXY + deltaXY / 2 + margin_px;
+
+    if(!minXY.allFinite() || !maxXY.allFinite())
+        return cv::Rect();
+
+    cv::Rect rect_ROI(
+        cv::Point2i(minXY.x(), minXY.y()), 
+        cv::Point2i(maxXY.x(), maxXY.y())
+    );
+
+    return rect_ROI & cv::Rect(0, 0, _width, _height);
+}
+
+/* ================ Recovery utilities function below ================ */
+
+void alan::ledTracker::keep_last_good()
+{
+    const auto& P = XcurrentPosterori.PCov;
+
+    last_good.tracked = true;
+    last_good.stamp = led_pose_header.stamp.toSec();
+    last_good.pose = XcurrentPosterori.X_SE3;
+    last_good.velo = XcurrentPosterori.V_SE3;
+    last_good.sigma_p = std::sqrt(P.block<3,3>(0,0).trace() / 3);
+    last_good.sigma_v = std::sqrt(P.block<3,3>(6,6).trace() / 3);
+    P_last_good = P.topLeftCorner<6,6>();
+}
+
+bool alan::ledTracker::relocalize(std::vector<Eigen::Vector2d>& pts_2d_detect)
+{
+    /* the last good posterior carried forward by its velocity, the filter's
+    pose covariance widened by the recovery radius. the gated assignment is
+    the tracking one, 3 matched LEDs are enough to refine from such a prior,
+    no permutation search and no colour check. */
+    TRACE_SPAN(tracer, vision::TRACE_CORRES);
+
+    detect_no = pts_2d_detect.size();
+    if(detect_no < 3)
+        return false;
+
+    const double dt = led_pose_header.stamp.toSec() - last_good.stamp;
+    const double radius = recovery_radius(last_good, dt);
+    const Sophus::SE3d pose_predicted = extrapolate(last_good.pose, last_good.velo, dt);
+
+    Eigen::Matrix<double, 6, 6> P_pose = P_last_good;
+    P_pose.topLeftCorner<3,3>() += Eigen::Matrix3d::Identity() * radius * radius;
+    const Eigen::Matrix3d K = cameraMat;
+
+    led_assigner.begin(LED_no);
+    for(int i = 0; i < LED_no; i++)
+        led_assigner.predict(i, pose_predicted, P_pose, pts_on_body_frame[i], K);
+
+    led_assigner.assign(pts_2d_detect, false);
+
+    pts_on_body_frame_in_corres_order.clear();
+    pts_detected_in_corres_order.clear();
+
+    for(int i = 0; i < LED_no; i++)
+        if(led_assigner.match[i] >= 0)
+        {
+            pts_on_body_frame_in_corres_order.push_back(pts_on_body_frame[i]);
+            pts_detected_in_corres_order.push_back(pts_2d_detect[led_assigner.match[i]]);
+        }
+
+    const int matched_no = pts_detected_in_corres_order.size();
+    if(matched_no < 3)
+        return false;
+
+    Sophus::SE3d pose = pose_predicted;
+    double error = 0;
+
+    const vision::refineResult result = camOptimize(
+        pose, 
+        pts_on_body_frame_in_corres_order, 
+        pts_detected_in_corres_order, 
+        error
+    );
+
+    // same per-LED bound as initialization, and no further than the window allowed
+    if(
+        result.status == vision::REFINE_DIVERGED 
+        || result.status == vision::REFINE_DEGENERATE
+        || error > matched_no * 2
+        || (pose.translation() - pose_predicted.translation()).norm() > radius
+    )
+        return false;
+
+    pose_global_sophus = pose;
+    BA_error = get_reprojection_error(
+        pts_on_body_frame_in_corres_order,
+        pts_detected_in_corres_order,
+        pose_global_sophus,
+        true
+    );
+    detect_no = matched_no;
+
+    // previous detections for the next association, reprojected where none was seen
+    std::vector<correspondence::matchid>& corres = std::get<1>(corres_global_current);
+    corres.resize(LED_no);
+
+    for(int i = 0; i < LED_no; i++)
+    {
+        corres[i].detected_ornot = false;
+        corres[i].detected_indices = led_assigner.match[i];
+        corres[i].pts_2d_correspond = led_assigner.match[i] >= 0 
+            ? pts_2d_detect[led_assigner.match[i]] 
+            : reproject_3D_2D(pts_on_body_frame[i], pose_global_sophus);
+    }
+
+    std::get<0>(corres_global_current) = detect_no;
+    corres_global_previous = corres_global_current;
+
+    // keeps the velocity it was lost with
+    reinitKF(pose_global_sophus, last_good.velo);
+
+    pose_global_sophus = XcurrentPosterori.X_SE3;
+    velo_global_sophus = XcurrentPosterori.V_SE3;
+    covariance_global_sophus = XcurrentPosterori.PCov;
+
+    return true;
+}
+
+/* ================ Init. utilities function below ================ */
+
+bool alan::ledTracker::initialization(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth)
+{
+    std::get<1>(corres_global_current).clear();
+
+    std::vector<Eigen::Vector3d> pts_3d_pcl_detect = pointcloud_generate(pts_2d_detect, depth);
+
+    //after above, I got:
+    //pointcloud in {c}
+    std::vector<double> norm_of_x_points, norm_of_y_points, norm_of_z_points;
+
+    for(auto what :  pts_3d_pcl_detect)
+    {
+        norm_of_x_points.push_back(what.x());
+        norm_of_y_points.push_back(what.y());
+        norm_of_z_points.push_back(what.z());
+    }
+
+    // cout<<pts_3d_pcl_detect.size()<<endl;
+    // cout<<LED_no<<endl;
+
+    if(pts_3d_pcl_detect.size() == LED_no  //we got LED_no
+        && calculate_MAD(norm_of_x_points) < MAD_x_threshold //no outlier
+        && calculate_MAD(norm_of_y_points) < MAD_y_threshold 
+        && calculate_MAD(norm_of_z_points) < MAD_z_threshold) 
+    {
+        Sophus::SE3d pose;
+
+        //colour feature, read per blob from the bgr frame
+        std::vector<int> corres_g;
+        std::vector<int> corres_r;
+
+        colours.resize(blobs_for_initialize.size());
+        for(int i = 0 ; i < blobs_for_initialize.size(); i++)
+        {
+            colours[i] = colour_classifier.classify(
+                frame, 
+                frame_scale > 1 ? vision::downscaleBlob(blobs_for_initialize[i], frame_scale) : blobs_for_initialize[i]
+            );
+
+            if(colours[i].colour == vision::LED_COLOUR_GREEN)
+                corres_g.push_back(i);
+            else   
+                corres_r.push_back(i);
+        }
+
+        if(corres_g.size() != LED_g_no || corres_r.size() != LED_r_no)
+        {
+            // miscounted: the greenest LED_g_no are green, if only unsure blobs change sides
+            colour_order.resize(colours.size());
+            for(int i = 0; i < (int)colour_order.size(); i++)
+                colour_order[i] = i;
+
+            auto greenness = [this](int i)
+            {
+                const int total = colours[i].green_no + colours[i].red_no;
+                return total > 0 ? (colours[i].green_no - colours[i].red_no) / (double)total : 0.0;
+            };
+
+            std::stable_sort(colour_order.begin(), colour_order.end(), 
+                [&](int a, int b){return greenness(a) > greenness(b);});
+
+            corres_g.clear();
+            corres_r.clear();
+
+            for(int k = 0; k < (int)colour_order.size(); k++)
+            {
+                const int i = colour_order[k];
+                const vision::ledColourClass colour = k < LED_g_no ? vision::LED_COLOUR_GREEN : vision::LED_COLOUR_RED;
+
+                if(
+                    colour != colours[i].colour 
+                    && colours[i].colour != vision::LED_COLOUR_NONE 
+                    && colours[i].confidence >= colour_flip_conf
+                )
+                    return false;
+
+                (colour == vision::LED_COLOUR_GREEN ? corres_g : corres_r).push_back(i);
+            }
+
+            std::sort(corres_g.begin(), corres_g.end());
+            std::sort(corres_r.begin(), corres_r.end());
+
+            if(corres_g.size() != LED_g_no || corres_r.size() != LED_r_no)
+                return false;
+        }
+
+        std::vector<int> final_corres;
+        double error_total = INFINITY;
+
+        Eigen::Matrix3d R;
+        Eigen::Vector3d t;
+        bool matched;
+
+        {
+            TRACE_SPAN(tracer, vision::TRACE_CORRES);
+            matched = constellation_matcher.match(
+                pts_2d_detect, 
+                pts_3d_pcl_detect, 
+                corres_g, 
+                corres_r, 
+                final_corres, 
+                error_total, 
+                R, 
+                t,
+                &match_stats
+            );
+        }
+
+        if(!matched)
+            return false;
+
+        pose_global_sophus = Sophus::SE3d(R, t);
+
+        BA_error = error_total;
+
+        if(BA_error > LED_no * 2)
+        {
+            ROS_WARN("HELLO?");
+            return false;
+        }
+
+        correspondence::matchid corres_temp;
+        
+        pts_2d_detect_correct_order.clear();
+        
+        for(auto what : final_corres)
+        {
+            corres_temp.detected_indices = what;
+            corres_temp.detected_ornot = true;
+            corres_temp.pts_3d_correspond = pts_3d_pcl_detect[what];            
+            corres_temp.pts_2d_correspond = pts_2d_detect[what];
+
+            pts_2d_detect_correct_order.push_back(pts_2d_detect[what]); 
+
+            std::get<1>(corres_global_current).push_back(corres_temp);
+        }
+
+        if(std::get<1>(corres_global_current).size() != LED_no)
+        {
+            ROS_RED_STREAM("PLEASE DEBUG");
+
+        }
+
+        const vision::refineResult BA_result = camOptimize(
+            pose_global_sophus, 
+            pts_on_body_frame, 
+            pts_2d_detect_correct_order,
+            BA_error
+        );
+
+        if(BA_result.status == vision::REFINE_DIVERGED || BA_result.status == vision::REFINE_DEGENERATE)
+        {
+            ROS_WARN("INITIAL BA FAILED");
+            return false;
+        }
+
+        detect_no = LED_no;
+        std::get<0>(corres_global_current) = detect_no;
+        corres_global_previous = corres_global_current;
+
+        return true;
+    }
+    else
+        return false;
+}
+
+inline double alan::ledTracker::calculate_MAD(std::vector<double> norm_of_points)
+{
+    int n = norm_of_points.size();
+    double mean = 0, delta_sum = 0, MAD;
+    if(n != 0)
+    {
+        mean = accumulate(norm_of_points.begin(), norm_of_points.end(), 0.0) / n;
+        for(int i = 0; i < n; i++)
+            delta_sum = delta_sum + abs(norm_of_points[i] - mean);        
+        MAD = delta_sum / n;
+    }   
+
+    return MAD;
+}
+
+/* ================ Outlier Rejection utilities function below ================ */
+    /* in outlier rejection, we first calculate the MAD (mean average deviation)
+    to see whether there exists some outlier or not.
+    then, we try to do clustering with k-means algorithm.
+    as we are processing 3D points, at most time, 
+    the LED blobs should be close enough, 
+    while others being at some other coordinates that are pretty far away
+    hence, we set the clustering no. as 2.
+    we then calcullate the distance between the centroid of the cluster to the
+    center at previous time step(pcl_center_point_wo_outlier_previous)
+    and determine which cluster is the one that we want */
+
+void alan::ledTracker::reject_outlier(std::vector<Eigen::Vector2d>& pts_2d_detect, const vision::depthView& depth)
+{
+    std::vector<Eigen::Vector3d> pts_3d_detect = pointcloud_generate(pts_2d_detect, depth);
+    //what is this for?
+    //to get 3d coordinates in body frame, so that 
+    //outlier rejection could be performed
+    int n = pts_3d_detect.size();
+
+    std::vector<cv::Point3f> pts;
+    std::vector<double> norm_of_x_points;
+    std::vector<double> norm_of_y_points;
+    std::vector<double> norm_of_z_points;
+
+    for(auto what :  pts_3d_detect)
+    {
+        norm_of_x_points.push_back(what.x());
+        norm_of_y_points.push_back(what.y());
+        norm_of_z_points.push_back(what.z());
+
+        pts.push_back(cv::Point3f(what.x(), what.y(), what.z()));
+    }
+
+    cv::Mat labels;
+    std::vector<cv::Point3f> centers;
+
+    
+    if(calculate_MAD(norm_of_x_points) > MAD_x_threshold  
+        || calculate_MAD(norm_of_y_points) > MAD_y_threshold
+        || calculate_MAD(norm_of_z_points) > MAD_z_threshold)
+    {   
+        ROS_WARN("GOT SOME REJECTION TO DO!");
+        // cout<<"got some rejection to do"<<endl;
+        cv::kmeans(pts, 2, labels, cv::TermCriteria(CV_TERMCRIT_EPS + CV_TERMCRIT_ITER, 10, 1), 8, cv::KMEANS_PP_CENTERS, centers);
+
+        double d0 = cv::norm(pcl_center_point_wo_outlier_previous - centers[0]);
+        double d1 = cv::norm(pcl_center_point_wo_outlier_previous - centers[1]);
+
+        std::vector<Eigen::Vector2d> pts_2d_result;
+        std::vector<Eigen::Vector3d> pts_3d_result;
+
+        if(d0 < d1) //then get index with 0
+        {           
+            for(int i = 0; i < labels.rows; i++)
+            {
+                if(labels.at<int>(0,i) == 0)
+                {
+                    pts_2d_result.push_back(pts_2d_detect[i]);
+                    pts_3d_result.push_back(pts_3d_detect[i]); 
+                }                    
+            }            
+            pcl_center_point_wo_outlier_previous = centers[0];
+        }
+        else
+        {
+            for(int i = 0; i < labels.rows; i++)
+            {
+
+                if(labels.at<int>(0,i) == 1)
+                {                    
+                    pts_2d_result.push_back(pts_2d_detect[i]);
+                    pts_3d_result.push_back(pts_3d_detect[i]);                    
+                }
+            }
+            pcl_center_point_wo_outlier_previous = centers[1];
+        }
+            
+        pts_2d_detect.clear();
+        pts_2d_detect = pts_2d_result;
+
+        pts_3d_detect.clear();
+        pts_3d_detect = pts_3d_result;
+
+    }
+    else
+    {
+        cv::Mat temp;
+        
+        cv::reduce(pts, temp, 01, CV_REDUCE_AVG);
+        pcl_center_point_wo_outlier_previous = cv::Point3f(temp.at<float>(0,0), temp.at<float>(0,1), temp.at<float>(0,2));
+
+    }
+
+    led_3d_posi_in_camera_frame_depth = Eigen::Vector3d(
+        pcl_center_point_wo_outlier_previous.x,
+        pcl_center_point_wo_outlier_previous.y,
+        pcl_center_point_wo_outlier_previous.z
+    );
+}
+
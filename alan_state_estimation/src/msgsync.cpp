@@ -27,9 +27,43 @@
 
 void alan::MsgSyncNodelet::led_odom_callback(const nav_msgs::Odometry::ConstPtr& odom)
 {
+    std::lock_guard<std::mutex> lock(uav_state_mutex);
+
     led_odom = *odom;
     led_odom_inititated = true;
 
+    bool imu_drives = false;
+
+    if(imu_propagation_on)
+    {
+        // the fix is one processing delay old, the IMU since its camera stamp is replayed
+        uav_propagator.correct(
+            led_odom.header.stamp.toSec(),
+            Eigen::Vector3d(
+                led_odom.pose.pose.position.x,
+                led_odom.pose.pose.position.y,
+                led_odom.pose.pose.position.z
+            ),
+            Eigen::Vector3d(
+                led_odom.twist.twist.linear.x,
+                led_odom.twist.twist.linear.y,
+                led_odom.twist.twist.linear.z
+            ),
+            Eigen::Quaterniond(
+                led_odom.pose.pose.orientation.w,
+                led_odom.pose.pose.orientation.x,
+                led_odom.pose.pose.orientation.y,
+                led_odom.pose.pose.orientation.z
+            )
+        );
+
+        // a live IMU publishes from uav_imu_callback, else the fix goes out as before
+        imu_drives = ros::Time::now().toSec() - uav_imu_last_arrival < uav_propagator.max_gap;
+    }
+
+    if(imu_drives)
+        return;
+
 
     if(!failsafe_on)
     //if no failsafe,
@@ -85,6 +119,8 @@ void alan::MsgSyncNodelet::led_odom_callback(const nav_msgs::Odometry::ConstPtr&
 
 void alan::MsgSyncNodelet::uav_vrpn_pose_callback(const geometry_msgs::PoseStamped::ConstPtr& pose)
 {
+    std::lock_guard<std::mutex> lock(uav_state_mutex);
+
     uav_vrpn_pose = *pose;
     uav_vrpn_pose_initiated = true;
 
@@ -258,18 +294,93 @@ void alan::MsgSyncNodelet::uav_vrpn_pose_callback(const geometry_msgs::PoseStamp
 
 void alan::MsgSyncNodelet::uav_vrpn_twist_callback(const geometry_msgs::TwistStamped::ConstPtr& twist)
 {
+    std::lock_guard<std::mutex> lock(uav_state_mutex);
+
     uav_vrpn_twist = *twist;
     uav_vrpn_twist_initiated = true;
 }
 
 void alan::MsgSyncNodelet::uav_imu_callback(const sensor_msgs::Imu::ConstPtr& imu)
 {
+    std::lock_guard<std::mutex> lock(uav_state_mutex);
+
     uav_imu = *imu;
     uav_acc_body(0) = uav_imu.linear_acceleration.x; 
     uav_acc_body(1) = uav_imu.linear_acceleration.y;
     uav_acc_body(2) = uav_imu.linear_acceleration.z;
 
     uav_imu_initiated = true;
+
+    if(!imu_propagation_on)
+        return;
+
+    kf::imuSample sample;
+    sample.t = uav_imu.header.stamp.toSec();
+    sample.acc = uav_acc_body;
+    sample.gyro = Eigen::Vector3d(
+        uav_imu.angular_velocity.x,
+        uav_imu.angular_velocity.y,
+        uav_imu.angular_velocity.z
+    );
+
+    uav_imu_last_arrival = ros::Time::now().toSec();
+
+    // the vrpn failsafe keeps its own rate
+    if(uav_propagator.addImu(sample) && uav_propagator.isFresh() && !failsafe_on)
+        uav_propagation_publish(uav_imu.header.stamp);
+}
+
+void alan::MsgSyncNodelet::uav_propagation_publish(const ros::Time& stamp)
+{
+    const kf::imuState& state = uav_propagator.getState();
+
+    uav_pos_world = state.p;
+    uavOdomPose = Eigen::Translation3d(state.p) * state.q;
+
+    uav_alan_msg.position.x = state.p.x();
+    uav_alan_msg.position.y = state.p.y();
+    uav_alan_msg.position.z = state.p.z();
+
+    uav_alan_msg.orientation.ow = state.q.w();
+    uav_alan_msg.orientation.ox = state.q.x();
+    uav_alan_msg.orientation.oy = state.q.y();
+    uav_alan_msg.orientation.oz = state.q.z();
+
+    uav_alan_msg.velocity.x = state.v.x();
+    uav_alan_msg.velocity.y = state.v.y();
+    uav_alan_msg.velocity.z = state.v.z();
+
+    // gravity already taken out
+    uav_acc_world = state.acc;
+
+    uav_alan_msg.acceleration.x = uav_acc_world.x();
+    uav_alan_msg.acceleration.y = uav_acc_world.y();
+    uav_alan_msg.acceleration.z = uav_acc_world.z();
+
+    uav_alan_msg.time_stamp = stamp;
+    uav_alan_msg.good2fly = true;
+    uav_alan_msg.frame = "world";
+
+    uav_pub_AlanPlannerMsg.publish(uav_alan_msg);
+
+    if(uav_imu_odom_pub.getNumSubscribers() == 0)
+        return;
+
+    nav_msgs::Odometry odom;
+    odom.header.stamp = stamp;
+    odom.header.frame_id = "world";
+    odom.pose.pose.position.x = state.p.x();
+    odom.pose.pose.position.y = state.p.y();
+    odom.pose.pose.position.z = state.p.z();
+    odom.pose.pose.orientation.w = state.q.w();
+    odom.pose.pose.orientation.x = state.q.x();
+    odom.pose.pose.orientation.y = state.q.y();
+    odom.pose.pose.orientation.z = state.q.z();
+    odom.twist.twist.linear.x = state.v.x();
+    odom.twist.twist.linear.y = state.v.y();
+    odom.twist.twist.linear.z = state.v.z();
+
+    uav_imu_odom_pub.publish(odom);
 }
 
 void alan::MsgSyncNodelet::ugv_vrpn_pose_callback(const geometry_msgs::PoseStamped::ConstPtr& pose)
@@ -323,6 +434,9 @@ void alan::MsgSyncNodelet::ugv_vrpn_pose_callback(const geometry_msgs::PoseStamp
 
         ugv_pub_AlanPlannerMsg.publish(ugv_alan_msg);
 
+        // cam_pos_world is read by the uav vrpn failsafe, the sfc reads uav_pos_world
+        std::lock_guard<std::mutex> lock(uav_state_mutex);
+
         //below for sfc
         camPose = ugvOdomPose * body_to_cam_Pose;
 
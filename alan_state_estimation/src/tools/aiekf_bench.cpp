@@ -0,0 +1,158 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file aiekf_bench.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief offline micro-benchmark of run_AIEKF: per-call latency and heap allocations
+ */
+
+#include "../include/aiekf.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+// every heap allocation in the process goes through here,
+// Eigen's dynamic matrices call malloc() directly, operator new ends up here too (glibc)
+extern "C" void* __libc_malloc(size_t size);
+static std::atomic<long> alloc_no(0);
+
+extern "C" void* malloc(size_t size)
+{
+    alloc_no.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+class benchKF : public kf::aiekf
+{
+public:
+    benchKF()
+    {
+        // same values as launch/configs/alan_pose_estimation.yaml
+        kf_size = 9;
+        kfZ_size = 5;
+        MAX_ITERATION = 25;
+        CONVERGE_THRESHOLD = 0.01;
+        KF_ON = true;
+
+        Q_init.resize(kf_size, kf_size);
+        Q_init.setIdentity();
+        Q_init = Q_init * 0.016;
+
+        R_init.resize(kfZ_size, kfZ_size);
+        R_init.setIdentity();
+        R_init.block<2,2>(0,0) = R_init.block<2,2>(0,0) * 0.008;
+        R_init.block<3,3>(2,2) = R_init.block<3,3>(2,2) * 0.016;
+
+        cameraMat.resize(3,3);
+        cameraMat <<
+            634.0, 0, 424.0,
+            0, 634.0, 240.0,
+            0, 0, 1;
+    };
+};
+
+int main(int argc, char** argv)
+{
+    const int FRAMES = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const int OUTLIER_EVERY = argc > 2 ? std::atoi(argv[2]) : 0;     // one LED off by 72 px every n frames
+    const int WARMUP = 50;
+    const double dt = 1.0 / 60;
+
+    std::vector<Eigen::Vector3d> pts_body = {
+        { 0.055,  0.05, -0.03},
+        { 0.055, -0.05, -0.03},
+        {-0.055,  0.05, -0.03},
+        {-0.055, -0.05, -0.03},
+        { 0.085,  0.00, -0.01},
+        {-0.085,  0.00, -0.01}
+    };
+    std::vector<Eigen::Vector2d> pts_2d(pts_body.size());
+
+    std::default_random_engine rng(1);
+    std::normal_distribution<double> px_noise(0, 0.5);
+
+    benchKF kf;
+
+    // LED board circling 1.5 m in front of the camera
+    auto truth = [&](int k)
+    {
+        const double t = k * dt;
+        return Sophus::SE3d(
+            Eigen::AngleAxisd(0.2 * std::sin(t), Eigen::Vector3d::UnitZ()).toRotationMatrix(),
+            Eigen::Vector3d(0.2 * std::cos(t), 0.1 * std::sin(t), 1.5)
+        );
+    };
+
+    kf.initKF(truth(0));
+
+    std::vector<double> us;
+    us.reserve(FRAMES);
+    long allocs = 0, iterations = 0, rejected = 0;
+    double err = 0;
+
+    for(int k = 1; k <= WARMUP + FRAMES; k++)
+    {
+        const Sophus::SE3d pose = truth(k);
+        for(int i = 0; i < pts_body.size(); i++)
+            pts_2d[i] = kf.reproject_3D_2D(pts_body[i], pose)
+                + Eigen::Vector2d(px_noise(rng), px_noise(rng));
+
+        if(OUTLIER_EVERY > 0 && k % OUTLIER_EVERY == 0)
+            pts_2d[0] += Eigen::Vector2d(60, -40);
+
+        const long a0 = alloc_no.load(std::memory_order_relaxed);
+        auto t0 = std::chrono::steady_clock::now();
+
+        kf.run_AIEKF(dt, pts_body, pts_2d);
+
+        auto t1 = std::chrono::steady_clock::now();
+        const long a1 = alloc_no.load(std::memory_order_relaxed);
+
+        if(k <= WARMUP)
+            continue;
+
+        us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        allocs += a1 - a0;
+        iterations += kf.LM_iterations;
+        rejected += kf.LM_rejected;
+        err += (kf.XcurrentPosterori.X_SE3.translation() - pose.translation()).norm();
+    }
+
+    std::sort(us.begin(), us.end());
+    double mean = 0;
+    for(auto what : us)
+        mean += what;
+    mean /= us.size();
+
+    std::cout<<std::fixed<<std::setprecision(2)
+        <<"run_AIEKF x "<<FRAMES
+        <<(OUTLIER_EVERY > 0 ? ", outlier every " + std::to_string(OUTLIER_EVERY) : "")<<std::endl
+        <<"  mean: "<<mean<<" us"
+        <<" || p50: "<<us[us.size() / 2]<<" us"
+        <<" || p99: "<<us[us.size() * 99 / 100]<<" us"<<std::endl
+        <<"  heap allocations / call: "<<(double)allocs / FRAMES<<std::endl
+        <<"  LM iterations / call: "<<(double)iterations / FRAMES
+        <<" (rejected: "<<(double)rejected / FRAMES<<")"<<std::endl
+        <<std::setprecision(5)
+        <<"  mean position error: "<<err / FRAMES<<" m"<<std::endl;
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file flight_log_export.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief flight log (alan_flight_log/flightLog.hpp) to one csv per stream, or to column files
+ */
+
+/* works on a log that is still being written or that was left behind by a crash,
+records are taken in write order and torn ones are skipped.
+
+    flight_log_export <file.alog> [out_dir] [options]
+        --stream <name>     only this stream, may be repeated
+        --relative          t from the first exported record instead of epoch seconds
+        --columns           <out_dir>/<stream>/<field>.f64, raw little-endian float64
+                            per column (numpy.fromfile), instead of csv */
+
+#include "alan_flight_log/flightLog.hpp"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+static bool makeDir(const std::string& path)
+{
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cerr<<"usage: flight_log_export <file.alog> [out_dir]"
+            <<" [--stream name] [--relative] [--columns]"<<std::endl;
+        return 1;
+    }
+
+    const std::string log_path = argv[1];
+    std::string out_dir = ".";
+    std::vector<std::string> only;
+    bool relative = false;
+    bool columns = false;
+
+    for(int i = 2; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--relative")
+            relative = true;
+        else if(arg == "--columns")
+            columns = true;
+        else if(i + 1 < argc && arg == "--stream")
+            only.push_back(argv[++i]);
+        else if(i == 2 && arg.compare(0, 2, "--") != 0)
+            out_dir = arg;
+        else
+        {
+            std::cerr<<"unknown option "<<arg<<std::endl;
+            return 1;
+        }
+    }
+
+    alan::flightLogReader reader;
+    std::string error;
+    if(!reader.load(log_path, error))
+    {
+        std::cerr<<log_path<<": "<<error<<std::endl;
+        return 1;
+    }
+
+    if(!makeDir(out_dir))
+    {
+        std::cerr<<"cannot create "<<out_dir<<std::endl;
+        return 1;
+    }
+
+    const alan::logHeader& header = *reader.header;
+    std::vector<bool> wanted(header.stream_no, only.empty());
+    for(const std::string& name : only)
+        for(uint32_t s = 0; s < header.stream_no; s++)
+            if(name == header.streams[s].name)
+                wanted[s] = true;
+
+    double t0 = 0;
+    for(const alan::logRecord* record : reader.records)
+        if(wanted[record->stream])
+        {
+            t0 = record->t;
+            break;
+        }
+
+    // one csv, or one file per column, per stream
+    std::vector<std::unique_ptr<std::ofstream>> csv(header.stream_no);
+    std::vector<std::vector<std::unique_ptr<std::ofstream>>> column(header.stream_no);
+    std::vector<long> count(header.stream_no, 0);
+
+    for(uint32_t s = 0; s < header.stream_no; s++)
+    {
+        if(!wanted[s])
+            continue;
+
+        const alan::logStream& stream = header.streams[s];
+        const std::string name = stream.name;
+
+        if(columns)
+        {
+            const std::string dir = out_dir + "/" + name;
+            if(!makeDir(dir))
+            {
+                std::cerr<<"cannot create "<<dir<<std::endl;
+                return 1;
+            }
+
+            column[s].emplace_back(new std::ofstream(dir + "/t.f64", std::ios::binary));
+            for(uint32_t f = 0; f < stream.n; f++)
+                column[s].emplace_back(new std::ofstream(dir + "/" + stream.fields[f] + ".f64", std::ios::binary));
+        }
+        else
+        {
+            csv[s].reset(new std::ofstream(out_dir + "/" + name + ".csv"));
+            *csv[s]<<"t";
+            for(uint32_t f = 0; f < stream.n; f++)
+                *csv[s]<<","<<stream.fields[f];
+            *csv[s]<<"\n"<<std::setprecision(12);
+        }
+    }
+
+    for(const alan::logRecord* record : reader.records)
+    {
+        const uint32_t s = record->stream;
+        if(!wanted[s])
+            continue;
+
+        const double t = relative ? record->t - t0 : record->t;
+        const uint32_t n = header.streams[s].n;
+
+        if(columns)
+        {
+            column[s][0]->write(reinterpret_cast<const char*>(&t), sizeof(double));
+            for(uint32_t f = 0; f < n; f++)
+            {
+                // fields a record did not fill are NaN, not garbage
+                double v = f < record->n ? record->v[f] : std::nan("");
+                column[s][f + 1]->write(reinterpret_cast<const char*>(&v), sizeof(double));
+            }
+        }
+        else
+        {
+            std::ofstream& out = *csv[s];
+            out<<t;
+            for(uint32_t f = 0; f < n; f++)
+            {
+                out<<",";
+                if(f < record->n)
+                    out<<record->v[f];
+            }
+            out<<"\n";
+        }
+
+        count[s]++;
+    }
+
+    std::cout<<log_path<<": "<<reader.records.size()<<" records, ring of "<<header.capacity;
+    if(reader.torn_no)
+        std::cout<<", "<<reader.torn_no<<" torn";
+    std::cout<<std::endl;
+
+    for(uint32_t s = 0; s < header.stream_no; s++)
+        if(wanted[s])
+            std::cout<<"  "<<std::left<<std::setw(alan::LOG_NAME_MAX)<<header.streams[s].name
+                <<count[s]<<std::endl;
+
+    return 0;
+}
@@ -0,0 +1,431 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file led_bench.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief offline replay of recorded rgb/depth pairs through ledTracker: frames/s, per-stage latency, track losses
+ */
+
+/* no ROS master: the "/alan_master" yaml is read with yaml-cpp and handed to
+ledTracker::config() exactly as the nodelet hands over the parameter server.
+frames come from either
+    a directory, <dir>/color/<name>.jpg with <dir>/depth/<name>.png (16-bit, mm),
+    <name> is the stamp in seconds, or any name and --hz
+    a bag, compressed colour and raw depth paired by stamp
+and go through ledTracker::front_end() and ledTracker::estimate() one after
+another, as the nodelet does with PIPELINE_ON false. only those two calls are
+timed, file reading and decoding of the bag are not.
+
+    led_bench <alan_pose_estimation.yaml> <dir | file.bag> [options]
+        --color <topic>     bag colour topic (/camera/color/image_raw/compressed)
+        --depth <topic>     bag depth topic (/camera/aligned_depth_to_color/image_raw)
+        --hz <rate>         directory frame rate when names are not stamps (30)
+        --poses <file.csv>  per-frame posterior, to diff two builds
+        --verbose           keep the ROS_INFO output of the tracker */
+
+#include "../include/ledTracker.h"
+
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <yaml-cpp/yaml.h>
+
+#include <dirent.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+typedef struct benchFrame
+{
+    std::string color_path, depth_path;
+    double stamp = 0;
+}benchFrame;
+
+typedef struct benchStats
+{
+    long frames = 0;
+    long rejected = 0;      // front_end() refused the frame
+    long tracked = 0;
+    long initialized = 0;   // untracked -> tracked
+    long lost = 0;          // tracked -> untracked
+    long stale = 0;
+    uint64_t total_ns = 0;
+    vision::traceHistogram frame_ns;
+}benchStats;
+
+// same typing as rosparam: quoted stays a string, then bool, int, double
+static XmlRpc::XmlRpcValue yamlToXmlRpc(const YAML::Node& node)
+{
+    XmlRpc::XmlRpcValue value;
+
+    switch(node.Type())
+    {
+    case YAML::NodeType::Map:
+        for(auto it = node.begin(); it != node.end(); ++it)
+            value[it->first.as<std::string>()] = yamlToXmlRpc(it->second);
+        break;
+
+    case YAML::NodeType::Sequence:
+        value.setSize(node.size());
+        for(int i = 0; i < (int)node.size(); i++)
+            value[i] = yamlToXmlRpc(node[i]);
+        break;
+
+    case YAML::NodeType::Scalar:
+    {
+        bool b;
+        int n;
+        double d;
+
+        if(node.Tag() == "!")
+            value = node.Scalar();
+        else if(YAML::convert<bool>::decode(node, b))
+            value = b;
+        else if(YAML::convert<int>::decode(node, n))
+            value = n;
+        else if(YAML::convert<double>::decode(node, d))
+            value = d;
+        else
+            value = node.Scalar();
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return value;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>& data)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file)
+        return false;
+
+    data.resize(file.tellg());
+    file.seekg(0);
+    return (bool)file.read((char*)data.data(), data.size());
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// colour frames with a depth frame of the same name, in name order
+static std::vector<benchFrame> listDirectory(const std::string& dir, double hz)
+{
+    std::vector<std::string> names;
+
+    DIR* color_dir = opendir((dir + "/color").c_str());
+    if(!color_dir)
+        return {};
+
+    while(dirent* entry = readdir(color_dir))
+    {
+        const std::string name = entry->d_name;
+        if(endsWith(name, ".jpg") || endsWith(name, ".jpeg"))
+            names.push_back(name);
+    }
+    closedir(color_dir);
+
+    std::sort(names.begin(), names.end());
+
+    std::vector<benchFrame> frames;
+    bool named_by_stamp = true;
+
+    for(auto& name : names)
+    {
+        const std::string stem = name.substr(0, name.rfind('.'));
+
+        benchFrame what;
+        what.color_path = dir + "/color/" + name;
+        what.depth_path = dir + "/depth/" + stem + ".png";
+
+        std::ifstream depth_file(what.depth_path);
+        if(!depth_file)
+            continue;
+
+        char* end;
+        what.stamp = std::strtod(stem.c_str(), &end);
+        named_by_stamp = named_by_stamp && *end == '\0' && end != stem.c_str();
+
+        frames.push_back(what);
+    }
+
+    if(named_by_stamp)
+        std::sort(frames.begin(), frames.end(), [](const benchFrame& a, const benchFrame& b){return a.stamp < b.stamp;});
+    else
+        for(int i = 0; i < frames.size(); i++)
+            frames[i].stamp = i / hz;
+
+    return frames;
+}
+
+static bool loadDirectoryFrame(const benchFrame& what, int seq, alan::ledInput& input)
+{
+    sensor_msgs::CompressedImage::Ptr rgbmsg(new sensor_msgs::CompressedImage);
+    if(!readFile(what.color_path, rgbmsg->data))
+        return false;
+
+    rgbmsg->format = "jpeg";
+    rgbmsg->header.seq = seq;
+    rgbmsg->header.stamp = ros::Time(what.stamp);
+
+    const cv::Mat depth = cv::imread(what.depth_path, cv::IMREAD_UNCHANGED);
+    if(depth.type() != CV_16UC1)
+    {
+        std::cerr<<"NOT A 16-BIT DEPTH IMAGE: "<<what.depth_path<<std::endl;
+        return false;
+    }
+
+    input.rgbmsg = rgbmsg;
+    input.depthmsg = cv_bridge::CvImage(rgbmsg->header, "16UC1", depth).toImageMsg();
+    input.tick = what.stamp;
+    return true;
+}
+
+class benchRunner
+{
+private:
+    alan::ledTracker& tracker;
+    benchStats& stats;
+    std::ofstream* poses;
+
+    alan::ledFrame item;
+    alan::ledReport report;
+    bool tracked_last = false;
+
+public:
+    benchRunner(alan::ledTracker& tracker_, benchStats& stats_, std::ofstream* poses_)
+    : tracker(tracker_), stats(stats_), poses(poses_)
+    {
+        item.pts_2d_detect.reserve(64);
+        item.blobs.reserve(64);
+    };
+
+    void run(const alan::ledInput& input)
+    {
+        const uint64_t t0 = vision::traceNow();
+
+        const bool ok = tracker.front_end(input, item);
+        if(ok)
+            tracker.estimate(item, report);
+
+        const uint64_t t1 = vision::traceNow();
+
+        stats.frames++;
+        stats.total_ns += t1 - t0;
+        stats.frame_ns.add(t1 - t0);
+        tracker.getTracer()->drain();
+
+        if(!ok)
+        {
+            stats.rejected++;
+            return;
+        }
+
+        stats.tracked += report.tracked;
+        stats.initialized += report.tracked && !tracked_last;
+        stats.lost += !report.tracked && tracked_last;
+        stats.stale = report.stale_no;
+        tracked_last = report.tracked;
+
+        if(!poses)
+            return;
+
+        const Eigen::Vector3d t = report.pose.translation();
+        const Eigen::Quaterniond q = report.pose.unit_quaternion();
+
+        (*poses)<<std::fixed<<std::setprecision(6)
+            <<input.rgbmsg->header.stamp.toSec()<<","<<report.tracked<<","
+            <<t.x()<<","<<t.y()<<","<<t.z()<<","
+            <<q.w()<<","<<q.x()<<","<<q.y()<<","<<q.z()<<","
+            <<std::setprecision(3)<<report.BA_error<<","<<report.detect_no<<"\n";
+    }
+};
+
+int main(int argc, char** argv)
+{
+    if(argc < 3)
+    {
+        std::cerr<<"usage: led_bench <alan_pose_estimation.yaml> <dir | file.bag>"
+            <<" [--color topic] [--depth topic] [--hz rate] [--poses file.csv] [--verbose]"<<std::endl;
+        return 1;
+    }
+
+    const std::string config_path = argv[1];
+    const std::string source = argv[2];
+    std::string color_topic = "/camera/color/image_raw/compressed";
+    std::string depth_topic = "/camera/aligned_depth_to_color/image_raw";
+    std::string poses_path;
+    double hz = 30;
+    bool verbose = false;
+
+    for(int i = 3; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if(arg == "--verbose")
+            verbose = true;
+        else if(i + 1 < argc && arg == "--color")
+            color_topic = argv[++i];
+        else if(i + 1 < argc && arg == "--depth")
+            depth_topic = argv[++i];
+        else if(i + 1 < argc && arg == "--hz")
+            hz = std::atof(argv[++i]);
+        else if(i + 1 < argc && arg == "--poses")
+            poses_path = argv[++i];
+        else
+        {
+            std::cerr<<"unknown option "<<arg<<std::endl;
+            return 1;
+        }
+    }
+
+    // per-frame ROS_INFO would be timed as well
+    if(!verbose && ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Error))
+        ros::console::notifyLoggerLevelsChanged();
+
+    YAML::Node config;
+    try
+    {
+        config = YAML::LoadFile(config_path);
+    }
+    catch(const YAML::Exception& e)
+    {
+        std::cerr<<"CANNOT READ "<<config_path<<": "<<e.what()<<std::endl;
+        return 1;
+    }
+
+    alan::ledTracker tracker;
+    if(!tracker.config(alan::masterParams(yamlToXmlRpc(config))))
+        return 1;
+
+    std::ofstream poses_file;
+    if(!poses_path.empty())
+    {
+        poses_file.open(poses_path);
+        poses_file<<"stamp,tracked,x,y,z,qw,qx,qy,qz,BA_error,detect_no\n";
+    }
+
+    benchStats stats;
+    benchRunner runner(tracker, stats, poses_path.empty() ? nullptr : &poses_file);
+
+    if(endsWith(source, ".bag"))
+    {
+        rosbag::Bag bag;
+        try
+        {
+            bag.open(source, rosbag::bagmode::Read);
+        }
+        catch(const rosbag::BagException& e)
+        {
+            std::cerr<<"CANNOT OPEN "<<source<<": "<<e.what()<<std::endl;
+            return 1;
+        }
+
+        // the latest of each, a pair is emitted as soon as the stamps agree
+        const double slop = 0.5 / hz;
+        sensor_msgs::CompressedImage::ConstPtr rgbmsg;
+        sensor_msgs::Image::ConstPtr depthmsg;
+
+        for(const rosbag::MessageInstance& m : rosbag::View(bag, rosbag::TopicQuery({color_topic, depth_topic})))
+        {
+            if(m.getTopic() == color_topic)
+                rgbmsg = m.instantiate<sensor_msgs::CompressedImage>();
+            else
+                depthmsg = m.instantiate<sensor_msgs::Image>();
+
+            if(!rgbmsg || !depthmsg || std::abs((rgbmsg->header.stamp - depthmsg->header.stamp).toSec()) > slop)
+                continue;
+
+            alan::ledInput input;
+            input.rgbmsg = rgbmsg;
+            input.depthmsg = depthmsg;
+            input.tick = rgbmsg->header.stamp.toSec();
+            runner.run(input);
+
+            rgbmsg.reset();
+            depthmsg.reset();
+        }
+    }
+    else
+    {
+        const std::vector<benchFrame> frames = listDirectory(source, hz);
+        if(frames.empty())
+        {
+            std::cerr<<"NO <name>.jpg / <name>.png PAIRS IN "<<source<<"/color, "<<source<<"/depth"<<std::endl;
+            return 1;
+        }
+
+        alan::ledInput input;
+        for(int i = 0; i < frames.size(); i++)
+        {
+            if(!loadDirectoryFrame(frames[i], i, input))
+                continue;
+            runner.run(input);
+        }
+    }
+
+    if(stats.frames == 0)
+    {
+        std::cerr<<"NO FRAME PAIRS IN "<<source<<std::endl;
+        return 1;
+    }
+
+    vision::stageTracer& stage_tracer = *tracker.getTracer();
+    stage_tracer.drain();
+
+    std::cout<<std::fixed<<std::setprecision(1)
+        <<"led_bench: "<<stats.frames<<" frames from "<<source<<std::endl
+        <<"  frames/s: "<<stats.frames / (stats.total_ns * 1e-9)
+        <<" || frame p50: "<<stats.frame_ns.percentile(0.50) * 1e-3<<" us"
+        <<" || p99: "<<stats.frame_ns.percentile(0.99) * 1e-3<<" us"
+        <<" || max: "<<stats.frame_ns.getMax() * 1e-3<<" us"<<std::endl
+        <<"  tracked: "<<stats.tracked<<" / "<<stats.frames
+        <<" || initialized: "<<stats.initialized
+        <<" || lost: "<<stats.lost
+        <<" || stale: "<<stats.stale
+        <<" || rejected: "<<stats.rejected<<std::endl;
+
+    if(!stage_tracer.enabled())
+    {
+        std::cout<<"  no per-stage latency, built without ALAN_TRACE or TRACE_ON false"<<std::endl;
+        return 0;
+    }
+
+    std::cout<<"  stage            count   p50 (us)   p95 (us)   p99 (us)   max (us)"<<std::endl;
+    for(int stage = 0; stage < vision::TRACE_STAGE_NO; stage++)
+    {
+        const vision::traceSummary s = stage_tracer.summary(stage);
+        std::cout<<"  "<<std::left<<std::setw(14)<<vision::traceStageName(stage)<<std::right
+            <<"  "<<std::setw(7)<<s.count
+            <<"  "<<std::setw(9)<<s.p50_us
+            <<"  "<<std::setw(9)<<s.p95_us
+            <<"  "<<std::setw(9)<<s.p99_us
+            <<"  "<<std::setw(9)<<s.max_us<<std::endl;
+    }
+    if(stage_tracer.getLost() > 0)
+        std::cout<<"  lost spans: "<<stage_tracer.getLost()<<std::endl;
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file match_bench.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief offline benchmark of the initial LED correspondence: the old next_permutation search
+ * against constellationMatcher, on 6, 8 and 10 LEDs
+ */
+
+#include "../include/ledMatcher.hpp"
+
+#include <opencv2/calib3d.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+typedef struct benchScene
+{
+    std::vector<Eigen::Vector2d> pts_2d;
+    std::vector<Eigen::Vector3d> pts_3d;
+    std::vector<int> corres_g, corres_r;
+    std::vector<int> truth;             // truth[i]: detection of LED i
+}benchScene;
+
+// the marker in alan_pose_estimation.yaml, then LEDs around it for the larger constellations
+static std::vector<Eigen::Vector3d> setConstellation(int n, std::default_random_engine& rng)
+{
+    std::vector<Eigen::Vector3d> pts = {
+        Eigen::Vector3d(0.0910385, -0.0787805, -0.0411861),
+        Eigen::Vector3d(0.062243, -0.0568124, -0.049127),
+        Eigen::Vector3d(0.0646012, -0.0355463, -0.048906),
+        Eigen::Vector3d(0.0631477, 0.0237785, -0.0121531),
+        Eigen::Vector3d(0.062466, 0.0437234, -0.0491548),
+        Eigen::Vector3d(0.0877848, 0.0719687, -0.0440807)
+    };
+
+    std::uniform_real_distribution<double> yz(-0.09, 0.09);
+    std::uniform_real_distribution<double> x(0.04, 0.10);
+
+    while((int)pts.size() < n)
+    {
+        const Eigen::Vector3d p(x(rng), yz(rng), 0.4 * yz(rng) - 0.03);
+
+        bool apart = true;
+        for(auto& what : pts)
+            apart = apart && (what - p).norm() > 0.02;
+
+        if(apart)
+            pts.push_back(p);
+    }
+
+    pts.resize(n);
+    return pts;
+}
+
+// the LEDs face the camera along +x of the body, detections shuffled
+static benchScene setScene(
+    const std::vector<Eigen::Vector3d>& pts_body,
+    int g_no,
+    const Eigen::Matrix3d& K,
+    std::default_random_engine& rng
+)
+{
+    const int n = pts_body.size();
+
+    std::normal_distribution<double> px_noise(0, 0.5);
+    std::normal_distribution<double> depth_noise(0, 0.005);
+    std::normal_distribution<double> perturb(0, 1);
+    std::uniform_real_distribution<double> range(1.0, 2.5);
+
+    // body x towards the camera, i.e. along -z of the camera
+    Eigen::Matrix3d face;
+    face <<
+        0, 1, 0,
+        0, 0, -1,
+        -1, 0, 0;
+    const Eigen::Matrix3d R =
+        face * Eigen::AngleAxisd(0.3 * perturb(rng), Eigen::Vector3d(perturb(rng), perturb(rng), perturb(rng)).normalized()).toRotationMatrix();
+    const Eigen::Vector3d t(0.2 * perturb(rng), 0.1 * perturb(rng), range(rng));
+
+    benchScene scene;
+    scene.truth.resize(n);
+    std::iota(scene.truth.begin(), scene.truth.end(), 0);
+    std::shuffle(scene.truth.begin(), scene.truth.end(), rng);
+
+    scene.pts_2d.resize(n);
+    scene.pts_3d.resize(n);
+
+    for(int i = 0; i < n; i++)
+    {
+        const Eigen::Vector3d Pc = R * pts_body[i] + t;
+        const int d = scene.truth[i];
+
+        scene.pts_2d[d] = Eigen::Vector2d(K(0,0) * Pc.x() / Pc.z() + K(0,2), K(1,1) * Pc.y() / Pc.z() + K(1,2))
+            + Eigen::Vector2d(px_noise(rng), px_noise(rng));
+        scene.pts_3d[d] = Pc + Eigen::Vector3d(depth_noise(rng), depth_noise(rng), depth_noise(rng));
+
+        (i < g_no ? scene.corres_g : scene.corres_r).push_back(d);
+    }
+
+    std::sort(scene.corres_g.begin(), scene.corres_g.end());
+    std::sort(scene.corres_r.begin(), scene.corres_r.end());
+
+    return scene;
+}
+
+// what LedNodelet::initialization() did before constellationMatcher: a solvePnP per colour-consistent permutation
+static std::vector<int> permutationSearch(
+    const benchScene& scene,
+    const std::vector<Eigen::Vector3d>& pts_body,
+    const cv::Mat& camMat
+)
+{
+    std::vector<int> corres_g = scene.corres_g, corres_r = scene.corres_r;
+    std::vector<int> corres, final_corres;
+    double error_total = INFINITY;
+
+    std::vector<cv::Point3f> pts_3d_;
+    for(auto& what : pts_body)
+        pts_3d_.emplace_back(what.x(), what.y(), what.z());
+
+    std::vector<cv::Point2f> pts_2d_(pts_body.size());
+    std::vector<cv::Point2f> reproject;
+    const cv::Mat distCoeffs = cv::Mat::zeros(5, 1, CV_64F);
+
+    do
+    {
+        do
+        {
+            corres = corres_g;
+            corres.insert(corres.end(), corres_r.begin(), corres_r.end());
+
+            for(size_t i = 0; i < corres.size(); i++)
+                pts_2d_[i] = cv::Point2f(scene.pts_2d[corres[i]].x(), scene.pts_2d[corres[i]].y());
+
+            cv::Vec3d rvec, tvec;
+            cv::solvePnP(pts_3d_, pts_2d_, camMat, distCoeffs, rvec, tvec, false, cv::SOLVEPNP_ITERATIVE);
+            cv::projectPoints(pts_3d_, rvec, tvec, camMat, distCoeffs, reproject);
+
+            double e = 0;
+            for(size_t i = 0; i < corres.size(); i++)
+                e += cv::norm(pts_2d_[i] - reproject[i]);
+
+            if(e < error_total)
+            {
+                error_total = e;
+                final_corres = corres;
+            }
+        } while(std::next_permutation(corres_r.begin(), corres_r.end()));
+    } while(std::next_permutation(corres_g.begin(), corres_g.end()));
+
+    return final_corres;
+}
+
+int main(int argc, char** argv)
+{
+    const int TRIALS = argc > 1 ? std::atoi(argv[1]) : 10;
+    // 10 LEDs are 5! * 5! solvePnPs per trial for the old search, seconds each
+    const int PERM_MAX_LED = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::default_random_engine rng(1);
+
+    Eigen::Matrix3d K;
+    K <<
+        415.87, 0, 423.30,
+        0, 415.57, 248.14,
+        0, 0, 1;
+
+    cv::Mat camMat = cv::Mat::eye(3, 3, CV_64F);
+    camMat.at<double>(0,0) = K(0,0);
+    camMat.at<double>(0,2) = K(0,2);
+    camMat.at<double>(1,1) = K(1,1);
+    camMat.at<double>(1,2) = K(1,2);
+
+    std::cout<<std::fixed<<"LED correspondence x "<<TRIALS<<" per row, 0.5 px and 5 mm noise"<<std::endl
+        <<"  LEDs  permutations  search p50 (ms)  correct  matcher p50 (ms)  p99 (ms)  correct  hypotheses kept"<<std::endl;
+
+    for(int n : {6, 8, 10})
+    {
+        const int g_no = n / 2;
+        const std::vector<Eigen::Vector3d> pts_body = setConstellation(n, rng);
+
+        correspondence::constellationMatcher matcher;
+        matcher.setConstellation(pts_body, g_no, K, 0.02);
+
+        long permutations = 1;
+        for(int k = 2; k <= g_no; k++)
+            permutations *= k;
+        for(int k = 2; k <= n - g_no; k++)
+            permutations *= k;
+
+        std::vector<double> ms_search, ms_matcher;
+        int correct_search = 0, correct_matcher = 0;
+        long kept = 0;
+
+        for(int trial = 0; trial < TRIALS; trial++)
+        {
+            const benchScene scene = setScene(pts_body, g_no, K, rng);
+
+            if(n <= PERM_MAX_LED)
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                const std::vector<int> corres = permutationSearch(scene, pts_body, camMat);
+                auto t1 = std::chrono::steady_clock::now();
+
+                ms_search.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+                correct_search += corres == scene.truth;
+            }
+
+            std::vector<int> corres;
+            double error;
+            Eigen::Matrix3d R;
+            Eigen::Vector3d t;
+            correspondence::matchStats stats;
+
+            auto t0 = std::chrono::steady_clock::now();
+            const bool matched = matcher.match(
+                scene.pts_2d, scene.pts_3d, scene.corres_g, scene.corres_r, corres, error, R, t, &stats
+            );
+            auto t1 = std::chrono::steady_clock::now();
+
+            ms_matcher.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+            correct_matcher += matched && corres == scene.truth;
+            kept += stats.triples_kept;
+        }
+
+        std::sort(ms_search.begin(), ms_search.end());
+        std::sort(ms_matcher.begin(), ms_matcher.end());
+
+        std::cout<<std::setprecision(2)
+            <<"  "<<std::setw(4)<<n
+            <<"  "<<std::setw(12)<<permutations;
+
+        if(ms_search.empty())
+            std::cout<<"  "<<std::setw(15)<<"-"<<"  "<<std::setw(7)<<"-";
+        else
+            std::cout<<"  "<<std::setw(15)<<ms_search[ms_search.size() / 2]
+                <<"  "<<std::setw(3)<<correct_search<<"/"<<std::left<<std::setw(3)<<ms_search.size()<<std::right;
+
+        std::cout
+            <<"  "<<std::setw(16)<<ms_matcher[TRIALS / 2]
+            <<"  "<<std::setw(8)<<ms_matcher[TRIALS * 99 / 100]
+            <<"  "<<std::setw(3)<<correct_matcher<<"/"<<std::left<<std::setw(3)<<TRIALS<<std::right
+            <<"  "<<std::setw(15)<<(double)kept / TRIALS<<std::endl;
+    }
+
+    return 0;
+}
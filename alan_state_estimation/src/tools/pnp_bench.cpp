@@ -0,0 +1,147 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file pnp_bench.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief offline micro-benchmark of poseRefiner: per-solve latency for 4 to 12 points, per kernel
+ */
+
+#include "../include/poseRefine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+typedef struct benchRow
+{
+    std::vector<double> us;
+    long iterations = 0;
+    long converged = 0;
+    double err = 0;
+}benchRow;
+
+int main(int argc, char** argv)
+{
+    const int SOLVES = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const double OUTLIER_PX = argc > 2 ? std::atof(argv[2]) : 0;     // LED 0 moved by this much, 0 for none
+    const int BATCH_NO = 8;
+
+    std::default_random_engine rng(1);
+    std::normal_distribution<double> px_noise(0, 0.5);
+    std::uniform_real_distribution<double> box(-0.1, 0.1);
+    std::normal_distribution<double> perturb(0, 1);
+
+    Eigen::Matrix3d K;
+    K <<
+        634.0, 0, 424.0,
+        0, 634.0, 240.0,
+        0, 0, 1;
+
+    const vision::refineKernel kernels[3] = {vision::KERNEL_NONE, vision::KERNEL_HUBER, vision::KERNEL_CAUCHY};
+    const char* kernel_names[3] = {"none", "huber", "cauchy"};
+
+    vision::poseRefiner refiner;
+    refiner.setCamera(K);
+
+    std::cout<<std::fixed<<std::setprecision(1)<<"poseRefiner x "<<SOLVES<<" per row";
+    if(OUTLIER_PX > 0)
+        std::cout<<", one LED off by "<<OUTLIER_PX<<" px";
+    std::cout<<std::endl
+        <<"  pts  kernel    p50 (us)  p99 (us)  iter   conv %   mean err (mm)   batch of "<<BATCH_NO<<" (us / pose)"<<std::endl;
+
+    for(int n = 4; n <= 12; n++)
+    {
+        std::vector<Eigen::Vector3d> pts_body(n);
+        std::vector<Eigen::Vector2d> pts_2d(n);
+        std::vector<vision::poseCandidate> candidates(BATCH_NO);
+
+        for(int kk = 0; kk < 3; kk++)
+        {
+            refiner.setKernel(kernels[kk], 2.0);
+
+            benchRow row;
+            row.us.reserve(SOLVES);
+            double batch_us = 0;
+
+            for(int s = 0; s < SOLVES; s++)
+            {
+                for(auto& what : pts_body)
+                    what = Eigen::Vector3d(box(rng), box(rng), 0.3 * box(rng));
+
+                const Sophus::SE3d truth(
+                    Eigen::AngleAxisd(0.3 * perturb(rng), Eigen::Vector3d(perturb(rng), perturb(rng), perturb(rng)).normalized()).toRotationMatrix(),
+                    Eigen::Vector3d(0.2 * perturb(rng), 0.1 * perturb(rng), 1.5)
+                );
+
+                for(int i = 0; i < n; i++)
+                {
+                    const Eigen::Vector3d Pc = truth * pts_body[i];
+                    pts_2d[i] = Eigen::Vector2d(K(0,0) * Pc.x() / Pc.z() + K(0,2), K(1,1) * Pc.y() / Pc.z() + K(1,2))
+                        + Eigen::Vector2d(px_noise(rng), px_noise(rng));
+                }
+
+                if(OUTLIER_PX > 0)
+                    pts_2d[0] += Eigen::Vector2d(OUTLIER_PX, -OUTLIER_PX) / std::sqrt(2.0);
+
+                // a P3P-grade start: a few cm and a few degrees off
+                Eigen::Matrix<double, 6, 1> xi;
+                for(int i = 0; i < 6; i++)
+                    xi(i) = (i < 3 ? 0.03 : 0.05) * perturb(rng);
+                Sophus::SE3d pose = Sophus::SE3d::exp(xi) * truth;
+
+                for(auto& what : candidates)
+                {
+                    for(int i = 0; i < 6; i++)
+                        xi(i) = (i < 3 ? 0.03 : 0.05) * perturb(rng);
+                    what.pose = Sophus::SE3d::exp(xi) * truth;
+                }
+
+                auto t0 = std::chrono::steady_clock::now();
+                const vision::refineResult result = refiner.refine(pose, pts_body, pts_2d);
+                auto t1 = std::chrono::steady_clock::now();
+                refiner.refineBatch(candidates.data(), BATCH_NO, pts_body, pts_2d);
+                auto t2 = std::chrono::steady_clock::now();
+
+                row.us.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+                batch_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+                row.iterations += result.iterations;
+                row.converged += result.status == vision::REFINE_CONVERGED;
+                row.err += (pose.translation() - truth.translation()).norm();
+            }
+
+            std::sort(row.us.begin(), row.us.end());
+
+            std::cout<<std::setprecision(2)
+                <<"  "<<std::setw(3)<<n
+                <<"  "<<std::left<<std::setw(8)<<kernel_names[kk]<<std::right
+                <<"  "<<std::setw(8)<<row.us[SOLVES / 2]
+                <<"  "<<std::setw(8)<<row.us[SOLVES * 99 / 100]
+                <<"  "<<std::setw(4)<<(double)row.iterations / SOLVES
+                <<"  "<<std::setw(7)<<100.0 * row.converged / SOLVES
+                <<"  "<<std::setw(14)<<1000 * row.err / SOLVES
+                <<"  "<<std::setw(10)<<batch_us / SOLVES / BATCH_NO<<std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file test_led_association.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief gatedAssigner against an exhaustive search over every partial assignment
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/include/ledAssociation.hpp"
+
+#include <random>
+
+namespace
+{
+    // d^2 of LED i to detection j, as assign() computes it for an isotropic S
+    double getD2(
+        const Eigen::Vector2d& pred,
+        const Eigen::Vector2d& detected,
+        double var
+    )
+    {
+        return (detected - pred).squaredNorm() / var;
+    }
+
+    // min over all injective LED -> detection maps of sum d^2, gate_chi2 per unmatched LED
+    double bruteForce(
+        int i,
+        const std::vector<Eigen::Vector2d>& pred,
+        const std::vector<Eigen::Vector2d>& detected,
+        double var,
+        double gate_chi2,
+        std::vector<bool>& used
+    )
+    {
+        if(i == (int)pred.size())
+            return 0;
+
+        double best = gate_chi2 + bruteForce(i + 1, pred, detected, var, gate_chi2, used);
+
+        for(int j = 0; j < (int)detected.size(); j++)
+        {
+            if(used[j])
+                continue;
+
+            const double d2 = getD2(pred[i], detected[j], var);
+            if(d2 > gate_chi2)
+                continue;
+
+            used[j] = true;
+            best = std::min(best, d2 + bruteForce(i + 1, pred, detected, var, gate_chi2, used));
+            used[j] = false;
+        }
+
+        return best;
+    }
+}
+
+TEST(ledAssociation, assignIsTheExhaustiveOptimum)
+{
+    std::mt19937 rng(20261018);
+    std::uniform_real_distribution<double> pixel(0, 60);
+    std::normal_distribution<double> noise(0, 3);
+
+    correspondence::gatedAssigner assigner;
+    const double sigma = 2.0;
+    const Eigen::Matrix2d S = Eigen::Matrix2d::Identity() * sigma * sigma;
+    const double var = sigma * sigma + assigner.px_floor * assigner.px_floor;
+
+    for(int trial = 0; trial < 2000; trial++)
+    {
+        const int n = 1 + rng() % 6;
+        const int m = rng() % 8;
+
+        // crowded on purpose, so gates overlap and greedy picks lose
+        std::vector<Eigen::Vector2d> pred(n), detected(m);
+        for(auto& what : pred)
+            what = Eigen::Vector2d(pixel(rng), pixel(rng)) / 3;
+        for(int j = 0; j < m; j++)
+            detected[j] = j < n && rng() % 4
+                ? Eigen::Vector2d(pred[j] + Eigen::Vector2d(noise(rng), noise(rng)))
+                : Eigen::Vector2d(pixel(rng), pixel(rng)) / 3;
+
+        assigner.begin(n);
+        for(int i = 0; i < n; i++)
+            assigner.setPrediction(i, pred[i], S);
+
+        const int matched_no = assigner.assign(detected, false);
+
+        double total = 0;
+        int counted = 0;
+        std::vector<bool> taken(m, false);
+
+        for(int i = 0; i < n; i++)
+        {
+            if(assigner.match[i] < 0)
+            {
+                total += assigner.gate_chi2;
+                continue;
+            }
+
+            const int j = assigner.match[i];
+            ASSERT_LT(j, m);
+            ASSERT_FALSE(taken[j]) << "detection " << j << " matched twice, trial " << trial;
+            taken[j] = true;
+
+            const double d2 = getD2(pred[i], detected[j], var);
+            ASSERT_LE(d2, assigner.gate_chi2 + 1e-9);
+            EXPECT_NEAR(d2, assigner.mahalanobis[i], 1e-9);
+            EXPECT_NEAR(std::exp(-0.5 * d2), assigner.confidence[i], 1e-12);
+
+            total += d2;
+            counted++;
+        }
+
+        EXPECT_EQ(counted, matched_no);
+
+        std::vector<bool> used(m, false);
+        EXPECT_NEAR(bruteForce(0, pred, detected, var, assigner.gate_chi2, used), total, 1e-9)
+            << "trial " << trial << ", " << n << " LEDs, " << m << " detections";
+    }
+}
+
+TEST(ledAssociation, alignedCentroidUndoesACommonShift)
+{
+    correspondence::gatedAssigner assigner;
+    const Eigen::Vector2d offset(200, -150);
+
+    std::vector<Eigen::Vector2d> pred = {
+        Eigen::Vector2d(100, 100), Eigen::Vector2d(130, 104), Eigen::Vector2d(115, 140),
+        Eigen::Vector2d(90, 125), Eigen::Vector2d(140, 130), Eigen::Vector2d(120, 112)
+    };
+
+    // shuffled, and far outside every gate until the shift is taken out
+    std::vector<Eigen::Vector2d> detected;
+    for(int i : {3, 0, 5, 1, 4, 2})
+        detected.push_back(pred[i] + offset);
+
+    assigner.begin(pred.size());
+    for(int i = 0; i < (int)pred.size(); i++)
+        assigner.setPrediction(i, pred[i], Eigen::Matrix2d::Identity());
+
+    EXPECT_EQ(0, assigner.assign(detected, false));
+    EXPECT_EQ((int)pred.size(), assigner.assign(detected, true));
+
+    const int order[] = {1, 3, 5, 0, 4, 2};
+    for(int i = 0; i < (int)pred.size(); i++)
+        EXPECT_EQ(order[i], assigner.match[i]);
+
+    EXPECT_NEAR(offset.x(), assigner.shift.x(), 1e-9);
+    EXPECT_NEAR(offset.y(), assigner.shift.y(), 1e-9);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,244 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file test_led_blob.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief ledBlobExtractor against a brute-force 8-connected flood fill, and its blobs
+ * on a DCT-scaled frame against the full one
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/include/ledBlob.hpp"
+
+#include <random>
+
+namespace
+{
+    // the runs of a mask, row by row, left to right, as segmentLED() emits them
+    std::vector<vision::segRun> getRuns(const std::vector<uchar>& mask, int width, int height)
+    {
+        std::vector<vision::segRun> runs;
+
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++)
+            {
+                if(!mask[y * width + x] || (x > 0 && mask[y * width + x - 1]))
+                    continue;
+
+                int x_end = x;
+                while(x_end < width && mask[y * width + x_end])
+                    x_end++;
+
+                runs.push_back({y, x, x_end});
+            }
+
+        return runs;
+    }
+
+    // components in raster order of their first pixel, the order extract() keeps
+    std::vector<vision::ledBlob> floodFill(
+        const std::vector<uchar>& mask,
+        const cv::Mat& bgr,
+        int width,
+        int height,
+        int min_area
+    )
+    {
+        std::vector<vision::ledBlob> blobs;
+        std::vector<bool> visited(mask.size(), false);
+        std::vector<int> stack;
+
+        for(int start = 0; start < (int)mask.size(); start++)
+        {
+            if(!mask[start] || visited[start])
+                continue;
+
+            vision::ledBlob blob;
+            int x_min = width, y_min = height, x_max = -1, y_max = -1;
+            double sum_x = 0, sum_y = 0;
+
+            visited[start] = true;
+            stack.push_back(start);
+
+            while(!stack.empty())
+            {
+                const int i = stack.back();
+                stack.pop_back();
+
+                const int x = i % width, y = i / width;
+                const uchar* px = bgr.ptr<uchar>(y) + 3 * x;
+                const double w = (1868 * px[0] + 9617 * px[1] + 4899 * px[2] + 8192) >> 14;
+
+                blob.area++;
+                blob.sum_w += w;
+                blob.sum_wx += w * x;
+                blob.sum_wy += w * y;
+                sum_x += x;
+                sum_y += y;
+                x_min = std::min(x_min, x);
+                y_min = std::min(y_min, y);
+                x_max = std::max(x_max, x);
+                y_max = std::max(y_max, y);
+
+                for(int dy = -1; dy <= 1; dy++)
+                    for(int dx = -1; dx <= 1; dx++)
+                    {
+                        const int xn = x + dx, yn = y + dy;
+                        if(xn < 0 || xn >= width || yn < 0 || yn >= height)
+                            continue;
+
+                        const int n = yn * width + xn;
+                        if(mask[n] && !visited[n])
+                        {
+                            visited[n] = true;
+                            stack.push_back(n);
+                        }
+                    }
+            }
+
+            if(blob.area < min_area)
+                continue;
+
+            blob.x = blob.sum_w > 0 ? blob.sum_wx / blob.sum_w : sum_x / blob.area;
+            blob.y = blob.sum_w > 0 ? blob.sum_wy / blob.sum_w : sum_y / blob.area;
+            blob.bbox = cv::Rect(x_min, y_min, x_max - x_min + 1, y_max - y_min + 1);
+            blobs.push_back(blob);
+        }
+
+        return blobs;
+    }
+}
+
+TEST(ledBlob, extractMatchesFloodFill)
+{
+    std::mt19937 rng(20261018);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    vision::ledBlobExtractor extractor;
+    std::vector<vision::ledBlob> blobs;
+
+    for(int trial = 0; trial < 500; trial++)
+    {
+        const int width = 1 + rng() % 40, height = 1 + rng() % 30;
+
+        // sparse to nearly full, diagonal-only contacts included
+        std::bernoulli_distribution lit((trial % 10 + 1) / 12.0);
+
+        std::vector<uchar> mask(width * height);
+        for(auto& what : mask)
+            what = lit(rng);
+
+        // some all-black pixels, whose blobs fall back to the plain mean
+        cv::Mat bgr;
+        bgr.create(cv::Size{width, height}, CV_8UC3);
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < 3 * width; x++)
+                bgr.ptr<uchar>(y)[x] = trial % 7 == 0 ? 0 : byte(rng);
+
+        extractor.min_area = 1 + trial % 3;
+        extractor.extract(getRuns(mask, width, height), bgr, blobs);
+
+        const std::vector<vision::ledBlob> expected = floodFill(mask, bgr, width, height, extractor.min_area);
+
+        ASSERT_EQ(expected.size(), blobs.size()) << "trial " << trial;
+
+        for(int k = 0; k < (int)blobs.size(); k++)
+        {
+            EXPECT_EQ(expected[k].area, blobs[k].area) << "trial " << trial << " blob " << k;
+            EXPECT_EQ(expected[k].bbox.x, blobs[k].bbox.x);
+            EXPECT_EQ(expected[k].bbox.y, blobs[k].bbox.y);
+            EXPECT_EQ(expected[k].bbox.width, blobs[k].bbox.width);
+            EXPECT_EQ(expected[k].bbox.height, blobs[k].bbox.height);
+            EXPECT_NEAR(expected[k].x, blobs[k].x, 1e-9);
+            EXPECT_NEAR(expected[k].y, blobs[k].y, 1e-9);
+        }
+    }
+}
+
+TEST(ledBlob, upscaledBlobsMatchTheFullFrame)
+{
+    std::mt19937 rng(20261018);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::bernoulli_distribution lit(0.3);
+
+    vision::ledBlobExtractor extractor;
+    std::vector<vision::ledBlob> blobs_scaled, blobs_full;
+
+    for(int scale : {2, 4, 8})
+        for(int trial = 0; trial < 100; trial++)
+        {
+            const int width = 1 + rng() % 20, height = 1 + rng() % 15;
+            const int width_full = width * scale, height_full = height * scale;
+
+            // the full frame is the scaled one with every pixel a scale x scale block
+            std::vector<uchar> mask(width * height), mask_full(width_full * height_full);
+            cv::Mat bgr, bgr_full;
+            bgr.create(cv::Size{width, height}, CV_8UC3);
+            bgr_full.create(cv::Size{width_full, height_full}, CV_8UC3);
+
+            for(int y = 0; y < height; y++)
+                for(int x = 0; x < width; x++)
+                {
+                    mask[y * width + x] = lit(rng);
+                    for(int c = 0; c < 3; c++)
+                        bgr.ptr<uchar>(y)[3 * x + c] = byte(rng);
+                }
+
+            for(int y = 0; y < height_full; y++)
+                for(int x = 0; x < width_full; x++)
+                {
+                    mask_full[y * width_full + x] = mask[(y / scale) * width + x / scale];
+                    for(int c = 0; c < 3; c++)
+                        bgr_full.ptr<uchar>(y)[3 * x + c] = bgr.ptr<uchar>(y / scale)[3 * (x / scale) + c];
+                }
+
+            extractor.extract(getRuns(mask, width, height), bgr, blobs_scaled);
+            extractor.extract(getRuns(mask_full, width_full, height_full), bgr_full, blobs_full);
+
+            ASSERT_EQ(blobs_full.size(), blobs_scaled.size());
+
+            for(int k = 0; k < (int)blobs_full.size(); k++)
+            {
+                const vision::ledBlob up = vision::upscaleBlob(blobs_scaled[k], scale);
+
+                EXPECT_EQ(blobs_full[k].area, up.area) << "scale " << scale << " trial " << trial;
+                EXPECT_EQ(blobs_full[k].bbox.x, up.bbox.x);
+                EXPECT_EQ(blobs_full[k].bbox.y, up.bbox.y);
+                EXPECT_EQ(blobs_full[k].bbox.width, up.bbox.width);
+                EXPECT_EQ(blobs_full[k].bbox.height, up.bbox.height);
+                EXPECT_NEAR(blobs_full[k].x, up.x, 1e-9);
+                EXPECT_NEAR(blobs_full[k].y, up.y, 1e-9);
+                EXPECT_NEAR(blobs_full[k].size, up.size, 1e-9);
+
+                // and back, where the colour of the blob is read
+                const vision::ledBlob down = vision::downscaleBlob(up, scale);
+                EXPECT_NEAR(blobs_scaled[k].x, down.x, 1e-9);
+                EXPECT_NEAR(blobs_scaled[k].y, down.y, 1e-9);
+                EXPECT_NEAR(blobs_scaled[k].size, down.size, 1e-9);
+            }
+        }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,198 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file test_led_segmentation.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief every compiled-in segmentRow variant against the scalar reference, bit for bit
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/include/ledSegmentation.hpp"
+
+#include <array>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+    // variants built in and runnable on this cpu, the scalar reference excluded
+    std::vector<int> getVariants()
+    {
+        std::vector<int> variants;
+#if LEDSEG_X86
+        if(__builtin_cpu_supports("ssse3"))
+            variants.push_back(vision::SEG_SSSE3);
+        if(__builtin_cpu_supports("avx2"))
+            variants.push_back(vision::SEG_AVX2);
+#endif
+#if LEDSEG_NEON
+        variants.push_back(vision::SEG_NEON);
+#endif
+        return variants;
+    }
+
+    std::string getVariantName(int simd)
+    {
+        switch (simd)
+        {
+        case vision::SEG_SSSE3: return "SSSE3";
+        case vision::SEG_AVX2: return "AVX2";
+        case vision::SEG_NEON: return "NEON";
+        default: return "SCALAR";
+        }
+    }
+
+    int32_t getWeighted(int b, int g, int r)
+    {
+        return 1868 * b + 9617 * g + 4899 * r + 8192;
+    }
+
+    /* for every b, g the two r on either side of the brightness gate; where
+    limit - 8192 - 1868 b - 9617 g is a multiple of 4899 (or one past it) the
+    lower one lands exactly on the limit (or one below it) */
+    std::vector<std::array<uchar, 3>> getEdgePixels(const vision::segParam& param)
+    {
+        std::vector<std::array<uchar, 3>> pixels;
+
+        for(int b = 0; b < 256; b++)
+            for(int g = 0; g < 256; g++)
+            {
+                const int32_t rest = param.gray_limit - getWeighted(b, g, 0);
+                const int r_low = rest >= 0 ? rest / 4899 : -((-rest + 4898) / 4899);
+
+                for(int r = r_low; r <= r_low + 1; r++)
+                    if(r >= 0 && r < 256)
+                        pixels.push_back({(uchar)b, (uchar)g, (uchar)r});
+            }
+
+        return pixels;
+    }
+
+    void compareRows(
+        const vision::segParam& param,
+        const std::vector<std::array<uchar, 3>>& edge_pixels,
+        std::mt19937& rng
+    )
+    {
+        const std::vector<int> variants = getVariants();
+        const uint16_t far = param.depth_far;
+        const uint16_t depth_edges[] = {
+            0, 1,
+            (uint16_t)(far > 0 ? far - 1 : 0), far, (uint16_t)(far < 65535 ? far + 1 : far),
+            32767, 32768, 65535
+        };
+
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::uniform_int_distribution<int> word(0, 65535);
+        std::uniform_int_distribution<int> pick(0, 3);
+
+        // every tail length of the 16 and 32 pixel loops, and a full frame row
+        std::vector<int> widths;
+        for(int n = 0; n <= 97; n++)
+            widths.push_back(n);
+        widths.push_back(848);
+
+        for(int n : widths)
+        {
+            // one spare pixel each side, a variant must not write past n
+            std::vector<uchar> bgr(3 * (n + 1));
+            std::vector<uint16_t> depth(n + 1);
+
+            for(int trial = 0; trial < 8; trial++)
+            {
+                for(int x = 0; x < n; x++)
+                {
+                    if(edge_pixels.empty() || pick(rng) == 0)
+                        for(int c = 0; c < 3; c++)
+                            bgr[3 * x + c] = byte(rng);
+                    else
+                    {
+                        const auto& edge = edge_pixels[rng() % edge_pixels.size()];
+                        for(int c = 0; c < 3; c++)
+                            bgr[3 * x + c] = edge[c];
+                    }
+
+                    depth[x] = pick(rng) == 0
+                        ? (uint16_t)word(rng)
+                        : depth_edges[rng() % (sizeof(depth_edges) / sizeof(depth_edges[0]))];
+                }
+
+                std::vector<uchar> reference(n + 1, 0x5A);
+                vision::segmentRowScalar(bgr.data(), depth.data(), reference.data(), n, param);
+
+                for(int simd : variants)
+                {
+                    std::vector<uchar> mask(n + 1, 0x5A);
+                    vision::segmentRow(bgr.data(), depth.data(), mask.data(), n, param, simd);
+
+                    ASSERT_EQ(reference, mask)
+                        << getVariantName(simd) << " width " << n
+                        << " depth_far " << param.depth_far
+                        << " gray_limit " << param.gray_limit
+                        << " reject_zero " << param.reject_zero_depth;
+                }
+            }
+        }
+    }
+}
+
+TEST(ledSegmentation, edgePixelsStraddleTheGate)
+{
+    const vision::segParam param = vision::setSegParam(2.0, 20, true);
+    const std::vector<std::array<uchar, 3>> pixels = getEdgePixels(param);
+
+    bool below = false, at = false;
+    for(const auto& px : pixels)
+    {
+        const int32_t weighted = getWeighted(px[0], px[1], px[2]);
+        below = below || weighted == param.gray_limit - 1;
+        at = at || weighted == param.gray_limit;
+    }
+
+    EXPECT_TRUE(below);
+    EXPECT_TRUE(at);
+}
+
+TEST(ledSegmentation, variantsMatchScalar)
+{
+    std::mt19937 rng(20261018);
+
+    for(double distance : {0.0, 2.0, 65.535, 100.0})
+        for(int thres : {-1, 0, 20, 128, 254, 255})
+            for(bool reject_zero : {true, false})
+            {
+                const vision::segParam param = vision::setSegParam(distance, thres, reject_zero);
+                compareRows(param, getEdgePixels(param), rng);
+            }
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+
+    std::cout << "segmentRow variants on this cpu:";
+    for(int simd : getVariants())
+        std::cout << " " << getVariantName(simd);
+    std::cout << std::endl;
+
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+/*
+    This file is part of ALan - the non-robocentric dynamic landing system for quadrotor
+
+    ALan is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    ALan is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with ALan.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * \file test_spsc_ring.cpp
+ * \date 18/10/2026
+ * \author pattylo
+ * \copyright (c) AIRO-LAB, RCUAS of Hong Kong Polytechnic University
+ * \brief spscRing order, drop accounting and buffer recycling, on one thread and across two
+ */
+
+#include <gtest/gtest.h>
+
+#include "../src/include/tools/spscRing.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // a sequence number, plus a buffer that has to keep circulating
+    typedef struct ringItem
+    {
+        long no = -1;
+        std::vector<long> payload;
+    }ringItem;
+
+    template<int N>
+    void runTwoThreads(long item_no)
+    {
+        vision::spscRing<ringItem, N> ring;
+        std::atomic<bool> done(false);
+
+        std::thread producer([&]()
+        {
+            ringItem item;
+            for(long k = 0; k < item_no; k++)
+            {
+                item.no = k;
+                item.payload.assign(4, k);
+                ring.push(item);
+            }
+
+            done.store(true);
+            ring.wake();
+        });
+
+        long last = -1, popped = 0;
+        bool in_order = true, intact = true;
+        ringItem item;
+
+        for(;;)
+        {
+            const bool finished = done.load();
+
+            if(ring.popWait(item, 10))
+            {
+                in_order = in_order && item.no > last;
+                intact = intact && item.payload == std::vector<long>(4, item.no);
+                last = item.no;
+                popped++;
+                continue;
+            }
+
+            // empty after the producer finished, nothing can still arrive
+            if(finished)
+                break;
+        }
+
+        producer.join();
+
+        EXPECT_TRUE(in_order) << "ring of " << N;
+        EXPECT_TRUE(intact) << "ring of " << N;
+        EXPECT_EQ(item_no - 1, last) << "the newest item is never dropped";
+        EXPECT_EQ(item_no, ring.getPushed());
+        EXPECT_EQ(item_no, popped + ring.getDropped()) << "ring of " << N;
+    }
+}
+
+TEST(spscRing, fullRingKeepsTheNewest)
+{
+    vision::spscRing<ringItem, 4> ring;
+    ringItem item;
+
+    for(long k = 0; k < 10; k++)
+    {
+        item.no = k;
+        EXPECT_EQ(k < 4, ring.push(item)) << "push " << k;
+    }
+
+    EXPECT_EQ(6, ring.getDropped());
+
+    for(long k = 6; k < 10; k++)
+    {
+        ASSERT_TRUE(ring.pop(item));
+        EXPECT_EQ(k, item.no);
+    }
+
+    EXPECT_FALSE(ring.pop(item));
+    EXPECT_FALSE(ring.popWait(item, 1));
+}
+
+TEST(spscRing, buffersCirculate)
+{
+    vision::spscRing<ringItem, 4> ring;
+    ringItem item, out;
+    std::vector<const long*> buffers;
+
+    // the producer refills whatever push() handed back, the consumer pops into one item;
+    // the ring's slots plus those two are all the buffers there ever are
+    for(long k = 0; k < 100; k++)
+    {
+        item.no = k;
+        item.payload.assign(4, k);
+        ring.push(item);
+
+        if(k % 3 == 0)
+            continue;
+
+        ASSERT_TRUE(ring.pop(out));
+
+        if(std::find(buffers.begin(), buffers.end(), out.payload.data()) == buffers.end())
+            buffers.push_back(out.payload.data());
+    }
+
+    EXPECT_LE(buffers.size(), 4u + 2u);
+}
+
+TEST(spscRing, twoThreadsThroughWrapAround)
+{
+    runTwoThreads<2>(300000);
+    runTwoThreads<4>(300000);
+    runTwoThreads<8>(300000);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
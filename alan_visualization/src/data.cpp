@@ -30,10 +30,12 @@
 #include <message_filters/sync_policies/exact_time.h>
 
 #include "alan_state_estimation/alan_log.h"
+#include "alan_flight_log/flightStreams.hpp"
 
-static std::string log_file_1;
-static std::string log_file_2;
-static double starting_time;
+// one binary flight log instead of two csv files reopened per message,
+// rosrun alan_state_estimation flight_log_export <file> --relative gives the csv back
+static alan::flightLog flight_log;
+static int log_led = -1, log_uav = -1;
 static geometry_msgs::PoseStamped ugv_pose;
 
 void ugv_callback(
@@ -48,46 +50,26 @@ void msg_callback(
     const alan_state_estimation::alan_log::ConstPtr& uavmsg
 )
 {    
-    std::ofstream save(log_file_1, std::ios::app);
-    // save<<"x,y,z,r,p,y,ori,ms,dpth,t"<<std::endl;
-    save << ledmsg->px << "," 
-         << ledmsg->py << "," 
-         << ledmsg->pz << ","
-         << ledmsg->set_px << ","
-         << ledmsg->set_py << ","
-         << ledmsg->set_pz << ","
-         << ledmsg->roll  << ","
-         << ledmsg->pitch << ","
-         << ledmsg->yaw   << ","
-         << ledmsg->orientation << ","
-         << ledmsg->ms << ","
-         << ledmsg->depth << ","
-         << ledmsg->header.stamp.now().toSec() - starting_time << "," 
-         << ugv_pose.pose.position.x << ","
-         << ugv_pose.pose.position.y << "," 
-         << ugv_pose.pose.position.z << "," 
-         << ledmsg->vx << "," 
-         << ledmsg->vy << "," 
-         << ledmsg->vz << "," << std::endl;
-    save.close();
-
-
-    save = std::ofstream(log_file_2, std::ios::app);
-    // save<<"x,y,z,r,p,y,ori,ms,dpth,t"<<std::endl;
-    save << uavmsg->px << "," 
-         << uavmsg->py << "," 
-         << uavmsg->pz << ","
-         << uavmsg->roll  << ","
-         << uavmsg->pitch << ","
-         << uavmsg->yaw   << ","
-         << uavmsg->orientation << ","
-         << uavmsg->ms << ","
-         << uavmsg->depth << ","
-         << ledmsg->header.stamp.now().toSec() - starting_time << "," << std::endl;
-    
-    save.close();
-
-
+    const double t = ledmsg->header.stamp.toSec();
+
+    flight_log.write(log_led, t, {
+        ledmsg->px, ledmsg->py, ledmsg->pz,
+        ledmsg->set_px, ledmsg->set_py, ledmsg->set_pz,
+        ledmsg->roll, ledmsg->pitch, ledmsg->yaw,
+        ledmsg->orientation,
+        ledmsg->ms,
+        ledmsg->depth,
+        ugv_pose.pose.position.x, ugv_pose.pose.position.y, ugv_pose.pose.position.z,
+        ledmsg->vx, ledmsg->vy, ledmsg->vz
+    });
+
+    flight_log.write(log_uav, t, {
+        uavmsg->px, uavmsg->py, uavmsg->pz,
+        uavmsg->roll, uavmsg->pitch, uavmsg->yaw,
+        uavmsg->orientation,
+        uavmsg->ms,
+        uavmsg->depth
+    });
 }
 
 int main(int argc, char** argv)
@@ -101,49 +83,37 @@ int main(int argc, char** argv)
     typedef message_filters::Synchronizer<MySyncPolicy> sync;//(MySyncPolicy(10), subimage, subdepth);
     boost::shared_ptr<sync> sync_;   
 
-    subled.subscribe(nh, "/alan_state_estimation/led/led_log", 1);                
-    subuav.subscribe(nh, "/alan_state_estimation/led/uav_log", 1);                
-    sync_.reset(new sync( MySyncPolicy(10), subled, subuav));
-    sync_->registerCallback(boost::bind(&msg_callback, _1, _2));   
-
-    ros::Subscriber ugv_sub = 
-        nh.subscribe<geometry_msgs::PoseStamped>("/vrpn_client_node/gh034_car/pose", 1, ugv_callback);
-
     std::string path;
     std::string filename;
+    int capacity = 1 << 18;
 
-//// led path
     nh.getParam("/data/log_path", path);
-    nh.getParam("/data/filename1", filename);
-    log_file_1 = path + filename;
+    nh.getParam("/data/filename", filename);
+    nh.getParam("/data/capacity", capacity);
 
-    remove(log_file_1.c_str());
+    log_led = alan::addLEDStream(flight_log);
+    log_uav = alan::addUAVStream(flight_log);
 
-    std::cout<<log_file_1<<std::endl;
+    const std::string log_file = path + filename;
+    if(!flight_log.open(log_file, capacity))
+    {
+        ROS_ERROR_STREAM("cannot open " << log_file);
+        return 1;
+    }
 
-    std::ofstream save(log_file_1, std::ios::app);
-    save<<filename<<std::endl;
-    save<<"x,y,z,st_x,st_y,st_z,r,p,y,ori,ms,dpth,t,ugvx,ugvy,ugvz,vx,vy,vz,"<<std::endl;
-    save.close();
+    std::cout<<log_file<<std::endl;
 
-//// uav path
-    nh.getParam("/data/log_path", path);
-    nh.getParam("/data/filename2", filename);
-    log_file_2 = path + filename;
-
-    remove(log_file_2.c_str());
-
-    std::cout<<log_file_2<<std::endl;
-
-    save = std::ofstream(log_file_2, std::ios::app);
-    save<<filename<<std::endl;
-    save<<"x,y,z,r,p,y,ori,ms,dpth,t"<<std::endl;
-    save.close();
-     
+    subled.subscribe(nh, "/alan_state_estimation/led/led_log", 1);                
+    subuav.subscribe(nh, "/alan_state_estimation/led/uav_log", 1);                
+    sync_.reset(new sync( MySyncPolicy(10), subled, subuav));
+    sync_->registerCallback(boost::bind(&msg_callback, _1, _2));   
 
-    starting_time = ros::Time::now().toSec();                        
+    ros::Subscriber ugv_sub = 
+        nh.subscribe<geometry_msgs::PoseStamped>("/vrpn_client_node/gh034_car/pose", 1, ugv_callback);
 
     ros::spin();
+
+    flight_log.close();
     return 0;
 
 }
\ No newline at end of file